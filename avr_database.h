@@ -7,7 +7,7 @@
 #define	AVR_DATABASE_H
 
 #define AVR_FLAG_SUPPORTED (1 << 0)
-#define AVR_FLAG_FUSE_EXTENDED (1 << 1)
+#define AVR_FLAG_FUSE_EXTENDED (1 << 1)       /* Extended fuse byte, read and written with BS2 */
 
 typedef const struct {
     const uint32_t signature;
@@ -21,8 +21,20 @@ typedef const struct {
     const char* const* fuse_high_map;
     const char* const* fuse_extended_map;
     const char* const* lock_map;
+    /* Memory geometry, no padding is inserted on AVR */
+    const uint8_t flash_page_words;
+    const uint16_t flash_pages;
+    const uint8_t eeprom_page_size;     /* Bytes */
+    const uint16_t eeprom_size;         /* Bytes */
 } avr_record;
 
+/* Flash and EEPROM geometry of a record, in the order of avr_record fields */
+#define AVR_GEOMETRY(flash_page_words, flash_pages, eeprom_page_size, eeprom_size) \
+    flash_page_words, flash_pages, eeprom_page_size, eeprom_size
+
+#define AVR_FLASH_WORDS(record) ((uint32_t) (record)->flash_page_words * (record)->flash_pages)
+#define AVR_FLASH_SIZE(record) (2 * AVR_FLASH_WORDS(record))
+
 /* ATmega 48A/48PA has no separate Boot Loader section */
 static const char* const avr_base_lock[] = {
     "LB1", "LB2", NULL, NULL, NULL, NULL, NULL, NULL
@@ -84,124 +96,89 @@ static const char* const avr_megaX4_fuse_high[] = {
     "BOOTRST", "BOOTSZ0", "BOOTSZ1", "EESAVE", "WDTON", "SPIEN", "JTAGEN", "OCDEN",
 };
 #define avr_megaX4_fuse_low avr_mega48a_fuse_low
+
+#define avr_mega8_definition \
+    AVR_FLAG_SUPPORTED, \
+    0xE1, 0xD9, 0xFF, 0xFF, \
+    avr_mega8_fuse_low, avr_mega8_fuse_high, NULL, avr_std_lock
+#define avr_mega16_definition \
+    AVR_FLAG_SUPPORTED, \
+    0xE1, 0x99, 0xFF, 0xFF, \
+    avr_mega16_fuse_low, avr_mega16_fuse_high, NULL, avr_std_lock
+#define avr_mega32_definition \
+    AVR_FLAG_SUPPORTED, \
+    0xE1, 0x99, 0xFF, 0xFF, \
+    avr_mega32_fuse_low, avr_mega32_fuse_high, NULL, avr_std_lock
+#define avr_mega48a_definition \
+    AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, \
+    0x62, 0xDF, 0xFF, 0xFF, \
+    avr_mega48a_fuse_low, avr_mega48a_fuse_high, avr_mega48a_fuse_extended, avr_base_lock
+#define avr_mega88a_definition \
+    AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, \
+    0x62, 0xDF, 0xF9, 0xFF, \
+    avr_mega88a_fuse_low, avr_mega88a_fuse_high, avr_mega88a_fuse_extended, avr_std_lock
+#define avr_mega168a_definition \
+    AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, \
+    0x62, 0xDF, 0xF9, 0xFF, \
+    avr_mega168a_fuse_low, avr_mega168a_fuse_high, avr_mega168a_fuse_extended, avr_std_lock
+#define avr_mega328a_definition \
+    AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, \
+    0x62, 0xD9, 0xFF, 0xFF, \
+    avr_mega328a_fuse_low, avr_mega328a_fuse_high, avr_mega328a_fuse_extended, avr_std_lock
 #define avr_megaX4_definition \
     AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, \
     0x62, 0x99, 0xFF, 0xFF, \
     avr_megaX4_fuse_low, avr_megaX4_fuse_high, avr_megaX4_fuse_extended, avr_std_lock
 
+/**
+ * Datasheets:
+ * - ATmega8/8A
+ *   https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-2486-8-bit-AVR-microcontroller-ATmega8_L_datasheet.pdf
+ *   https://ww1.microchip.com/downloads/en/DeviceDoc/ATmega8A-Data-Sheet-DS40001974B.pdf
+ * - ATmega16/16A
+ *   https://ww1.microchip.com/downloads/en/devicedoc/doc2466.pdf
+ *   https://ww1.microchip.com/downloads/en/devicedoc/atmel-8154-8-bit-avr-atmega16a_datasheet.pdf
+ * - ATmega32/32A
+ *   https://ww1.microchip.com/downloads/en/DeviceDoc/doc2503.pdf
+ *   https://ww1.microchip.com/downloads/en/DeviceDoc/Atmega32A-DataSheet-Complete-DS40002072A.pdf
+ * - ATmega88/ATmega168
+ *   https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-9365-Automotive-Microcontrollers-ATmega88-ATmega168_Datasheet.pdf
+ * - ATmega48A/PA/88A/PA/168A/PA/328/P
+ *   https://ww1.microchip.com/downloads/en/DeviceDoc/ATmega48A-PA-88A-PA-168A-PA-328-P-DS-DS40002061A.pdf
+ * - ATmega164A/164PA/324A/324PA/644A/644PA/1284/1284P, ATmega644, ATmega164P/V/324P/V/644P/V
+ *   https://ww1.microchip.com/downloads/aemDocuments/documents/MCU08/ProductDocuments/DataSheets/ATmega164A_PA-324A_PA-644A_PA-1284_P_Data-Sheet-40002070B.pdf
+ *   https://ww1.microchip.com/downloads/en/DeviceDoc/doc2593.pdf
+ *   https://ww1.microchip.com/downloads/aemDocuments/documents/OTH/ProductDocuments/DataSheets/ATmega164P-324P-644P-Data-Sheet-40002071A.pdf
+ * 
+ * Records have to be kept sorted by ascending signature, lookup_signature() 
+ * does a binary search. Parts sharing a signature cannot be told apart in 
+ * programming mode, so they share a single record named after all of them
+ * ("ATmega88/ATmega88A"), described by the newest datasheet.
+ * The table is const and with const data placed in program memory it is 
+ * read from Flash, nothing is copied to RAM.
+ */
 static const avr_record database[] = {
-    /**
-     * ATmega8/8A
-     * https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-2486-8-bit-AVR-microcontroller-ATmega8_L_datasheet.pdf
-     * https://ww1.microchip.com/downloads/en/DeviceDoc/ATmega8A-Data-Sheet-DS40001974B.pdf
-     * 
-     */
-    {
-        0x1E9307, "ATmega8/ATmega8A", AVR_FLAG_SUPPORTED,
-        0xE1, 0xD9, 0xFF, 0xFF, 
-        avr_mega8_fuse_low, avr_mega8_fuse_high, NULL, avr_std_lock,
-    },
-    
-    /**
-     * ATmega16/16A
-     * https://ww1.microchip.com/downloads/en/devicedoc/doc2466.pdf
-     * https://ww1.microchip.com/downloads/en/devicedoc/atmel-8154-8-bit-avr-atmega16a_datasheet.pdf
-     */
-    {
-        0x1E9403, "ATmega16/ATmega16A", AVR_FLAG_SUPPORTED,
-        0xE1, 0x99, 0xFF, 0xFF,
-        avr_mega16_fuse_low, avr_mega16_fuse_high, NULL, avr_std_lock
-    },
-    
-    /**
-     * ATmega32/32A
-     * https://ww1.microchip.com/downloads/en/DeviceDoc/doc2503.pdf
-     * https://ww1.microchip.com/downloads/en/DeviceDoc/Atmega32A-DataSheet-Complete-DS40002072A.pdf
-     */
-    {
-        0x1E9502, "ATmega32/ATmega32A", AVR_FLAG_SUPPORTED,
-        0xE1, 0x99, 0xFF, 0xFF,
-        avr_mega32_fuse_low, avr_mega32_fuse_high, NULL, avr_std_lock
-    },
-    
-    /*
-     * ATmega88/ATmega168
-     * https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-9365-Automotive-Microcontrollers-ATmega88-ATmega168_Datasheet.pdf
-     */
-    {
-        0x1E930A, "ATmega88", 0x00, 
-        0x62, 0xDF, 0xF9, 0xFF,
-        avr_mega88_fuse_low, avr_mega88_fuse_high, avr_mega88_fuse_extended, avr_std_lock
-    },
-    {
-        0x1E9406, "ATmega168", 0x00, 
-        0x62, 0xDF, 0xF9, 0xFF,
-        avr_mega168_fuse_low, avr_mega168_fuse_high, avr_mega168_fuse_extended, avr_std_lock    
-    },
-    
-    /**
-     * ATmega48A/PA/88A/PA/168A/PA/328/P
-     * https://ww1.microchip.com/downloads/en/DeviceDoc/ATmega48A-PA-88A-PA-168A-PA-328-P-DS-DS40002061A.pdf
-     */
-    {
-        0x1E9205, "ATmega48A", AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, 
-        0x62, 0xDF, 0xFF, 0xFF,
-        avr_mega48a_fuse_low, avr_mega48a_fuse_high, avr_mega48a_fuse_extended, avr_base_lock        
-    },
-    {
-        0x1E920A, "ATmega48PA", AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, 
-        0x62, 0xDF, 0xFF, 0xFF,
-        avr_mega48a_fuse_low, avr_mega48a_fuse_high, avr_mega48a_fuse_extended, avr_base_lock   
-    },
-    {
-        0x1E930A, "ATmega88A", AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, 
-        0x62, 0xDF, 0xF9, 0xFF, 
-        avr_mega88a_fuse_low, avr_mega88a_fuse_high, avr_mega88a_fuse_extended, avr_std_lock
-    },
-    {
-        0x1E930F, "ATmega88PA", AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, 
-        0x62, 0xDF, 0xF9, 0xFF, 
-        avr_mega88a_fuse_low, avr_mega88a_fuse_high, avr_mega88a_fuse_extended, avr_std_lock
-    },
-    {
-        0x1E9406, "ATmega168A", AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, 
-        0x62, 0xDF, 0xF9, 0xFF, 
-        avr_mega168a_fuse_low, avr_mega168a_fuse_high, avr_mega168a_fuse_extended, avr_std_lock
-    },
-    {
-        0x1E940B, "ATmega168PA", AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, 
-        0x62, 0xDF, 0xF9, 0xFF, 
-        avr_mega168a_fuse_low, avr_mega168a_fuse_high, avr_mega168a_fuse_extended, avr_std_lock
-    },
-    {
-        0x1E9514, "ATmega328", AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, 
-        0x62, 0xD9, 0xFF, 0xFF,
-        avr_mega328a_fuse_low, avr_mega328a_fuse_high, avr_mega328a_fuse_extended, avr_std_lock
-    },
-    {
-        0x1E950F, "ATmega328P", AVR_FLAG_SUPPORTED | AVR_FLAG_FUSE_EXTENDED, 
-        0x62, 0xD9, 0xFF, 0xFF,
-        avr_mega328a_fuse_low, avr_mega328a_fuse_high, avr_mega328a_fuse_extended, avr_std_lock
-    },
-       
-    /**
-     *  ATmega164A/164PA/324A/324PA/644A/644PA/1284/1284P 
-     *  ATmega644
-     *  ATmega164P/V/324P/V/644P/V
-     *  https://ww1.microchip.com/downloads/aemDocuments/documents/MCU08/ProductDocuments/DataSheets/ATmega164A_PA-324A_PA-644A_PA-1284_P_Data-Sheet-40002070B.pdf
-     *  https://ww1.microchip.com/downloads/en/DeviceDoc/doc2593.pdf
-     *  https://ww1.microchip.com/downloads/aemDocuments/documents/OTH/ProductDocuments/DataSheets/ATmega164P-324P-644P-Data-Sheet-40002071A.pdf
-     *  
-     */
-    {0x1E940F, "ATmega164A", avr_megaX4_definition},
-    {0x1E940A, "ATmega164P/ATmega164PA", avr_megaX4_definition},
-    {0x1E9515, "ATmega324A", avr_megaX4_definition},
-    {0x1E9508, "ATmega324P", avr_megaX4_definition},
-    {0x1E9511, "ATmega324PA", avr_megaX4_definition},
-    {0x1E9609, "ATmega644/ATmega644A", avr_megaX4_definition},
-    {0x1E960A, "ATmega644P/ATmega644PA", avr_megaX4_definition},
-    {0x1E9706, "ATmega1284", avr_megaX4_definition},
-    {0x1E9705, "ATmega1284P", avr_megaX4_definition},
+    /* Signature, name, definition, AVR_GEOMETRY(page words, pages, EEPROM page, EEPROM size) */
+    {0x1E9205, "ATmega48A", avr_mega48a_definition, AVR_GEOMETRY(32, 64, 4, 256)},
+    {0x1E920A, "ATmega48PA", avr_mega48a_definition, AVR_GEOMETRY(32, 64, 4, 256)},
+    {0x1E9307, "ATmega8/ATmega8A", avr_mega8_definition, AVR_GEOMETRY(32, 128, 4, 512)},
+    {0x1E930A, "ATmega88/ATmega88A", avr_mega88a_definition, AVR_GEOMETRY(32, 128, 4, 512)},
+    {0x1E930F, "ATmega88PA", avr_mega88a_definition, AVR_GEOMETRY(32, 128, 4, 512)},
+    {0x1E9403, "ATmega16/ATmega16A", avr_mega16_definition, AVR_GEOMETRY(64, 128, 4, 512)},
+    {0x1E9406, "ATmega168/ATmega168A", avr_mega168a_definition, AVR_GEOMETRY(64, 128, 4, 512)},
+    {0x1E940A, "ATmega164P/ATmega164PA", avr_megaX4_definition, AVR_GEOMETRY(64, 128, 4, 512)},
+    {0x1E940B, "ATmega168PA", avr_mega168a_definition, AVR_GEOMETRY(64, 128, 4, 512)},
+    {0x1E940F, "ATmega164A", avr_megaX4_definition, AVR_GEOMETRY(64, 128, 4, 512)},
+    {0x1E9502, "ATmega32/ATmega32A", avr_mega32_definition, AVR_GEOMETRY(64, 256, 4, 1024)},
+    {0x1E9508, "ATmega324P", avr_megaX4_definition, AVR_GEOMETRY(64, 256, 4, 1024)},
+    {0x1E950F, "ATmega328P", avr_mega328a_definition, AVR_GEOMETRY(64, 256, 4, 1024)},
+    {0x1E9511, "ATmega324PA", avr_megaX4_definition, AVR_GEOMETRY(64, 256, 4, 1024)},
+    {0x1E9514, "ATmega328", avr_mega328a_definition, AVR_GEOMETRY(64, 256, 4, 1024)},
+    {0x1E9515, "ATmega324A", avr_megaX4_definition, AVR_GEOMETRY(64, 256, 4, 1024)},
+    {0x1E9609, "ATmega644/ATmega644A", avr_megaX4_definition, AVR_GEOMETRY(128, 256, 8, 2048)},
+    {0x1E960A, "ATmega644P/ATmega644PA", avr_megaX4_definition, AVR_GEOMETRY(128, 256, 8, 2048)},
+    {0x1E9705, "ATmega1284P", avr_megaX4_definition, AVR_GEOMETRY(128, 512, 8, 4096)},
+    {0x1E9706, "ATmega1284", avr_megaX4_definition, AVR_GEOMETRY(128, 512, 8, 4096)},
 };
 
 #endif	/* AVR_DATABASE_H */
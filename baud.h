@@ -0,0 +1,37 @@
+/* 
+ * File:   baud.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * USART BAUD register value for Double-Speed mode (CLK2X, S = 8).
+ * Kept free of any AVR headers, so it can be built for the host as well.
+ */
+
+#ifndef BAUD_H
+#define	BAUD_H
+
+#include <stdint.h>
+
+/**
+ * Calculates BAUD register value for baudrate from clock (Hz).
+ * Returns 0 when the baud rate cannot be generated within error_max 
+ * (in 0.1 %).
+ */
+static inline uint16_t baud_register(const uint32_t clock, const uint32_t baudrate, 
+        const uint16_t error_max) {
+    if (baudrate == 0) {
+        return 0;
+    }
+    /* BAUD = 64 * F_CPU / (S * baudrate) */
+    uint32_t baud = ((8 * clock) + (baudrate / 2)) / baudrate;
+    if ((baud < 64) || (baud > 0xFFFF)) {
+        return 0;
+    }
+    uint32_t actual = (8 * clock) / baud;
+    uint32_t error = (actual > baudrate) ? (actual - baudrate) : (baudrate - actual);
+    if (error * 1000 > baudrate * error_max) {
+        return 0;
+    }
+    return baud;
+}
+
+#endif	/* BAUD_H */
@@ -0,0 +1,512 @@
+/*
+ * File:   binary.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Binary framed host protocol, see frame.h for the frame layout.
+ */
+
+#include "binary.h"
+#include "prog.h"
+#include "session.h"
+#include "gang.h"
+#include "image.h"
+#include "lz.h"
+#include "store.h"
+#include "standalone.h"
+#include "range.h"
+
+/* Returned by handlers which have already sent a response with payload */
+#define RESPONDED 0xFF
+
+static frame_t frame;
+static uint8_t response[FRAME_DATA_MAX - 1];
+static uint16_t page[FLASH_PAGE_WORDS_MAX];
+static lz_decoder decoder;
+static uint8_t lz_active = 0;
+
+static uint16_t get16(const uint8_t* data) {
+    return data[0] | ((uint16_t) data[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* data) {
+    return get16(data) | ((uint32_t) get16(data + 2) << 16);
+}
+
+/**
+ * Sends response to the current frame; response[1..length] holds the payload.
+ */
+static void respond(const uint8_t status, const uint16_t length) {
+    response[0] = status;
+    frame_send(usart1_write, frame.sequence, frame.data[0] | FRAME_OP_RESPONSE, 
+            response, length + 1);
+}
+
+/**
+ * Status of a failed programming function.
+ */
+static uint8_t failure(const int8_t result) {
+    switch (result) {
+        case PROG_ERROR_TIMEOUT:
+            return FRAME_STATUS_TIMEOUT;
+        case PROG_ERROR_VERIFY:
+            return FRAME_STATUS_VERIFY;
+    }
+    return FRAME_STATUS_FAILED;
+}
+
+static uint8_t op_baud(const uint8_t* payload, const uint16_t length) {
+    if (length != 4) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    uint32_t baudrate = get32(payload);
+    if (usart1_check_baudrate(baudrate) < 0) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    respond(FRAME_STATUS_OK, 0);
+    usart1_negotiate_baudrate(baudrate);
+    return RESPONDED;
+}
+
+#if STATS_ENABLED
+static void put32(uint8_t* data, const uint32_t value) {
+    for (uint8_t i = 0; i < 4; i++) {
+        data[i] = value >> (8 * i);
+    }
+}
+
+/**
+ * Reports counters of the current window, optionally starting a new one.
+ */
+static uint8_t op_stats(const uint8_t* payload, const uint16_t length) {
+    if (length != 1) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    uint8_t* out = response + 1;
+    put32(out, stats_window());
+    for (uint8_t i = 0; i < STATS_COUNTERS; i++) {
+        put32(out + 4 + 8 * i, stats[i].count);
+        put32(out + 8 + 8 * i, stats[i].cycles);
+    }
+    respond(FRAME_STATUS_OK, 4 + 8 * STATS_COUNTERS);
+    if (payload[0]) {
+        stats_reset();
+    }
+    return RESPONDED;
+}
+#endif
+
+static uint8_t op_enter(void) {
+    uint32_t signature;
+    lz_active = 0;
+    switch (session_enter(&signature)) {
+        case SESSION_ERROR_STATE:
+            return FRAME_STATUS_STATE;
+        case SESSION_ERROR_DEVICE:
+            return FRAME_STATUS_FAILED;
+    }
+    response[1] = signature >> 16;
+    response[2] = signature >> 8;
+    response[3] = signature;
+    respond(FRAME_STATUS_OK, 3);
+    return RESPONDED;
+}
+
+static uint8_t op_geometry(void) {
+    response[1] = session_record->flash_page_words;
+    response[2] = session_record->flash_pages & 0xFF;
+    response[3] = session_record->flash_pages >> 8;
+    response[4] = session_record->eeprom_page_size;
+    response[5] = session_record->eeprom_size & 0xFF;
+    response[6] = session_record->eeprom_size >> 8;
+    respond(FRAME_STATUS_OK, 6);
+    return RESPONDED;
+}
+
+static uint8_t op_read_fuses(void) {
+    read_fuse_and_lock_bits(response + 1, (session_record->flags & AVR_FLAG_SUPPORTED) ? 
+        (session_record->flags & AVR_FLAG_FUSE_EXTENDED) : 1);
+    respond(FRAME_STATUS_OK, 4);
+    return RESPONDED;
+}
+
+static uint8_t op_write_times(void) {
+    for (uint8_t kind = 0; kind < WRITE_KINDS; kind++) {
+        uint32_t measured = target_write_time_us(kind);
+        uint32_t timeout = target_timeout_us(kind);
+        for (uint8_t i = 0; i < 4; i++) {
+            response[1 + 8 * kind + i] = measured >> (8 * i);
+            response[5 + 8 * kind + i] = timeout >> (8 * i);
+        }
+    }
+    respond(FRAME_STATUS_OK, 8 * WRITE_KINDS);
+    return RESPONDED;
+}
+
+static uint8_t op_write_fuse(const uint8_t* payload, const uint16_t length) {
+    int8_t result;
+    if (length != 2) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    switch (payload[0]) {
+        case FRAME_FUSE_LOW:
+            result = program_fuse_low_bits(payload[1]);
+            break;
+        case FRAME_FUSE_HIGH:
+            result = program_fuse_high_bits(payload[1]);
+            break;
+        case FRAME_FUSE_EXTENDED:
+            result = program_fuse_extended_bits(payload[1]);
+            break;
+        case FRAME_FUSE_LOCK:
+            result = program_lock_bits(payload[1]);
+            break;
+        default:
+            return FRAME_STATUS_ARGUMENT;
+    }
+    return (result < 0) ? failure(result) : FRAME_STATUS_OK;
+}
+
+/**
+ * FRAME_FUSE_* indices match FUSE_* of prog.h. Extended fuse is left out
+ * on devices which have none.
+ */
+static uint8_t op_set_fuses(const uint8_t* payload, const uint16_t length) {
+    uint8_t extended = (session_record->flags & AVR_FLAG_SUPPORTED) ? 
+        (session_record->flags & AVR_FLAG_FUSE_EXTENDED) : 1;
+    if (length != 1 + FUSE_BYTES) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    uint8_t select = payload[0];
+    if ((select & ~((1 << FUSE_BYTES) - 1)) || ((select & FUSE_EXTENDED_bm) && !extended)) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    memcpy(response + 2, payload + 1, FUSE_BYTES);
+    int8_t result = program_fuse_and_lock_bits(response + 2, select, extended, gang_targets != 0);
+    if (result < 0) {
+        return failure(result);
+    }
+    response[1] = result;
+    respond(FRAME_STATUS_OK, 1 + FUSE_BYTES);
+    return RESPONDED;
+}
+
+/**
+ * Page is decoded while the previous one may still be written by the target,
+ * then handed over and acknowledged without waiting for its write to finish,
+ * so the host can transfer the next page meanwhile. Page programming is 
+ * finished by any other opcode. Blank or unchanged pages are skipped, 
+ * which is reported in the response.
+ */
+static uint8_t op_write_flash(const uint8_t* payload, const uint16_t length) {
+    uint16_t words = (length - 2) / 2;
+    if ((length < 4) || (length & 1) || (words > session_record->flash_page_words) ||
+        (get16(payload) % session_record->flash_page_words) ||
+        (get16(payload) + (uint32_t) words > AVR_FLASH_WORDS(session_record))) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    for (uint16_t i = 0; i < words; i++) {
+        page[i] = get16(payload + 2 + 2 * i);
+    }
+    int8_t result = program_flash_page_start(get16(payload), page, words);
+    if (result < 0) {
+        return failure(result);
+    }
+    response[1] = (result == PROG_SKIPPED);
+    respond(FRAME_STATUS_OK, 1);
+    return RESPONDED;
+}
+
+static uint8_t op_lz_start(const uint8_t* payload, const uint16_t length) {
+    if ((length != 2) || (get16(payload) % session_record->flash_page_words)) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    lz_reset(&decoder);
+    image_start(get16(payload), session_record->flash_page_words, AVR_FLASH_SIZE(session_record));
+    lz_active = 1;
+    return FRAME_STATUS_OK;
+}
+
+/**
+ * Decompressed straight into the image page buffer; pages are written as 
+ * they fill up, pipelined like FRAME_OP_WRITE_FLASH.
+ */
+static uint8_t op_lz_data(const uint8_t* payload, const uint16_t length) {
+    if (!lz_active) {
+        return FRAME_STATUS_STATE;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        int8_t result = lz_feed(&decoder, payload[i], image_put);
+        if (result < 0) {
+            lz_active = 0;
+            return failure(result);
+        }
+    }
+    return FRAME_STATUS_OK;
+}
+
+static uint8_t op_lz_end(void) {
+    if (!lz_active) {
+        return FRAME_STATUS_STATE;
+    }
+    lz_active = 0;
+    int8_t result = image_flush();
+    if (result < 0) {
+        return failure(result);
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        response[1 + i] = image_length >> (8 * i);
+    }
+    response[5] = image_pages & 0xFF;
+    response[6] = image_pages >> 8;
+    response[7] = image_skipped & 0xFF;
+    response[8] = image_skipped >> 8;
+    respond(FRAME_STATUS_OK, 8);
+    return RESPONDED;
+}
+
+/**
+ * Unchanged EEPROM pages are not rewritten, the response tells how many 
+ * pages actually were.
+ */
+static uint8_t op_write_eeprom(const uint8_t* payload, const uint16_t length) {
+    if (gang_targets) {
+        return FRAME_STATUS_STATE;      /* EEPROM contents differ between targets */
+    }
+    if ((length < 3) || !range_fits(get16(payload), length - 2, session_record->eeprom_size)) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    int16_t written = program_eeprom(get16(payload), payload + 2, length - 2, 
+        session_record->eeprom_page_size);
+    if (written < 0) {
+        return failure(written);
+    }
+    response[1] = written & 0xFF;
+    response[2] = written >> 8;
+    respond(FRAME_STATUS_OK, 2);
+    return RESPONDED;
+}
+
+static uint8_t op_read(const uint8_t flash, const uint8_t* payload, const uint16_t length) {
+    if (length != 6) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    uint32_t start = get32(payload);
+    uint16_t count = get16(payload + 4);
+    if ((count > sizeof(response) - 1) || 
+        !range_fits(start, count, flash ? AVR_FLASH_SIZE(session_record) : session_record->eeprom_size)) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    uint16_t word = 0;
+    if (flash) {
+        read_flash_start();
+    } else {
+        read_eeprom_start();
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t address = start + i;
+        if (!flash) {
+            response[1 + i] = read_eeprom_next(address);
+        } else if ((address & 1) && (i != 0)) {
+            response[1 + i] = word >> 8;
+        } else {
+            word = read_flash_next(address >> 1);
+            response[1 + i] = (address & 1) ? (word >> 8) : (word & 0xFF);
+        }
+    }
+    respond(FRAME_STATUS_OK, count);
+    return RESPONDED;
+}
+
+static uint8_t op_crc(const uint8_t* payload, const uint16_t length) {
+    if ((length != 9) || (payload[0] > FRAME_MEMORY_EEPROM)) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    uint32_t start = get32(payload + 1);
+    uint32_t count = get32(payload + 5);
+    if (!range_fits(start, count, (payload[0] == FRAME_MEMORY_FLASH) ? 
+        AVR_FLASH_SIZE(session_record) : session_record->eeprom_size)) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    uint32_t crc = (payload[0] == FRAME_MEMORY_FLASH) ?
+        read_flash_crc32(start, count) : read_eeprom_crc32(start, count);
+    for (uint8_t i = 0; i < 4; i++) {
+        response[1 + i] = crc >> (8 * i);
+    }
+    respond(FRAME_STATUS_OK, 4);
+    return RESPONDED;
+}
+
+static uint8_t op_store_write(const uint8_t* payload, const uint16_t length) {
+    if (length < 5) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    uint32_t offset = get32(payload);
+    if (!range_fits(offset, length - 4, STORE_IMAGE_MAX)) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    if (store_write(STORE_IMAGE_OFFSET + offset, payload + 4, length - 4) < 0) {
+        return FRAME_STATUS_FAILED;
+    }
+    return FRAME_STATUS_OK;
+}
+
+/**
+ * Image CRC is computed from what was actually stored, so the host can 
+ * compare it against its own.
+ */
+static uint8_t op_store_commit(const uint8_t* payload, const uint16_t length) {
+    store_header header;
+    if (length != 14) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    header.signature = get32(payload);
+    header.image_length = get32(payload + 4);
+    header.page_words = payload[8];
+    header.flags = payload[9];
+    header.fuse_low = payload[10];
+    header.fuse_high = payload[11];
+    header.fuse_extended = payload[12];
+    header.lock = payload[13];
+    if ((header.image_length > STORE_IMAGE_MAX) || (header.page_words == 0) || 
+        (header.page_words > FLASH_PAGE_WORDS_MAX)) {
+        return FRAME_STATUS_ARGUMENT;
+    }
+    if ((store_image_crc32(header.image_length, &header.image_crc) < 0) ||
+        (store_write_header(&header) < 0)) {
+        return FRAME_STATUS_FAILED;
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        response[1 + i] = header.image_crc >> (8 * i);
+    }
+    respond(FRAME_STATUS_OK, 4);
+    return RESPONDED;
+}
+
+/**
+ * Target state follows the job, the response is sent when it is done.
+ */
+static uint8_t op_job_run(void) {
+    job_status status;
+    switch (standalone_job(&status)) {
+        case STANDALONE_ERROR_STATE:
+            return FRAME_STATUS_STATE;
+        case STANDALONE_ERROR_JOB:
+            return FRAME_STATUS_FAILED;
+    }
+    response[1] = status.result;
+    response[2] = status.step;
+    response[3] = status.op;
+    response[4] = status.target;
+    for (uint8_t i = 0; i < 4; i++) {
+        response[5 + i] = status.ms >> (8 * i);
+    }
+    respond(FRAME_STATUS_OK, 8);
+    return RESPONDED;
+}
+
+/**
+ * Handles a single complete frame, returns FRAME_STATUS_* to be sent as 
+ * a bare status response, or RESPONDED.
+ */
+static uint8_t dispatch(void) {
+    const uint8_t opcode = frame.data[0];
+    const uint8_t* payload = frame.data + 1;
+    const uint16_t length = frame.length - 1;
+    if ((opcode != FRAME_OP_WRITE_FLASH) && (opcode != FRAME_OP_LZ_DATA) && 
+        (session_mode == SESSION_PROGRAMMING) && (program_flash_finish() < 0) &&
+        (opcode != FRAME_OP_EXIT) && (opcode != FRAME_OP_RUN) && (opcode != FRAME_OP_TEXT)) {
+        return FRAME_STATUS_TIMEOUT;    /* Last page of the previous opcode */
+    }
+    switch (opcode) {
+        case FRAME_OP_PING:
+        case FRAME_OP_TEXT:
+            return FRAME_STATUS_OK;
+        case FRAME_OP_BAUD:
+            return op_baud(payload, length);
+#if STATS_ENABLED
+        case FRAME_OP_STATS:
+            return op_stats(payload, length);
+#endif
+        case FRAME_OP_ENTER:
+            return op_enter();
+        case FRAME_OP_EXIT:
+            return (session_exit() == SESSION_OK) ? FRAME_STATUS_OK : FRAME_STATUS_STATE;
+        case FRAME_OP_RUN:
+            return (session_run() == SESSION_OK) ? FRAME_STATUS_OK : FRAME_STATUS_STATE;
+        case FRAME_OP_STORE_WRITE:
+            return op_store_write(payload, length);
+        case FRAME_OP_STORE_COMMIT:
+            return op_store_commit(payload, length);
+        case FRAME_OP_JOB_RUN:
+            return op_job_run();
+    }
+    if (session_mode != SESSION_PROGRAMMING) {
+        return FRAME_STATUS_STATE;
+    }
+    switch (opcode) {
+        case FRAME_OP_ERASE:
+            return (erase_chip() < 0) ? FRAME_STATUS_TIMEOUT : FRAME_STATUS_OK;
+        case FRAME_OP_GEOMETRY:
+            return op_geometry();
+        case FRAME_OP_WRITE_TIMES:
+            return op_write_times();
+        case FRAME_OP_READ_FUSES:
+            return op_read_fuses();
+        case FRAME_OP_WRITE_FUSE:
+            return op_write_fuse(payload, length);
+        case FRAME_OP_SET_FUSES:
+            return op_set_fuses(payload, length);
+        case FRAME_OP_WRITE_FLASH:
+            return op_write_flash(payload, length);
+        case FRAME_OP_LZ_START:
+            return op_lz_start(payload, length);
+        case FRAME_OP_LZ_DATA:
+            return op_lz_data(payload, length);
+        case FRAME_OP_LZ_END:
+            return op_lz_end();
+        case FRAME_OP_WRITE_EEPROM:
+            return op_write_eeprom(payload, length);
+        case FRAME_OP_READ_FLASH:
+            return op_read(1, payload, length);
+        case FRAME_OP_READ_EEPROM:
+            return op_read(0, payload, length);
+        case FRAME_OP_CRC:
+            return op_crc(payload, length);
+        case FRAME_OP_FLASH_UPDATE:
+            if (length != 1) {
+                return FRAME_STATUS_ARGUMENT;
+            }
+            if (payload[0] && gang_targets) {
+                return FRAME_STATUS_STATE;  /* Pages are compared on one target only */
+            }
+            set_flash_update_mode(payload[0]);
+            return FRAME_STATUS_OK;
+    }
+    return FRAME_STATUS_UNKNOWN;
+}
+
+/**
+ * Runs the binary protocol until FRAME_OP_TEXT is received.
+ */
+void binary_session(void) {
+    frame_reset(&frame);
+    while (1) {
+        switch (frame_feed(&frame, usart1_getc(NULL))) {
+            case FRAME_ERROR:
+                response[0] = FRAME_STATUS_CRC;
+                frame_send(usart1_write, frame.sequence, FRAME_OP_RESPONSE, response, 1);
+                break;
+            case FRAME_COMPLETE:
+            {
+                uint8_t status = dispatch();
+                if (status != RESPONDED) {
+                    respond(status, 0);
+                }
+                if (frame.data[0] == FRAME_OP_TEXT) {
+                    return;
+                }
+                break;
+            }
+        }
+    }
+}
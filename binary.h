@@ -0,0 +1,15 @@
+/* 
+ * File:   binary.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#ifndef BINARY_H
+#define	BINARY_H
+
+#include "config.h"
+#include "frame.h"
+
+void binary_session(void);
+
+#endif	/* BINARY_H */
+
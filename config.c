@@ -4,30 +4,19 @@
  */
 
 #include "config.h"
+#include "ring.h"
+#include "baud.h"
+#include "stats.h"
 
-static FILE usart1_out_stream = FDEV_SETUP_STREAM(usart1_putc, NULL, _FDEV_SETUP_WRITE);
+static uint8_t usart1_rx_storage[USART1_RX_BUFFER_SIZE];
+static uint8_t usart1_tx_storage[USART1_TX_BUFFER_SIZE];
+static ring_t usart1_rx = RING_INITIALIZER(usart1_rx_storage);
+static ring_t usart1_tx = RING_INITIALIZER(usart1_tx_storage);
 
-int usart1_gets(char* buf, const unsigned int buf_size) {
-    unsigned int read = 0;
-    if (buf_size < 1) {
-        return -1;
-    }
-    while (read < buf_size - 1) {
-        char data = usart1_getc(NULL);
-        if (data == '\r') {
-            usart1_putc('\n', NULL);
-            break;
-        } else if (isalpha(data) || isdigit(data) || data == ' ') {
-            buf[read++] = data;
-            usart1_putc(data, NULL);
-        } else if ((data == 0x08) && (read > 0)) {
-            usart1_puts("\x08\x20\x08");
-            buf[--read] = 0;
-        }
-    }
-    buf[read] = 0;
-    return read;
-}
+static uint32_t usart1_baudrate = USART1_BAUDRATE;
+static volatile uint8_t usart1_rx_errors = 0;
+
+static FILE usart1_out_stream = FDEV_SETUP_STREAM(usart1_putc, NULL, _FDEV_SETUP_WRITE);
 
 /** PORTA
  * 0 D0
@@ -94,6 +83,7 @@ void portd_control(void) {
  * 6 ~{RESET}               (Hardware)
  */
 void portf_init(void) {
+    PORTF.PIN4CTRL = PORT_ISC_INTDISABLE_gc;
     PORTF.PIN5CTRL = PORT_INVEN_bm;
     PORTF.DIRSET = PF_TRESET_bm | PF_12V_EN_bm | PF_5V_EN_bm;
     PORTF.DIRCLR = PF_BS2_bm | PF_PROGRAM_bm | PF_RDY_BSY_bm;
@@ -106,14 +96,27 @@ void portf_init(void) {
 void portf_control(void) {
     PORTF.DIRSET = PF_BS2_bm;
     PORTF.OUTCLR = PF_BS2_bm;
+    PORTF.PIN4CTRL = PORT_ISC_RISING_gc; // RDY/~{BSY} write completion
+}
+
+/** RTC                     Coarse clock (HAL_CLOCK)
+ * - Clocked by the internal 32.768 kHz oscillator, prescaled to 1024 Hz
+ * - Free running over the whole 16-bit period, no interrupts
+ */
+void rtc_init(void) {
+    while (RTC.STATUS);
+    RTC.CLKSEL = RTC_CLKSEL_OSC32K_gc;
+    RTC.PER = 0xFFFF;
+    RTC.CTRLA = RTC_PRESCALER_DIV32_gc | RTC_RTCEN_bm;
 }
 
 /** USART1                  Debug UART
  * - Baud rate USART1_BAUDRATE, 8 data bit, 1 stop bit, no parity
  * - MSb of the data word is transmitted first
  * - Data are sampled on the leading (first) edge
- * - Normal-Speed mode
- * - CTRLA: No interrupts enabled
+ * - Double-Speed mode (CLK2X)
+ * - CTRLA: Receive Complete interrupt enabled, Data Register Empty interrupt
+ *   enabled on demand while there is data in the TX ring buffer
  */
 void usart1_init(void) {
     /* S is the number of samples per bit
@@ -123,22 +126,113 @@ void usart1_init(void) {
      */
     PORTMUX.USARTROUTEA = PORTMUX_USART0_NONE_gc | PORTMUX_USART1_DEFAULT_gc | 
             PORTMUX_USART2_NONE_gc;
-    USART1.BAUD = (64.0 * F_CPU) / (/* S */ 16.0 * USART1_BAUDRATE);
-    // USART1.CTRLA = USART_RXCIE_bm; 
+    usart1_set_baudrate(USART1_BAUDRATE);
+    USART1.CTRLA = USART_RXCIE_bm;
     USART1.CTRLC = USART_CMODE_ASYNCHRONOUS_gc | USART_CHSIZE_8BIT_gc | USART_SBMODE_1BIT_gc;
-    USART1.CTRLB = USART_RXEN_bm | USART_TXEN_bm;
+    USART1.CTRLB = USART_RXEN_bm | USART_TXEN_bm | USART_RXMODE_CLK2X_gc;
     stdout = &usart1_out_stream;
 }
 
+static uint16_t usart1_baud_register(const uint32_t baudrate) {
+    return baud_register(F_CPU, baudrate, USART1_BAUD_ERROR_MAX);
+}
+
+uint32_t usart1_get_baudrate(void) {
+    return usart1_baudrate;
+}
+
+/**
+ * Returns 0 when the baud rate is achievable, -1 otherwise.
+ */
+int8_t usart1_check_baudrate(const uint32_t baudrate) {
+    return usart1_baud_register(baudrate) ? 0 : -1;
+}
+
+/**
+ * Returns 0 on success, -1 when the baud rate is not achievable.
+ */
+int8_t usart1_set_baudrate(const uint32_t baudrate) {
+    uint16_t baud = usart1_baud_register(baudrate);
+    if (baud == 0) {
+        return -1;
+    }
+    USART1.BAUD = baud;
+    usart1_baudrate = baudrate;
+    return 0;
+}
+
+/**
+ * Switches to a new baud rate after everything queued has been sent, then
+ * waits USART1_BAUD_TIMEOUT_MS for the host to send anything at the new 
+ * rate. Falls back to the previous baud rate when nothing arrives, or when 
+ * what arrives has framing errors (host still at the old rate).
+ * Received bytes are left in the RX buffer.
+ * Returns 0 on success, -1 when not achievable, -2 on fallback.
+ */
+int8_t usart1_negotiate_baudrate(const uint32_t baudrate) {
+    uint32_t previous = usart1_baudrate;
+    if (usart1_check_baudrate(baudrate) < 0) {
+        return -1;
+    }
+    usart1_flush();
+    usart1_set_baudrate(baudrate);
+    usart1_rx_errors = 0;
+    for (uint16_t i = 0; i < USART1_BAUD_TIMEOUT_MS; i++) {
+        if (usart1_rx_errors) {
+            break;
+        }
+        if (usart1_available()) {
+            return 0;
+        }
+        _delay_ms(1);
+    }
+    usart1_set_baudrate(previous);
+    /* Discard whatever was received at the wrong rate */
+    while (usart1_available()) {
+        usart1_getc(NULL);
+    }
+    return -2;
+}
+
+ISR(USART1_RXC_vect) {
+    if (USART1.RXDATAH & USART_FERR_bm) {
+        usart1_rx_errors++;
+    }
+    /* On overflow the byte is dropped, there is no flow control */
+    ring_put(&usart1_rx, USART1.RXDATAL);
+}
+
+ISR(USART1_DRE_vect) {
+    uint8_t data;
+    if (ring_get(&usart1_tx, &data)) {
+        USART1.STATUS = USART_TXCIF_bm;
+        USART1.TXDATAL = data;
+    } else {
+        USART1.CTRLA &= ~USART_DREIE_bm;
+    }
+}
+
 int usart1_putc(const char c, FILE *stream) {
     if (c == '\n') {
         usart1_putc('\r', stream);
     }
-	while (!(USART1.STATUS & USART_DREIF_bm));
-	USART1.TXDATAL = c;
+    usart1_write(c);
     return 0;
 }
 
+/**
+ * Raw binary output, no newline translation.
+ * Blocks only when the TX ring buffer is full.
+ */
+void usart1_write(const uint8_t c) {
+    if (!ring_put(&usart1_tx, c)) {
+        STATS_WAIT_START();
+        while (!ring_put(&usart1_tx, c));
+        STATS_WAIT_STOP(STATS_UART_TX);
+    }
+    USART1.CTRLA |= USART_DREIE_bm;
+}
+
 void usart1_puts(const char* s) {
     while (*s) {
         usart1_putc(*(s++), NULL);
@@ -146,18 +240,45 @@ void usart1_puts(const char* s) {
 }
 
 int usart1_getc(FILE* stream) {
-    while (!(USART1.STATUS & USART_RXCIF_bm));
-    return USART1.RXDATAL;
+    uint8_t data;
+    if (!ring_get(&usart1_rx, &data)) {
+        STATS_WAIT_START();
+        while (!ring_get(&usart1_rx, &data));
+        STATS_WAIT_STOP(STATS_UART_RX);
+    }
+    return data;
+}
+
+/**
+ * Number of received bytes waiting in the RX ring buffer.
+ */
+uint8_t usart1_available(void) {
+    return ring_count(&usart1_rx);
+}
+
+/**
+ * Waits until everything queued has been shifted out.
+ */
+void usart1_flush(void) {
+    while (!ring_empty(&usart1_tx));
+    while (USART1.CTRLA & USART_DREIE_bm);
+    while (!(USART1.STATUS & USART_TXCIF_bm));
 }
 
 void init(void) {
-    /** Disable prescaler */
+    /** Run OSCHF at F_CPU, disable prescaler */
+    _PROTECTED_WRITE(CLKCTRL.OSCHFCTRLA, CLKCTRL_FRQSEL_gc);
     _PROTECTED_WRITE(CLKCTRL.MCLKCTRLA, CLKCTRL_CLKSEL_OSCHF_gc);
     _PROTECTED_WRITE(CLKCTRL.MCLKCTRLB, 0x00);
+    set_sleep_mode(SLEEP_MODE_IDLE);
     porta_init();
     portc_init();
     portd_init();
     portf_init();
     usart1_init();
+    rtc_init();
+#if STATS_ENABLED
+    stats_init();
+#endif
     sei();
 }
@@ -6,15 +6,54 @@
 #ifndef CONFIG_H
 #define	CONFIG_H
 
+#ifdef HAL_HOST
+/* Firmware built for Linux, see host/loop.c */
+#include "sim.h"
+#else
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <stdio.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
+#endif
+#include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include <ctype.h>
 
-/* Debug UART full duplex */
+/* Main clock, OSCHF frequency matching F_CPU */
+#if defined(HAL_HOST)
+/* Host clock is not configured */
+#elif F_CPU == 24000000UL
+#define CLKCTRL_FRQSEL_gc CLKCTRL_FRQSEL_24M_gc
+#elif F_CPU == 20000000UL
+#define CLKCTRL_FRQSEL_gc CLKCTRL_FRQSEL_20M_gc
+#elif F_CPU == 16000000UL
+#define CLKCTRL_FRQSEL_gc CLKCTRL_FRQSEL_16M_gc
+#elif F_CPU == 12000000UL
+#define CLKCTRL_FRQSEL_gc CLKCTRL_FRQSEL_12M_gc
+#elif F_CPU == 8000000UL
+#define CLKCTRL_FRQSEL_gc CLKCTRL_FRQSEL_8M_gc
+#elif F_CPU == 4000000UL
+#define CLKCTRL_FRQSEL_gc CLKCTRL_FRQSEL_4M_gc
+#else
+#error "F_CPU has to be one of OSCHF frequencies (4, 8, 12, 16, 20 or 24 MHz)"
+#endif
+
+/* Debug UART full duplex, startup baud rate */
 #define USART1_BAUDRATE 115200
+/* Largest acceptable baud rate error, in 0.1 % */
+#define USART1_BAUD_ERROR_MAX 20
+/* Time for the host to confirm new baud rate before falling back */
+#define USART1_BAUD_TIMEOUT_MS 2000
+/* Ring buffer sizes, power of two up to 256 */
+#define USART1_RX_BUFFER_SIZE 256
+#define USART1_TX_BUFFER_SIZE 128
+
+/* Bus and link instrumentation on TCB0 (stats command), 0 compiles it out */
+#ifndef STATS_ENABLED
+#define STATS_ENABLED 0
+#endif
     
 void init(void);
 
@@ -23,26 +62,20 @@ void portd_init(void);
 void portd_control(void);
 void portf_init(void);
 void portf_control(void);
+void rtc_init(void);
 
 int usart1_putc(const char c, FILE *stream);
+void usart1_write(const uint8_t c);
 void usart1_puts(const char* s);
 int usart1_getc(FILE* stream);
-int usart1_gets(char* buf, const unsigned int buf_size);
-
-#define PF_BS2_bm PIN0_bm
-#define PF_TRESET_bm PIN1_bm
-#define PF_12V_EN_bm PIN2_bm
-#define PF_5V_EN_bm PIN3_bm
-#define PF_RDY_BSY_bm PIN4_bm
-#define PF_PROGRAM_bm PIN5_bm
-
-#define PD_PAGEL_bm PIN1_bm
-#define PD_XA1_bm PIN2_bm
-#define PD_XA0_bm PIN3_bm
-#define PD_BS1_bm PIN4_bm
-#define PD_WR_bm PIN5_bm
-#define PD_OE_bm PIN6_bm
-#define PD_XTAL1_bm PIN7_bm
+uint8_t usart1_available(void);
+void usart1_flush(void);
+uint32_t usart1_get_baudrate(void);
+int8_t usart1_check_baudrate(const uint32_t baudrate);
+int8_t usart1_set_baudrate(const uint32_t baudrate);
+int8_t usart1_negotiate_baudrate(const uint32_t baudrate);
+
+#include "pins.h"
 
 #endif	/* CONFIG_H */
 
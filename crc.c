@@ -0,0 +1,38 @@
+/*
+ * File:   crc.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Kept free of any AVR headers, so it can be built for the host as well.
+ */
+
+#include "crc.h"
+
+/**
+ * CRC-16/CCITT-FALSE (polynomial 0x1021, initial value CRC16_INIT)
+ */
+uint16_t crc16_update(uint16_t crc, const uint8_t data) {
+    crc ^= (uint16_t) data << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+    return crc;
+}
+
+/* CRC-32 of every nibble value, reflected polynomial 0xEDB88320 */
+static const uint32_t crc32_nibble_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+/**
+ * CRC-32 (as in zlib/Ethernet), nibble table variant to keep the table small.
+ * Start with CRC32_INIT, apply CRC32_FINAL to the result.
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t data) {
+    crc ^= data;
+    crc = (crc >> 4) ^ crc32_nibble_table[crc & 0x0F];
+    crc = (crc >> 4) ^ crc32_nibble_table[crc & 0x0F];
+    return crc;
+}
@@ -0,0 +1,19 @@
+/* 
+ * File:   crc.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#ifndef CRC_H
+#define	CRC_H
+
+#include <stdint.h>
+
+#define CRC16_INIT 0xFFFF
+#define CRC32_INIT 0xFFFFFFFFUL
+#define CRC32_FINAL(crc) ((crc) ^ 0xFFFFFFFFUL)
+
+uint16_t crc16_update(uint16_t crc, const uint8_t data);
+uint32_t crc32_update(uint32_t crc, const uint8_t data);
+
+#endif	/* CRC_H */
+
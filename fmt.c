@@ -0,0 +1,126 @@
+/*
+ * File:   fmt.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include "fmt.h"
+
+uint8_t fmt_machine = 0;
+
+void fmt_char(const char c) {
+    usart1_putc(c, NULL);
+}
+
+void fmt_str(const char* s) {
+    usart1_puts(s);
+}
+
+/**
+ * Left aligned in at least width characters, like %-*s.
+ */
+void fmt_pad(const char* s, const uint8_t width) {
+    uint8_t length = 0;
+    for (; s[length]; length++) {
+        fmt_char(s[length]);
+    }
+    for (; length < width; length++) {
+        fmt_char(' ');
+    }
+}
+
+/**
+ * Upper case, zero padded to digits; 0 digits prints as many as needed.
+ */
+void fmt_hex(const uint32_t value, const uint8_t digits) {
+    uint8_t n = 8;
+    while ((n > 1) && (n > digits) && !(value >> (4 * (n - 1)))) {
+        n--;
+    }
+    while (n--) {
+        uint8_t nibble = (value >> (4 * n)) & 0x0F;
+        fmt_char((nibble < 10) ? ('0' + nibble) : ('A' - 10 + nibble));
+    }
+}
+
+static void dec(uint32_t value, const uint8_t width, const char fill) {
+    char digits[10];
+    uint8_t n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    for (uint8_t i = n; i < width; i++) {
+        fmt_char(fill);
+    }
+    while (n) {
+        fmt_char(digits[--n]);
+    }
+}
+
+/**
+ * Right aligned in at least width characters, like %*lu.
+ */
+void fmt_dec(const uint32_t value, const uint8_t width) {
+    dec(value, width, ' ');
+}
+
+/**
+ * Eight binary digits, MSB first.
+ */
+void fmt_bin(const uint8_t value) {
+    for (uint8_t mask = 0x80; mask; mask >>= 1) {
+        fmt_char((value & mask) ? '1' : '0');
+    }
+}
+
+/**
+ * Microseconds as milliseconds with three decimals, whole milliseconds
+ * right aligned in width.
+ */
+void fmt_ms(const uint32_t us, const uint8_t width) {
+    dec(us / 1000, width, ' ');
+    fmt_char('.');
+    dec(us % 1000, 3, '0');
+}
+
+void fmt_tag(const char* tag) {
+    if (fmt_machine) {
+        fmt_str(tag);
+        fmt_char('=');
+    } else {
+        fmt_pad(tag, FMT_TAG_WIDTH);
+        fmt_char('\t');
+    }
+}
+
+/**
+ * Machine mode tag of one field of a record, tag.key=.
+ */
+void fmt_key(const char* tag, const char* key) {
+    fmt_str(tag);
+    fmt_char('.');
+    fmt_str(key);
+    fmt_char('=');
+}
+
+/**
+ * Machine mode field after the first one on a line, key=.
+ */
+void fmt_field(const char* key) {
+    fmt_char(' ');
+    fmt_str(key);
+    fmt_char('=');
+}
+
+void fmt_end(void) {
+    fmt_char('\n');
+}
+
+/**
+ * Whole line, tag and text.
+ */
+void fmt_line(const char* tag, const char* text) {
+    fmt_tag(tag);
+    fmt_str(text);
+    fmt_end();
+}
@@ -0,0 +1,41 @@
+/*
+ * File:   fmt.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Console output without printf: numbers are converted here and written
+ * straight to the USART1 TX ring, so vfprintf is not linked in.
+ *
+ * Every line starts with a tag. The text console pads it to FMT_TAG_WIDTH
+ * and follows it with a tab. In machine mode (`mode machine`) the tag is
+ * followed by '=', and colors and explanatory columns are left out, which
+ * gives terse tag=value lines for scripts. Lines with several values are
+ * written as tag.key=value followed by key=value fields.
+ */
+
+#ifndef FMT_H
+#define	FMT_H
+
+#include "config.h"
+
+#define FMT_TAG_WIDTH 10
+
+#define FMT_RESET "\x1b[0m"
+#define FMT_RED "\x1b[31m"
+#define FMT_GREEN "\x1b[32m"
+
+extern uint8_t fmt_machine;
+
+void fmt_char(const char c);
+void fmt_str(const char* s);
+void fmt_pad(const char* s, const uint8_t width);
+void fmt_hex(const uint32_t value, const uint8_t digits);
+void fmt_dec(const uint32_t value, const uint8_t width);
+void fmt_bin(const uint8_t value);
+void fmt_ms(const uint32_t us, const uint8_t width);
+void fmt_tag(const char* tag);
+void fmt_key(const char* tag, const char* key);
+void fmt_field(const char* key);
+void fmt_end(void);
+void fmt_line(const char* tag, const char* text);
+
+#endif	/* FMT_H */
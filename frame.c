@@ -0,0 +1,95 @@
+/*
+ * File:   frame.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Kept free of any AVR headers, so it can be built for the host as well.
+ */
+
+#include "frame.h"
+#include "crc.h"
+
+#define FRAME_STATE_SYNC 0
+#define FRAME_STATE_SEQUENCE 1
+#define FRAME_STATE_LENGTH_LOW 2
+#define FRAME_STATE_LENGTH_HIGH 3
+#define FRAME_STATE_DATA 4
+#define FRAME_STATE_CRC_LOW 5
+#define FRAME_STATE_CRC_HIGH 6
+
+void frame_reset(frame_t* frame) {
+    frame->state = FRAME_STATE_SYNC;
+}
+
+/**
+ * Feeds a single received byte to the parser.
+ * Returns FRAME_COMPLETE when a valid frame is available in frame->data 
+ * (frame->length bytes), FRAME_ERROR on CRC or length mismatch, 
+ * FRAME_INCOMPLETE otherwise. Bytes outside of a frame are skipped, so
+ * the parser resynchronizes on the next FRAME_SYNC.
+ */
+int8_t frame_feed(frame_t* frame, const uint8_t byte) {
+    switch (frame->state) {
+        case FRAME_STATE_SYNC:
+            if (byte == FRAME_SYNC) {
+                frame->crc = CRC16_INIT;
+                frame->state = FRAME_STATE_SEQUENCE;
+            }
+            return FRAME_INCOMPLETE;
+        case FRAME_STATE_SEQUENCE:
+            frame->sequence = byte;
+            frame->state = FRAME_STATE_LENGTH_LOW;
+            break;
+        case FRAME_STATE_LENGTH_LOW:
+            frame->length = byte;
+            frame->state = FRAME_STATE_LENGTH_HIGH;
+            break;
+        case FRAME_STATE_LENGTH_HIGH:
+            frame->length |= (uint16_t) byte << 8;
+            if ((frame->length == 0) || (frame->length > FRAME_DATA_MAX)) {
+                frame->state = FRAME_STATE_SYNC;
+                return FRAME_ERROR;
+            }
+            frame->index = 0;
+            frame->state = FRAME_STATE_DATA;
+            break;
+        case FRAME_STATE_DATA:
+            frame->data[frame->index++] = byte;
+            if (frame->index == frame->length) {
+                frame->state = FRAME_STATE_CRC_LOW;
+            }
+            break;
+        case FRAME_STATE_CRC_LOW:
+            frame->crc ^= byte;
+            frame->state = FRAME_STATE_CRC_HIGH;
+            return FRAME_INCOMPLETE;
+        case FRAME_STATE_CRC_HIGH:
+            frame->crc ^= (uint16_t) byte << 8;
+            frame->state = FRAME_STATE_SYNC;
+            return (frame->crc == 0) ? FRAME_COMPLETE : FRAME_ERROR;
+        default:
+            frame->state = FRAME_STATE_SYNC;
+            return FRAME_INCOMPLETE;
+    }
+    frame->crc = crc16_update(frame->crc, byte);
+    return FRAME_INCOMPLETE;
+}
+
+/**
+ * Encodes and writes a single frame, byte by byte.
+ */
+void frame_send(void (*write)(const uint8_t), const uint8_t sequence, const uint8_t opcode, 
+        const uint8_t* payload, const uint16_t length) {
+    uint8_t header[4] = { sequence, (length + 1) & 0xFF, (length + 1) >> 8, opcode };
+    uint16_t crc = CRC16_INIT;
+    write(FRAME_SYNC);
+    for (uint8_t i = 0; i < sizeof(header); i++) {
+        crc = crc16_update(crc, header[i]);
+        write(header[i]);
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        crc = crc16_update(crc, payload[i]);
+        write(payload[i]);
+    }
+    write(crc & 0xFF);
+    write(crc >> 8);
+}
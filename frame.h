@@ -0,0 +1,105 @@
+/* 
+ * File:   frame.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Binary host protocol framing, shared by the firmware and host tools.
+ * 
+ * Frame layout (multi-byte fields are little endian):
+ *   FRAME_SYNC | sequence | length (2) | opcode | payload (length - 1) | CRC-16 (2)
+ * Length counts the opcode and payload, CRC covers everything after the sync
+ * byte. Responses carry the request opcode with FRAME_OP_RESPONSE set, 
+ * the request sequence number and a FRAME_STATUS_* code as the first payload 
+ * byte.
+ */
+
+#ifndef FRAME_H
+#define	FRAME_H
+
+#include <stdint.h>
+
+#define FRAME_SYNC 0xEC
+
+/* Opcode and payload */
+#define FRAME_DATA_MAX 264
+
+#define FRAME_OP_RESPONSE 0x80
+
+#define FRAME_OP_PING 0x01              /* -> */
+#define FRAME_OP_TEXT 0x02              /* -> leaves binary mode */
+#define FRAME_OP_BAUD 0x03              /* baud rate (4) -> at the old rate, then
+                                           next frame has to come at the new rate */
+#define FRAME_OP_STATS 0x04             /* reset (1) -> window cycles (4), then count (4)
+                                           and cycles (4) per STATS_* counter; 
+                                           FRAME_STATUS_UNKNOWN if compiled out */
+#define FRAME_OP_ENTER 0x10             /* -> signature (3) */
+#define FRAME_OP_EXIT 0x11
+#define FRAME_OP_RUN 0x12
+#define FRAME_OP_ERASE 0x13
+#define FRAME_OP_GEOMETRY 0x14          /* -> Flash page words (1), Flash pages (2), 
+                                           EEPROM page size (1), EEPROM size (2) */
+#define FRAME_OP_WRITE_TIMES 0x15       /* -> per WRITE_* kind (../prog.h): longest 
+                                           measured duration (4), timeout (4), in us */
+#define FRAME_OP_READ_FUSES 0x20        /* -> low, high, extended, lock */
+#define FRAME_OP_WRITE_FUSE 0x21        /* FRAME_FUSE_*, value -> */
+#define FRAME_OP_SET_FUSES 0x22         /* select (1, bit per FRAME_FUSE_*), low, high, 
+                                           extended, lock -> written (1, bit per 
+                                           FRAME_FUSE_*), low, high, extended, lock 
+                                           read back; only differing bytes are written, 
+                                           lock last */
+#define FRAME_OP_WRITE_FLASH 0x30       /* word address (2), page data -> skipped (1) */
+#define FRAME_OP_READ_FLASH 0x31        /* byte address (4), length (2) -> data */
+#define FRAME_OP_READ_EEPROM 0x32       /* byte address (4), length (2) -> data */
+#define FRAME_OP_FLASH_UPDATE 0x33      /* enabled (1) -> compare pages before writing */
+#define FRAME_OP_CRC 0x34               /* FRAME_MEMORY_*, byte address (4), length (4) -> CRC-32 (4) */
+#define FRAME_OP_LZ_START 0x35         /* word address (2) -> starts a compressed 
+                                           Flash image (see lz.h) */
+#define FRAME_OP_LZ_DATA 0x36          /* compressed data -> */
+#define FRAME_OP_LZ_END 0x37           /* -> image length (4), pages (2), skipped (2) */
+#define FRAME_OP_WRITE_EEPROM 0x38      /* byte address (2), data -> pages written (2) */
+#define FRAME_OP_STORE_WRITE 0x40       /* image offset (4), data -> */
+#define FRAME_OP_STORE_COMMIT 0x41      /* signature (4), image length (4), page words (1), 
+                                           flags (1), fuses low, high, extended, lock (4) 
+                                           -> image CRC-32 (4) */
+#define FRAME_OP_JOB_RUN 0x42           /* -> result (1, JOB_* of ../job.h), steps done (1), 
+                                           last step opcode (1), target state (1), 
+                                           duration ms (4); FRAME_STATUS_FAILED without 
+                                           a stored job, FRAME_STATUS_STATE unless the 
+                                           target is powered down */
+
+#define FRAME_MEMORY_FLASH 0
+#define FRAME_MEMORY_EEPROM 1
+
+#define FRAME_FUSE_LOW 0
+#define FRAME_FUSE_HIGH 1
+#define FRAME_FUSE_EXTENDED 2
+#define FRAME_FUSE_LOCK 3
+
+#define FRAME_STATUS_OK 0x00
+#define FRAME_STATUS_FAILED 0x01
+#define FRAME_STATUS_UNKNOWN 0x02       /* Unknown opcode */
+#define FRAME_STATUS_STATE 0x03         /* Not allowed in current mode */
+#define FRAME_STATUS_ARGUMENT 0x04      /* Malformed payload */
+#define FRAME_STATUS_CRC 0x05           /* Corrupted frame, opcode unknown */
+#define FRAME_STATUS_TIMEOUT 0x06       /* Target did not complete a write */
+#define FRAME_STATUS_VERIFY 0x07        /* Written bits read back differ */
+
+#define FRAME_INCOMPLETE 0
+#define FRAME_COMPLETE 1
+#define FRAME_ERROR -1
+
+typedef struct {
+    uint8_t state;
+    uint8_t sequence;
+    uint16_t length;
+    uint16_t index;
+    uint16_t crc;
+    uint8_t data[FRAME_DATA_MAX];       /* opcode, payload */
+} frame_t;
+
+void frame_reset(frame_t* frame);
+int8_t frame_feed(frame_t* frame, const uint8_t byte);
+void frame_send(void (*write)(const uint8_t), const uint8_t sequence, const uint8_t opcode, 
+        const uint8_t* payload, const uint16_t length);
+
+#endif	/* FRAME_H */
+
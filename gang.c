@@ -0,0 +1,160 @@
+/*
+ * File:   gang.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include "gang.h"
+#include "twi.h"
+#include "prog.h"
+
+uint8_t gang_targets = 0;
+/* Targets configured by gang_enable() */
+static uint8_t gang_configured = 0;
+
+/* Expander output latches */
+static uint8_t gang_gates = 0;          /* GPA: WR gates, OE gates */
+static uint8_t gang_routes = 0;         /* GPB: 12V routes */
+
+static int8_t gang_register(const uint8_t address, const uint8_t value) {
+    if (twi_start(GANG_I2C_ADDRESS, TWI_WRITE) < 0) {
+        return GANG_ERROR_EXPANDER;
+    }
+    int8_t result = ((twi_write(address) < 0) || (twi_write(value) < 0)) ? GANG_ERROR_EXPANDER : GANG_OK;
+    twi_stop();
+    return result;
+}
+
+/**
+ * Turns gang mode on for targets 0..count-1, with WR gated to all of them,
+ * OE to the first one and 12V routed to all of them.
+ */
+int8_t gang_enable(const uint8_t count) {
+    const uint8_t mask = (1 << count) - 1;
+    gang_gates = mask | (1 << 4);
+    gang_routes = mask;
+    if ((gang_register(MCP23017_IODIRA, 0x00) < 0) ||
+        (gang_register(MCP23017_IODIRB, 0xF0) < 0) ||
+        (gang_register(MCP23017_OLATA, gang_gates) < 0) ||
+        (gang_register(MCP23017_OLATB, gang_routes) < 0)) {
+        gang_targets = 0;
+        return GANG_ERROR_EXPANDER;
+    }
+    gang_targets = mask;
+    gang_configured = mask;
+    return GANG_OK;
+}
+
+/**
+ * Brings back targets left out by gang_match(), before entering programming
+ * mode again.
+ */
+void gang_restore(void) {
+    gang_targets = gang_configured;
+    gang_write_select(gang_targets);
+    gang_read_select(gang_first());
+}
+
+/**
+ * Back to a single target, which is target 0 with everything routed to it.
+ * Also called at startup, when the expander pins are still inputs.
+ */
+void gang_disable(void) {
+    gang_targets = 0;
+    gang_configured = 0;
+    gang_gates = (1 << 0) | (1 << 4);
+    gang_routes = (1 << 0);
+    gang_register(MCP23017_IODIRA, 0x00);
+    gang_register(MCP23017_IODIRB, 0xF0);
+    gang_register(MCP23017_OLATA, gang_gates);
+    gang_register(MCP23017_OLATB, gang_routes);
+}
+
+/**
+ * Passes WR (and 12V) only to targets in mask, the others are left out
+ * of the following writes.
+ */
+int8_t gang_write_select(const uint8_t mask) {
+    gang_gates = (gang_gates & 0xF0) | mask;
+    gang_routes = mask;
+    if ((gang_register(MCP23017_OLATA, gang_gates) < 0) || 
+        (gang_register(MCP23017_OLATB, gang_routes) < 0)) {
+        return GANG_ERROR_EXPANDER;
+    }
+    return GANG_OK;
+}
+
+/**
+ * Passes OE to a single target, which is then the one all reads come from.
+ */
+int8_t gang_read_select(const uint8_t target) {
+    gang_gates = (gang_gates & 0x0F) | (1 << (4 + target));
+    return gang_register(MCP23017_OLATA, gang_gates);
+}
+
+/**
+ * Reads RDY/BSY of every target, bit n set when target n is ready.
+ */
+int8_t gang_ready(uint8_t* mask) {
+    if ((twi_start(GANG_I2C_ADDRESS, TWI_WRITE) < 0) || (twi_write(MCP23017_GPIOB) < 0) ||
+        (twi_start(GANG_I2C_ADDRESS, TWI_READ) < 0)) {
+        twi_stop();
+        return GANG_ERROR_EXPANDER;
+    }
+    *mask = twi_read(1) >> 4;
+    twi_stop();
+    return GANG_OK;
+}
+
+/**
+ * Lowest numbered target taking part.
+ */
+uint8_t gang_first(void) {
+    uint8_t target = 0;
+    while ((target < GANG_TARGETS_MAX - 1) && !(gang_targets & (1 << target))) {
+        target++;
+    }
+    return target;
+}
+
+/**
+ * Reads the signature of every target in programming mode and leaves out 
+ * targets which are missing or differ from the expected signature.
+ * Reads are left selected from the first remaining target.
+ * Returns the mask of remaining targets.
+ */
+uint8_t gang_match(const uint32_t signature) {
+    uint32_t found;
+    for (uint8_t target = 0; target < GANG_TARGETS_MAX; target++) {
+        if (!(gang_targets & (1 << target))) {
+            continue;
+        }
+        if (gang_read_select(target) < 0) {
+            found = 0;
+        } else {
+            read_signature(&found);
+        }
+        if (found != signature) {
+            gang_targets &= ~(1 << target);
+        }
+    }
+    gang_write_select(gang_targets);
+    gang_read_select(gang_first());
+    return gang_targets;
+}
+
+/**
+ * Compares CRC-32 of a Flash range of every target with crc.
+ * Returns the mask of targets which match.
+ */
+uint8_t gang_verify_flash(const uint32_t start, const uint32_t length, const uint32_t crc) {
+    uint8_t matching = 0;
+    for (uint8_t target = 0; target < GANG_TARGETS_MAX; target++) {
+        if ((gang_targets & (1 << target)) && (gang_read_select(target) == GANG_OK) &&
+            (read_flash_crc32(start, length) == crc)) {
+            matching |= 1 << target;
+        }
+    }
+    gang_read_select(gang_first());
+    return matching;
+}
+
@@ -0,0 +1,49 @@
+/* 
+ * File:   gang.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Gang programming: up to GANG_TARGETS_MAX targets share DATA, XA1, XA0, 
+ * BS1, BS2, XTAL1, PAGEL and power, while WR, OE and the 12V RESET supply
+ * are routed to each target separately through an MCP23017 I2C GPIO 
+ * expander on the TWI0 bus:
+ *   GPA0..3 - WR gate of target 0..3 (1 passes WR to the target)
+ *   GPA4..7 - OE gate of target 0..3 (1 passes OE to the target)
+ *   GPB0..3 - 12V route to RESET of target 0..3
+ *   GPB4..7 - RDY/BSY of target 0..3 (inputs)
+ * RDY/BSY of all targets are also AND-ed onto the RDY/BSY pin, so waiting
+ * for a write works as with a single target. Writes go to all targets at
+ * once, reads are taken from one target at a time.
+ */
+
+#ifndef GANG_H
+#define	GANG_H
+
+#include "config.h"
+
+#define GANG_I2C_ADDRESS 0x20           /* MCP23017, A2 = A1 = A0 = 0 */
+#define GANG_TARGETS_MAX 4
+
+/* MCP23017 registers, IOCON.BANK = 0 */
+#define MCP23017_IODIRA 0x00
+#define MCP23017_IODIRB 0x01
+#define MCP23017_GPIOB 0x13
+#define MCP23017_OLATA 0x14
+#define MCP23017_OLATB 0x15
+
+#define GANG_OK 0
+#define GANG_ERROR_EXPANDER -1          /* Expander does not respond */
+
+extern uint8_t gang_targets;            /* Targets taking part, 0 when gang mode is off */
+
+int8_t gang_enable(const uint8_t count);
+void gang_disable(void);
+void gang_restore(void);
+int8_t gang_write_select(const uint8_t mask);
+int8_t gang_read_select(const uint8_t target);
+int8_t gang_ready(uint8_t* mask);
+uint8_t gang_first(void);
+uint8_t gang_match(const uint32_t signature);
+uint8_t gang_verify_flash(const uint32_t start, const uint32_t length, const uint32_t crc);
+
+#endif	/* GANG_H */
+
@@ -0,0 +1,84 @@
+/* 
+ * File:   hal.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Programming bus hardware access. On AVR every macro is the plain register 
+ * access it stands for, so the generated code is unchanged; built for 
+ * the host with HAL_HOST, the same macros drive the simulated target 
+ * in host/sim.c.
+ */
+
+#ifndef HAL_H
+#define	HAL_H
+
+#ifdef HAL_HOST
+#include "sim.h"
+#else
+#include "config.h"
+
+/* Control signals on PORTD, bits PD_* */
+#define HAL_CONTROL_SET(bits) (VPORTD.OUT |= (bits))
+#define HAL_CONTROL_CLEAR(bits) (VPORTD.OUT &= ~(bits))
+#define HAL_CONTROL_LOAD(mask, bits) (VPORTD.OUT = (VPORTD.OUT & ~(mask)) | (bits))
+#define HAL_BS2_SET() (VPORTF.OUT |= PF_BS2_bm)
+#define HAL_BS2_CLEAR() (VPORTF.OUT &= ~PF_BS2_bm)
+
+/* DATA on PORTA */
+#define HAL_DATA_OUTPUT(data) { VPORTA.DIR = 0xFF; VPORTA.OUT = (data); }
+#define HAL_DATA_INPUT() (VPORTA.DIR = 0x00)
+#define HAL_DATA_READ() (VPORTA.IN)
+
+/* RDY/BSY, its rising edge raises the PORTF interrupt */
+#define HAL_READY() (VPORTF.IN & PF_RDY_BSY_bm)
+#define HAL_READY_FLAG() (PORTF.INTFLAGS & PF_RDY_BSY_bm)
+#define HAL_READY_FLAG_CLEAR() (PORTF.INTFLAGS = PF_RDY_BSY_bm)
+#define HAL_READY_ISR() ISR(PORTF_PORT_vect)
+#define HAL_READY_PULLDOWN() { PORTF.DIRSET = PF_RDY_BSY_bm; PORTF.OUTCLR = PF_RDY_BSY_bm; }
+#define HAL_READY_RELEASE() (PORTF.DIRCLR = PF_RDY_BSY_bm)
+
+/* Target supply and RESET, bits PF_* */
+#define HAL_SUPPLY_SET(bits) (PORTF.OUTSET = (bits))
+#define HAL_SUPPLY_CLEAR(bits) (PORTF.OUTCLR = (bits))
+
+/* PROGRAM button held, INVEN is enabled on this input */
+#define HAL_PROGRAM_PRESSED() (VPORTF.IN & PF_PROGRAM_bm)
+
+/* Drive control signals / release the whole bus to Hi-Z */
+#define HAL_BUS_CONTROL() { portd_control(); portf_control(); }
+#define HAL_BUS_RELEASE() { porta_init(); portd_init(); portf_init(); }
+
+/* Write timer, TCA0 counting at HAL_TIMER_HZ from HAL_TIMER_START(), its 
+   compare match at ticks raises an interrupt which wakes HAL_IDLE() */
+#define HAL_TIMER_HZ (F_CPU / 64)
+#define HAL_TIMER_START(ticks) { \
+    TCA0.SINGLE.CTRLA = 0; \
+    TCA0.SINGLE.CNT = 0; \
+    TCA0.SINGLE.CMP0 = (ticks); \
+    TCA0.SINGLE.INTFLAGS = TCA_SINGLE_CMP0_bm; \
+    TCA0.SINGLE.INTCTRL = TCA_SINGLE_CMP0_bm; \
+    TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV64_gc | TCA_SINGLE_ENABLE_bm; \
+}
+#define HAL_TIMER_STOP() { TCA0.SINGLE.CTRLA = 0; TCA0.SINGLE.INTCTRL = 0; }
+#define HAL_TIMER_TICKS() (TCA0.SINGLE.CNT)
+#define HAL_TIMER_FLAG_CLEAR() (TCA0.SINGLE.INTFLAGS = TCA_SINGLE_CMP0_bm)
+#define HAL_TIMER_ISR() ISR(TCA0_CMP0_vect)
+
+/* Coarse clock, RTC counting at HAL_CLOCK_HZ from the internal 32.768 kHz
+   oscillator, wraps after 64 s */
+#define HAL_CLOCK_HZ 1024
+#define HAL_CLOCK() (RTC.CNT)
+
+#define HAL_DELAY_CYCLES(cycles) __builtin_avr_delay_cycles(cycles)
+#define HAL_DELAY_US(us) _delay_us(us)
+#define HAL_DELAY_MS(ms) _delay_ms(ms)
+
+#define HAL_INTERRUPTS_DISABLE() cli()
+#define HAL_INTERRUPTS_ENABLE() sei()
+/* Sleeps until an interrupt, called with interrupts disabled; interrupts
+   are enabled only after the instruction following sei */
+#define HAL_IDLE() { sleep_enable(); sei(); sleep_cpu(); sleep_disable(); cli(); }
+
+#endif
+
+#endif	/* HAL_H */
+
@@ -0,0 +1,54 @@
+/*
+ * File:   baudtest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * BAUD register values of ../baud.h at F_CPU with CLK2X, for every rate
+ * host/ecp can negotiate (see link_speed() in eclink.c), and the resulting
+ * rate error against USART1_BAUD_ERROR_MAX.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "baud.h"
+
+static const struct {
+    uint32_t rate;
+    uint16_t baud;
+} rates[] = {
+    { 115200, 1667 },
+    { 230400, 833 },
+    { 460800, 417 },
+    { 500000, 384 },
+    { 921600, 208 },
+    { 1000000, 192 },
+    { 1500000, 128 },
+    { 2000000, 96 },
+};
+
+/* Out of the 16-bit register or below its 64 minimum */
+static const uint32_t unreachable[] = { 0, 300, 1200, 4000000, 6000000 };
+
+int main(void) {
+    int failures = 0;
+    for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        uint16_t baud = baud_register(F_CPU, rates[i].rate, USART1_BAUD_ERROR_MAX);
+        double actual = 8.0 * F_CPU / baud;
+        double error = 100.0 * (actual - rates[i].rate) / rates[i].rate;
+        printf("%7lu  BAUD %5u  actual %10.1f  error %+6.3f %%\n",
+                (unsigned long) rates[i].rate, baud, actual, error);
+        if ((baud != rates[i].baud) || (error <= -2.0) || (error >= 2.0)) {
+            fprintf(stderr, "baudtest: %lu expected BAUD %u\n",
+                    (unsigned long) rates[i].rate, rates[i].baud);
+            failures++;
+        }
+    }
+    for (uint8_t i = 0; i < sizeof(unreachable) / sizeof(unreachable[0]); i++) {
+        if (baud_register(F_CPU, unreachable[i], USART1_BAUD_ERROR_MAX)) {
+            fprintf(stderr, "baudtest: %lu accepted\n", (unsigned long) unreachable[i]);
+            failures++;
+        }
+    }
+    printf("baudtest %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+/*
+ * File:   crctest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * CRC-32 of ../crc.c against zlib's crc32(), which host/ecp compares
+ * target CRCs with: the empty buffer, the standard check string and random
+ * buffers of every length up to a few pages, also continued across calls.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <zlib.h>
+#include "crc.h"
+
+static uint32_t crc32_buffer(uint32_t crc, const uint8_t* data, const size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc = crc32_update(crc, data[i]);
+    }
+    return crc;
+}
+
+int main(void) {
+    int failures = 0;
+    static uint8_t buffer[1024];
+    srand(1);
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = rand() >> 7;
+    }
+
+    if (CRC32_FINAL(crc32_buffer(CRC32_INIT, buffer, 0)) != crc32(0, Z_NULL, 0)) {
+        fprintf(stderr, "crctest: empty buffer\n");
+        failures++;
+    }
+    uint32_t check = CRC32_FINAL(crc32_buffer(CRC32_INIT, (const uint8_t*) "123456789", 9));
+    if (check != 0xCBF43926UL) {
+        fprintf(stderr, "crctest: check value\n");
+        failures++;
+    }
+    for (size_t length = 1; length <= sizeof(buffer); length++) {
+        size_t offset = rand() % (sizeof(buffer) - length + 1);
+        uint32_t expected = crc32(crc32(0, Z_NULL, 0), buffer + offset, length);
+        uint32_t whole = CRC32_FINAL(crc32_buffer(CRC32_INIT, buffer + offset, length));
+        /* Continued, as read_flash_crc32() does across pages */
+        size_t split = rand() % (length + 1);
+        uint32_t crc = crc32_buffer(CRC32_INIT, buffer + offset, split);
+        uint32_t continued = CRC32_FINAL(crc32_buffer(crc, buffer + offset + split, length - split));
+        if ((whole != expected) || (continued != expected)) {
+            fprintf(stderr, "crctest: %zu bytes at %zu: %08lX, zlib %08lX\n", length, offset,
+                    (unsigned long) whole, (unsigned long) expected);
+            failures++;
+        }
+    }
+    printf("crctest %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+/*
+ * File:   dbtest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Device database of ../avr_database.h: records strictly ascending by 
+ * signature (so no signature appears twice), as the binary search of 
+ * lookup_signature() requires, and every record found by it. Geometry
+ * has to match the part: Flash pages times page size give the Flash size 
+ * coded in the middle signature byte (0x92 is 4 KB, 0x93 8 KB, ...), the 
+ * EEPROM is the size the family has for that Flash and is made of whole 
+ * pages, and page sizes fit the buffers of prog.c.
+ */
+
+#include "prog.h"
+
+#define DBTEST_RECORDS (sizeof(database) / sizeof(database[0]))
+
+static int failures = 0;
+
+static int power_of_two(const uint32_t value) {
+    return (value != 0) && !(value & (value - 1));
+}
+
+/**
+ * EEPROM bytes by Flash size of the supported families.
+ */
+static uint16_t eeprom_size(const uint32_t flash_size) {
+    switch (flash_size) {
+        case 4096: return 256;
+        case 8192: return 512;
+        case 16384: return 512;
+        case 32768: return 1024;
+        case 65536: return 2048;
+        case 131072: return 4096;
+    }
+    return 0;
+}
+
+static void fail(const avr_record* record, const char* what) {
+    fprintf(stderr, "dbtest: %06X %s: %s\n", record->signature, record->name, what);
+    failures++;
+}
+
+int main(void) {
+    for (uint16_t i = 0; i < DBTEST_RECORDS; i++) {
+        const avr_record* record = &database[i];
+        if ((i > 0) && (record->signature == database[i - 1].signature)) {
+            fail(record, "duplicate signature");
+        } else if ((i > 0) && (record->signature < database[i - 1].signature)) {
+            fail(record, "out of order");
+        }
+        /* Each translation unit has its own copy of the static table */
+        const avr_record* found = lookup_signature(record->signature);
+        if ((found == NULL) || (found->signature != record->signature) || 
+            (strcmp(found->name, record->name) != 0)) {
+            fail(record, "not found by lookup_signature()");
+        }
+        if ((lookup_signature(record->signature - 1) != NULL) && 
+            ((i == 0) || (database[i - 1].signature != record->signature - 1))) {
+            fail(record, "neighbouring signature found");
+        }
+        const uint32_t flash_size = 1024UL << (((record->signature >> 8) & 0xFF) - 0x90);
+        if (AVR_FLASH_SIZE(record) != flash_size) {
+            fail(record, "Flash pages times page size differ from the signature");
+        }
+        if (!power_of_two(record->flash_page_words) || (record->flash_page_words > FLASH_PAGE_WORDS_MAX)) {
+            fail(record, "Flash page size");
+        }
+        if (AVR_FLASH_WORDS(record) > 0x10000UL) {
+            fail(record, "Flash word addresses beyond 16 bits");
+        }
+        if (record->eeprom_size != eeprom_size(flash_size)) {
+            fail(record, "EEPROM size");
+        }
+        if (!power_of_two(record->eeprom_page_size) || (record->eeprom_size % record->eeprom_page_size)) {
+            fail(record, "EEPROM page size");
+        }
+    }
+    if ((lookup_signature(0) != NULL) || (lookup_signature(0xFFFFFF) != NULL)) {
+        fprintf(stderr, "dbtest: unknown signature found\n");
+        failures++;
+    }
+    printf("dbtest %u records %s\n", (unsigned) DBTEST_RECORDS, failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
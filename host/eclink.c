@@ -0,0 +1,268 @@
+/*
+ * File:   eclink.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "eclink.h"
+
+frame_t link_frame;
+int link_timeout_ms = LINK_TIMEOUT_MS;
+
+static int port = -1;
+static uint8_t sequence = 0;
+
+static uint8_t tx[FRAME_DATA_MAX + LINK_FRAME_OVERHEAD];
+static size_t tx_length;
+
+/* Requests sent and not answered yet, oldest first */
+typedef struct {
+    const char* what;
+    uint8_t sequence;
+    uint16_t size;                      /* Bytes on the wire */
+    link_handler handler;
+} link_pending;
+
+static link_pending window[LINK_WINDOW_MAX];
+static unsigned window_length = 0;
+static unsigned window_bytes = 0;       /* Of all but the oldest */
+
+static void tx_put(const uint8_t byte) {
+    tx[tx_length++] = byte;
+}
+
+speed_t link_speed(const unsigned long baudrate) {
+    switch (baudrate) {
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 500000: return B500000;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        default: return B0;
+    }
+}
+
+int link_set_speed(const speed_t baud) {
+    struct termios tio;
+    if (tcgetattr(port, &tio) < 0) {
+        return -1;
+    }
+    cfsetispeed(&tio, baud);
+    cfsetospeed(&tio, baud);
+    return tcsetattr(port, TCSADRAIN, &tio);
+}
+
+/**
+ * Opens the port raw at 115200 bps. Returns 0 or -1 with errno set.
+ */
+int link_open(const char* path) {
+    struct termios tio;
+    int fd = open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (tcgetattr(fd, &tio) < 0) {
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B115200);
+    cfsetospeed(&tio, B115200);
+    tio.c_cflag |= CLOCAL | CREAD;
+    if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    port = fd;
+    frame_reset(&link_frame);
+    return 0;
+}
+
+void link_close(void) {
+    close(port);
+    port = -1;
+}
+
+int link_write(const void* data, size_t length) {
+    const uint8_t* p = data;
+    while (length > 0) {
+        ssize_t r = write(port, p, length);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += r;
+        length -= r;
+    }
+    return 0;
+}
+
+/**
+ * Receives bytes until a frame with given sequence number is complete, the
+ * bytes read past it are kept for the next response. Returns 0 on success,
+ * -1 on timeout or I/O error.
+ */
+static int receive(const uint8_t expected_sequence) {
+    static uint8_t buffer[256];
+    static size_t head = 0, length = 0;
+    struct pollfd pfd = { .fd = port, .events = POLLIN };
+    while (1) {
+        while (head < length) {
+            if ((frame_feed(&link_frame, buffer[head++]) == FRAME_COMPLETE) &&
+                (link_frame.sequence == expected_sequence)) {
+                return 0;
+            }
+        }
+        if (poll(&pfd, 1, link_timeout_ms) <= 0) {
+            return -1;
+        }
+        ssize_t n = read(port, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return -1;
+        }
+        head = 0;
+        length = n;
+    }
+}
+
+/**
+ * Receives the response to the oldest request in the window. Returns its
+ * FRAME_STATUS_* or -1 on communication failure, which empties the window;
+ * a failing handler turns the status into FRAME_STATUS_FAILED.
+ */
+static int complete(void) {
+    link_pending pending = window[0];
+    window_length--;
+    for (unsigned i = 0; i < window_length; i++) {
+        window[i] = window[i + 1];
+    }
+    if (window_length > 0) {
+        window_bytes -= window[0].size;
+    }
+    if (receive(pending.sequence) < 0) {
+        /* Nothing else will come either */
+        window_length = 0;
+        window_bytes = 0;
+        return -1;
+    }
+    if ((link_frame.length < 2) || (link_frame.data[0] == FRAME_OP_RESPONSE)) {
+        return -1;
+    }
+    int status = link_frame.data[1];
+    if ((status == FRAME_STATUS_OK) && (pending.handler != NULL) &&
+        (pending.handler(link_frame.data + 2, link_frame.length - 2) < 0)) {
+        status = FRAME_STATUS_FAILED;
+    }
+    return status;
+}
+
+static int transmit(const uint8_t opcode, const uint8_t* payload, const uint16_t length) {
+    sequence++;
+    tx_length = 0;
+    frame_send(tx_put, sequence, opcode, payload, length);
+    return link_write(tx, tx_length);
+}
+
+/**
+ * Waits for the oldest response in flight. On failure, prints it and
+ * waits for the rest, which are not checked. Returns 0 or -1.
+ */
+static int drain_one(void) {
+    const char* what = window[0].what;
+    if (link_check(what, complete()) < 0) {
+        while (window_length > 0) {
+            complete();
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Waits for all responses in flight. Returns 0, or -1 with the first
+ * failure printed.
+ */
+int link_drain(void) {
+    while (window_length > 0) {
+        if (drain_one() < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Sends a request and waits for its response, after the ones in flight.
+ * Response payload (without status byte) is left in link_frame.data + 2,
+ * its length in link_frame.length - 2.
+ * Returns FRAME_STATUS_* or -1 on communication failure.
+ */
+int link_request(const uint8_t opcode, const uint8_t* payload, const uint16_t length) {
+    if (link_drain() < 0) {
+        return -1;
+    }
+    if (transmit(opcode, payload, length) < 0) {
+        return -1;
+    }
+    window[0] = (link_pending) { NULL, sequence, length + LINK_FRAME_OVERHEAD, NULL };
+    window_length = 1;
+    return complete();
+}
+
+/**
+ * Sends a request without waiting for its response, unless the programmer
+ * could not buffer it: all frames but the one being processed have to fit
+ * in its RX ring. Returns 0, or -1 with the failure printed; the rest of
+ * the window is drained then.
+ */
+int link_post(const char* what, const uint8_t opcode, const uint8_t* payload, const uint16_t length,
+        link_handler handler) {
+    const uint16_t size = length + LINK_FRAME_OVERHEAD;
+    while ((window_length == LINK_WINDOW_MAX) ||
+        ((window_length > 0) && (window_bytes + size > LINK_RX_BUFFER))) {
+        if (drain_one() < 0) {
+            return -1;
+        }
+    }
+    if (transmit(opcode, payload, length) < 0) {
+        link_check(what, -1);
+        return -1;
+    }
+    if (window_length > 0) {
+        window_bytes += size;
+    }
+    window[window_length++] = (link_pending) { what, sequence, size, handler };
+    return 0;
+}
+
+const char* link_status_name(const int status) {
+    switch (status) {
+        case FRAME_STATUS_OK: return "ok";
+        case FRAME_STATUS_FAILED: return "failed";
+        case FRAME_STATUS_UNKNOWN: return "unknown opcode";
+        case FRAME_STATUS_STATE: return "not allowed in current mode";
+        case FRAME_STATUS_ARGUMENT: return "invalid argument";
+        case FRAME_STATUS_CRC: return "corrupted frame";
+        case FRAME_STATUS_TIMEOUT: return "target does not respond (RDY/BSY timeout)";
+        case FRAME_STATUS_VERIFY: return "read back differs";
+        default: return "no response";
+    }
+}
+
+int link_check(const char* what, const int status) {
+    if (status != FRAME_STATUS_OK) {
+        fprintf(stderr, "%s: %s\n", what, link_status_name(status));
+        return -1;
+    }
+    return 0;
+}
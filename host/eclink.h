@@ -0,0 +1,51 @@
+/*
+ * File:   eclink.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Host side of the binary framed protocol (see ../frame.h): serial port
+ * setup, requests and pipelined requests.
+ *
+ * link_request() sends one request and waits for its response. link_post()
+ * only waits when the window is full, so the programmer works on the next
+ * page while the previous response is on its way; responses come in order
+ * and are passed to the handler given with their request. The programmer
+ * has no flow control: frames queued behind the one being processed wait
+ * in its USART1 RX ring, so the window is bounded by bytes, not frames.
+ */
+
+#ifndef ECLINK_H
+#define	ECLINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <termios.h>
+
+#include "frame.h"
+
+#define LINK_TIMEOUT_MS 5000
+/* USART1_RX_BUFFER_SIZE in ../config.h */
+#define LINK_RX_BUFFER 256
+#define LINK_WINDOW_MAX 8
+/* Sync, sequence, length (2) and CRC-16 (2) around opcode and payload */
+#define LINK_FRAME_OVERHEAD 6
+
+/* Gets the response payload after the status byte; 0 or -1 to fail the transfer */
+typedef int (*link_handler)(const uint8_t* data, const uint16_t length);
+
+/* Last response received */
+extern frame_t link_frame;
+extern int link_timeout_ms;
+
+int link_open(const char* path);
+void link_close(void);
+speed_t link_speed(const unsigned long baudrate);
+int link_set_speed(const speed_t baud);
+int link_write(const void* data, size_t length);
+int link_request(const uint8_t opcode, const uint8_t* payload, const uint16_t length);
+int link_post(const char* what, const uint8_t opcode, const uint8_t* payload, const uint16_t length,
+        link_handler handler);
+int link_drain(void);
+const char* link_status_name(const int status);
+int link_check(const char* what, const int status);
+
+#endif	/* ECLINK_H */
@@ -0,0 +1,659 @@
+/*
+ * File:   ecp.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Reference client for the binary framed protocol (see ../frame.h and eclink.h).
+ * 
+ *   ecp [-p port | -l] [-b baud] [-P page_words] [-u] [-z] command [arguments]
+ * 
+ * -u writes Flash in update mode (without chip erase), only pages which 
+ * differ are written.
+ * -z sends Flash images compressed (see ../lz.h), decompressed by 
+ * the programmer.
+ * -P overrides the Flash page size reported by the programmer for the target; 
+ * it is required by store, which does not need a target.
+ * -l runs against the firmware built for Linux (ecloop, see loop.c) instead
+ * of a programmer, the simulated target is set by ECLOOP_SIGNATURE.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "crc.h"
+#include "eclink.h"
+#include "frame.h"
+#include "job.h"
+#include "lz.h"
+#include "lzc.h"
+
+/* A job responds only when the whole flow is done */
+#define JOB_TIMEOUT_MS 120000
+/* Matches FLASH_PAGE_WORDS_MAX in ../prog.h */
+#define FLASH_PAGE_WORDS_MAX_HOST 128
+
+static void put32(uint8_t* data, const uint32_t value);
+
+/**
+ * Switches both sides to a new baud rate. The programmer falls back to the
+ * old rate if the ping following the switch does not arrive.
+ */
+static int negotiate(const unsigned long baudrate) {
+    uint8_t payload[4];
+    speed_t baud = link_speed(baudrate);
+    if (baud == B0) {
+        fprintf(stderr, "baud: unsupported rate %lu\n", baudrate);
+        return -1;
+    }
+    put32(payload, baudrate);
+    if (link_check("baud", link_request(FRAME_OP_BAUD, payload, sizeof(payload))) < 0) {
+        return -1;
+    }
+    if (link_set_speed(baud) < 0) {
+        perror("baud");
+        return -1;
+    }
+    return link_check("ping", link_request(FRAME_OP_PING, NULL, 0));
+}
+
+static void put16(uint8_t* data, const uint16_t value) {
+    data[0] = value & 0xFF;
+    data[1] = value >> 8;
+}
+
+static void put32(uint8_t* data, const uint32_t value) {
+    put16(data, value & 0xFFFF);
+    put16(data + 2, value >> 16);
+}
+
+static FILE* read_out;
+
+static int read_chunk(const uint8_t* data, const uint16_t length) {
+    return (fwrite(data, 1, length, read_out) == length) ? 0 : -1;
+}
+
+static int cmd_read(const uint8_t opcode, uint32_t start, uint32_t length, FILE* out) {
+    uint8_t payload[6];
+    read_out = out;
+    while (length > 0) {
+        uint16_t chunk = (length > 256) ? 256 : length;
+        put32(payload, start);
+        put16(payload + 4, chunk);
+        if (link_post("read", opcode, payload, sizeof(payload), read_chunk) < 0) {
+            return -1;
+        }
+        start += chunk;
+        length -= chunk;
+    }
+    return link_drain();
+}
+
+static unsigned write_count;
+
+static int write_skipped(const uint8_t* data, const uint16_t length) {
+    write_count += (length > 0) && data[0];
+    return 0;
+}
+
+/**
+ * Writes the file to Flash from address 0, page after page without waiting
+ * for each one to be written.
+ */
+static int cmd_write_flash(FILE* in, const unsigned page_words, const int update) {
+    uint8_t payload[2 + 2 * FLASH_PAGE_WORDS_MAX_HOST];
+    uint32_t address = 0;
+    unsigned pages = 0;
+    size_t n;
+    payload[0] = update;
+    if (link_check("update", link_request(FRAME_OP_FLASH_UPDATE, payload, 1)) < 0) {
+        return -1;
+    }
+    memset(payload, 0xFF, sizeof(payload));
+    write_count = 0;
+    while ((n = fread(payload + 2, 1, 2 * page_words, in)) > 0) {
+        memset(payload + 2 + n, 0xFF, 2 * page_words - n);
+        put16(payload, address);
+        if (link_post("write", FRAME_OP_WRITE_FLASH, payload, 2 + 2 * page_words, write_skipped) < 0) {
+            return -1;
+        }
+        pages++;
+        address += page_words;
+    }
+    /* Any request finishes page programming */
+    if ((link_drain() < 0) || (link_check("write", link_request(FRAME_OP_PING, NULL, 0)) < 0)) {
+        return -1;
+    }
+    printf("%u pages, %u skipped\n", pages, write_count);
+    return 0;
+}
+
+static uint8_t* decoded;
+static size_t decoded_length;
+
+static int8_t decoded_put(const uint8_t byte) {
+    decoded[decoded_length++] = byte;
+    return LZ_OK;
+}
+
+/**
+ * Decodes the compressed stream the way the programmer will, to make sure 
+ * it reproduces the image before anything is written.
+ */
+static int lz_check(const uint8_t* image, const size_t length, const uint8_t* stream, 
+        const size_t stream_length) {
+    static lz_decoder decoder;
+    decoded = malloc(length + LZ_MATCH_MAX);
+    if (decoded == NULL) {
+        return -1;
+    }
+    decoded_length = 0;
+    lz_reset(&decoder);
+    for (size_t i = 0; (i < stream_length) && (decoded_length <= length); i++) {
+        lz_feed(&decoder, stream[i], decoded_put);
+    }
+    int result = ((decoded_length == length) && (memcmp(decoded, image, length) == 0)) ? 0 : -1;
+    free(decoded);
+    return result;
+}
+
+static int cmd_write_flash_lz(FILE* in, const int update) {
+    uint8_t payload[FRAME_DATA_MAX - 1];
+    uint8_t *image = NULL, *stream = NULL;
+    size_t length = 0, stream_length, n;
+    int result = -1;
+    while (!feof(in)) {
+        uint8_t* grown = realloc(image, length + 65536);
+        if (grown == NULL) {
+            goto out;
+        }
+        image = grown;
+        length += fread(image + length, 1, 65536, in);
+    }
+    stream = malloc(LZC_BOUND(length));
+    if (stream == NULL) {
+        goto out;
+    }
+    stream_length = lz_compress(image, length, stream);
+    if (lz_check(image, length, stream, stream_length) < 0) {
+        fprintf(stderr, "write: compressed stream does not decode to the image\n");
+        goto out;
+    }
+    payload[0] = update;
+    if (link_check("update", link_request(FRAME_OP_FLASH_UPDATE, payload, 1)) < 0) {
+        goto out;
+    }
+    put16(payload, 0);
+    if (link_check("write", link_request(FRAME_OP_LZ_START, payload, 2)) < 0) {
+        goto out;
+    }
+    for (size_t i = 0; i < stream_length; i += n) {
+        n = stream_length - i;
+        if (n > sizeof(payload)) {
+            n = sizeof(payload);
+        }
+        if (link_post("write", FRAME_OP_LZ_DATA, stream + i, n, NULL) < 0) {
+            goto out;
+        }
+    }
+    if ((link_drain() < 0) || (link_check("write", link_request(FRAME_OP_LZ_END, NULL, 0)) < 0)) {
+        goto out;
+    }
+    uint32_t written = link_frame.data[2] | (link_frame.data[3] << 8) | (link_frame.data[4] << 16) | 
+        ((uint32_t) link_frame.data[5] << 24);
+    if (written != length) {
+        fprintf(stderr, "write: programmer decoded %u of %zu bytes\n", written, length);
+        goto out;
+    }
+    printf("%u pages, %u skipped, %zu bytes sent as %zu\n", 
+        link_frame.data[6] | (link_frame.data[7] << 8), link_frame.data[8] | (link_frame.data[9] << 8), 
+        length, stream_length);
+    result = 0;
+out:
+    free(stream);
+    free(image);
+    return result;
+}
+
+/**
+ * Writes the file to EEPROM from address 0; the programmer skips pages which
+ * already hold the data.
+ */
+static int write_pages(const uint8_t* data, const uint16_t length) {
+    write_count += (length >= 2) ? (data[0] | (data[1] << 8)) : 0;
+    return 0;
+}
+
+static int cmd_write_eeprom(FILE* in) {
+    uint8_t payload[2 + 256];
+    uint16_t address = 0;
+    size_t n;
+    write_count = 0;
+    while ((n = fread(payload + 2, 1, 256, in)) > 0) {
+        put16(payload, address);
+        if (link_post("write", FRAME_OP_WRITE_EEPROM, payload, 2 + n, write_pages) < 0) {
+            return -1;
+        }
+        address += n;
+    }
+    if (link_drain() < 0) {
+        return -1;
+    }
+    printf("%u bytes, %u pages written\n", address, write_count);
+    return 0;
+}
+
+/**
+ * Compares CRC-32 of the file with CRC-32 computed by the programmer over
+ * the same range, starting at address 0.
+ */
+static int cmd_verify(const uint8_t memory, FILE* in) {
+    uint8_t payload[9];
+    uint32_t crc = CRC32_INIT, length = 0;
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        crc = crc32_update(crc, c);
+        length++;
+    }
+    crc = CRC32_FINAL(crc);
+    payload[0] = memory;
+    put32(payload + 1, 0);
+    put32(payload + 5, length);
+    if (link_check("verify", link_request(FRAME_OP_CRC, payload, sizeof(payload))) < 0) {
+        return -1;
+    }
+    uint32_t device = link_frame.data[2] | (link_frame.data[3] << 8) | (link_frame.data[4] << 16) | 
+        ((uint32_t) link_frame.data[5] << 24);
+    if (device != crc) {
+        fprintf(stderr, "verify: CRC-32 mismatch, file %08X, device %08X\n", crc, device);
+        return -1;
+    }
+    printf("verified %u bytes, CRC-32 %08X\n", length, crc);
+    return 0;
+}
+
+/**
+ * Uploads an image to the standalone store, optionally with fuse settings.
+ */
+static int cmd_store(FILE* in, const unsigned page_words, const uint32_t signature, 
+        const int fuses, const uint8_t* fuse) {
+    uint8_t payload[4 + 128];
+    uint32_t crc = CRC32_INIT, length = 0;
+    size_t n;
+    while ((n = fread(payload + 4, 1, 128, in)) > 0) {
+        put32(payload, length);
+        if (link_post("store", FRAME_OP_STORE_WRITE, payload, 4 + n, NULL) < 0) {
+            return -1;
+        }
+        for (size_t i = 0; i < n; i++) {
+            crc = crc32_update(crc, payload[4 + i]);
+        }
+        length += n;
+    }
+    if (link_drain() < 0) {
+        return -1;
+    }
+    crc = CRC32_FINAL(crc);
+    put32(payload, signature);
+    put32(payload + 4, length);
+    payload[8] = page_words;
+    payload[9] = fuses ? 1 : 0; /* STORE_FLAG_FUSES */
+    memcpy(payload + 10, fuse, 4);
+    if (link_check("store", link_request(FRAME_OP_STORE_COMMIT, payload, 14)) < 0) {
+        return -1;
+    }
+    uint32_t stored = link_frame.data[2] | (link_frame.data[3] << 8) | (link_frame.data[4] << 16) | 
+        ((uint32_t) link_frame.data[5] << 24);
+    if (stored != crc) {
+        fprintf(stderr, "store: CRC-32 mismatch, file %08X, store %08X\n", crc, stored);
+        return -1;
+    }
+    printf("stored %u bytes, CRC-32 %08X\n", length, crc);
+    return 0;
+}
+
+/**
+ * Asks the programmer for the Flash page size of the target.
+ */
+static int device_page_words(unsigned* page_words) {
+    if (link_check("geometry", link_request(FRAME_OP_GEOMETRY, NULL, 0)) < 0) {
+        return -1;
+    }
+    *page_words = link_frame.data[2];
+    return 0;
+}
+
+static uint32_t get32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+/**
+ * Prints bus and link counters of the programmer (firmware built with 
+ * STATS_ENABLED), cycles are converted at the 24 MHz programmer clock.
+ */
+static int cmd_stats(const int reset) {
+    /* In the order of STATS_* in ../stats.h */
+    static const char* const names[] = {
+        "bus load", "bus latch", "bus write", "bus read", "target busy", "uart tx", "uart rx"
+    };
+    uint8_t payload = reset;
+    if (link_check("stats", link_request(FRAME_OP_STATS, &payload, 1)) < 0) {
+        return -1;
+    }
+    const uint8_t* data = link_frame.data + 2;
+    const unsigned counters = (link_frame.length - 6) / 8;
+    double window = get32(data) / 24e3;
+    printf("window %.3f ms\n", window);
+    for (unsigned i = 0; i < counters; i++) {
+        double ms = get32(data + 8 + 8 * i) / 24e3;
+        printf("%-12s %10u x %12.3f ms %5.1f %%\n", 
+            (i < sizeof(names) / sizeof(names[0])) ? names[i] : "?",
+            get32(data + 4 + 8 * i), ms, (window > 0) ? 100 * ms / window : 0);
+    }
+    return 0;
+}
+
+/**
+ * Prints the longest measured write times of the target and their timeouts.
+ */
+static int cmd_timing(void) {
+    /* In the order of WRITE_* in ../prog.h */
+    static const char* const kinds[] = { "erase", "flash page", "eeprom page", "fuse, lock" };
+    if (link_check("timing", link_request(FRAME_OP_WRITE_TIMES, NULL, 0)) < 0) {
+        return -1;
+    }
+    for (unsigned i = 0; (i < sizeof(kinds) / sizeof(kinds[0])) && (8 * i + 8 <= link_frame.length - 2u); i++) {
+        printf("%-12s %8.3f ms, timeout %8.3f ms\n", kinds[i], 
+            get32(link_frame.data + 2 + 8 * i) / 1e3, get32(link_frame.data + 6 + 8 * i) / 1e3);
+    }
+    return 0;
+}
+
+/**
+ * Writes name=value fuse/lock arguments in one transaction, the programmer
+ * skips bytes which already hold the value.
+ */
+static int cmd_fuse_set(const int argc, char** argv) {
+    /* In the order of FRAME_FUSE_* */
+    static const char* const names[] = { "low", "high", "extended", "lock" };
+    uint8_t payload[5] = { 0, 0xFF, 0xFF, 0xFF, 0xFF };
+    for (int i = 0; i < argc; i++) {
+        char* value = strchr(argv[i], '=');
+        unsigned n;
+        for (n = 0; n < 4; n++) {
+            if ((value != NULL) && (strlen(names[n]) == (size_t) (value - argv[i])) &&
+                (strncmp(argv[i], names[n], value - argv[i]) == 0)) {
+                break;
+            }
+        }
+        if (n == 4) {
+            fprintf(stderr, "fuse set: expected low=XX, high=XX, extended=XX or lock=XX\n");
+            return -1;
+        }
+        payload[0] |= 1 << n;
+        payload[1 + n] = strtoul(value + 1, NULL, 16);
+    }
+    if (link_check("fuse set", link_request(FRAME_OP_SET_FUSES, payload, 5)) < 0) {
+        return -1;
+    }
+    for (unsigned n = 0; n < 4; n++) {
+        if (payload[0] & (1 << n)) {
+            printf("%-8s %02X %s\n", names[n], link_frame.data[3 + n], 
+                (link_frame.data[2] & (1 << n)) ? "written" : "unchanged");
+        }
+    }
+    return 0;
+}
+
+/**
+ * Runs the job script stored on the programmer, one request for the whole
+ * per-board flow.
+ */
+static int cmd_job_run(void) {
+    /* In the order of JOB_OP_* and JOB_ERROR_* in ../job.h */
+    static const char* const ops[] = { "none", "enter", "erase", "write flash", "write eeprom", 
+        "verify flash", "verify eeprom", "fuse", "delay", "exit", "run" };
+    static const char* const errors[] = { "malformed step", "not allowed in this target state",
+        "signature does not match", "store read failed", "write failed", "verification failed" };
+    link_timeout_ms = JOB_TIMEOUT_MS;
+    int status = link_request(FRAME_OP_JOB_RUN, NULL, 0);
+    link_timeout_ms = LINK_TIMEOUT_MS;
+    if (link_check("job", status) < 0) {
+        return -1;
+    }
+    int8_t result = link_frame.data[2];
+    uint8_t step = link_frame.data[3], op = link_frame.data[4];
+    uint32_t ms = get32(link_frame.data + 6);
+    if (result == JOB_OK) {
+        printf("job done, %u steps in %u ms\n", step, ms);
+        return 0;
+    }
+    fprintf(stderr, "job: step %u (%s) %s after %u ms\n", step + 1, 
+        (op < sizeof(ops) / sizeof(ops[0])) ? ops[op] : "?",
+        ((result < 0) && (-result <= (int) (sizeof(errors) / sizeof(errors[0])))) ? errors[-1 - result] : "failed", 
+        ms);
+    return -1;
+}
+
+/**
+ * Starts ecloop, looked up next to ecp, on a new pty and opens its slave
+ * side as the port. ecloop ends when the port is closed.
+ */
+static int loopback(const char* self) {
+    char program[4096], fd[16];
+    const char* slash = strrchr(self, '/');
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((master < 0) || (grantpt(master) < 0) || (unlockpt(master) < 0) ||
+        (link_open(ptsname(master)) < 0)) {
+        perror("loopback");
+        return -1;
+    }
+    snprintf(program, sizeof(program), "%.*secloop", (slash != NULL) ? (int) (slash - self + 1) : 0, self);
+    snprintf(fd, sizeof(fd), "%d", master);
+    pid_t pid = fork();
+    if (pid == 0) {
+        setenv("ECLOOP_FD", fd, 1);
+        execlp(program, program, (char*) NULL);
+        perror(program);
+        _exit(127);
+    }
+    close(master);
+    if (pid < 0) {
+        perror("loopback");
+        link_close();
+        return -1;
+    }
+    return 0;
+}
+
+static void usage(void) {
+    fprintf(stderr, 
+        "usage: ecp [-p port | -l] [-b baud] [-P page_words] [-u] [-z] command [arguments]\n"
+        "commands:\n"
+        "  ping | enter | exit | run | erase | fuses | timing | stats [reset] | job run\n"
+        "  fuse low|high|extended|lock <value>\n"
+        "  fuse set [low=XX] [high=XX] [extended=XX] [lock=XX]\n"
+        "  read flash|eeprom <start> <length> [file]\n"
+        "  write flash|eeprom <file>\n"
+        "  verify flash|eeprom <file>\n"
+        "  store <file> <signature> [<low> <high> <extended> [<lock>]]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* path = "/dev/ttyACM0";
+    const char* self = argv[0];
+    unsigned page_words = 0;
+    unsigned long baudrate = 0;
+    int opt, result = 0, update = 0, compress = 0, loop = 0;
+    while ((opt = getopt(argc, argv, "p:b:P:uzl")) != -1) {
+        switch (opt) {
+            case 'p':
+                path = optarg;
+                break;
+            case 'l':
+                loop = 1;
+                break;
+            case 'u':
+                update = 1;
+                break;
+            case 'z':
+                compress = 1;
+                break;
+            case 'b':
+                baudrate = strtoul(optarg, NULL, 10);
+                break;
+            case 'P':
+                page_words = strtoul(optarg, NULL, 0);
+                if ((page_words == 0) || (page_words > FLASH_PAGE_WORDS_MAX_HOST)) {
+                    fprintf(stderr, "invalid page size\n");
+                    return 2;
+                }
+                break;
+            default:
+                usage();
+                return 2;
+        }
+    }
+    argc -= optind;
+    argv += optind;
+    if (argc < 1) {
+        usage();
+        return 2;
+    }
+    if (loop) {
+        if (loopback(self) < 0) {
+            return 1;
+        }
+    } else if (link_open(path) < 0) {
+        perror(path);
+        return 1;
+    }
+    /* Switch the console to binary mode; echo and text response are skipped
+       by the frame parser */
+    if ((link_write("\rmode binary\r", 13) < 0) || 
+        (link_check("ping", link_request(FRAME_OP_PING, NULL, 0)) < 0) ||
+        ((baudrate != 0) && (negotiate(baudrate) < 0))) {
+        link_close();
+        return 1;
+    }
+    const char* command = argv[0];
+    if (strcmp(command, "ping") == 0) {
+        puts("ok");
+    } else if (strcmp(command, "enter") == 0) {
+        result = link_check("enter", link_request(FRAME_OP_ENTER, NULL, 0));
+        if (result == 0) {
+            printf("signature %02X%02X%02X\n", link_frame.data[2], link_frame.data[3], link_frame.data[4]);
+        }
+    } else if (strcmp(command, "exit") == 0) {
+        result = link_check("exit", link_request(FRAME_OP_EXIT, NULL, 0));
+    } else if (strcmp(command, "run") == 0) {
+        result = link_check("run", link_request(FRAME_OP_RUN, NULL, 0));
+    } else if (strcmp(command, "erase") == 0) {
+        result = link_check("erase", link_request(FRAME_OP_ERASE, NULL, 0));
+    } else if ((strcmp(command, "stats") == 0) && 
+            ((argc == 1) || ((argc == 2) && (strcmp(argv[1], "reset") == 0)))) {
+        result = cmd_stats(argc == 2);
+    } else if (strcmp(command, "timing") == 0) {
+        result = cmd_timing();
+    } else if ((strcmp(command, "job") == 0) && (argc == 2) && (strcmp(argv[1], "run") == 0)) {
+        result = cmd_job_run();
+    } else if (strcmp(command, "fuses") == 0) {
+        result = link_check("fuses", link_request(FRAME_OP_READ_FUSES, NULL, 0));
+        if (result == 0) {
+            printf("low %02X\nhigh %02X\nextended %02X\nlock %02X\n",
+                link_frame.data[2], link_frame.data[3], link_frame.data[4], link_frame.data[5]);
+        }
+    } else if ((strcmp(command, "fuse") == 0) && (argc >= 3) && (strcmp(argv[1], "set") == 0)) {
+        result = cmd_fuse_set(argc - 2, argv + 2);
+    } else if ((strcmp(command, "fuse") == 0) && (argc == 3)) {
+        uint8_t payload[2] = { 0, strtoul(argv[2], NULL, 16) };
+        if (strcmp(argv[1], "high") == 0) {
+            payload[0] = FRAME_FUSE_HIGH;
+        } else if (strcmp(argv[1], "extended") == 0) {
+            payload[0] = FRAME_FUSE_EXTENDED;
+        } else if (strcmp(argv[1], "lock") == 0) {
+            payload[0] = FRAME_FUSE_LOCK;
+        } else if (strcmp(argv[1], "low") != 0) {
+            usage();
+            result = -1;
+        }
+        if (result == 0) {
+            result = link_check("fuse", link_request(FRAME_OP_WRITE_FUSE, payload, 2));
+        }
+    } else if ((strcmp(command, "read") == 0) && ((argc == 4) || (argc == 5))) {
+        FILE* out = (argc == 5) ? fopen(argv[4], "wb") : stdout;
+        if (out == NULL) {
+            perror(argv[4]);
+            result = -1;
+        } else {
+            result = cmd_read(
+                (strcmp(argv[1], "eeprom") == 0) ? FRAME_OP_READ_EEPROM : FRAME_OP_READ_FLASH,
+                strtoul(argv[2], NULL, 16), strtoul(argv[3], NULL, 16), out);
+            if (out != stdout) {
+                fclose(out);
+            }
+        }
+    } else if ((strcmp(command, "write") == 0) && (argc == 3) && (strcmp(argv[1], "eeprom") == 0)) {
+        FILE* in = fopen(argv[2], "rb");
+        if (in == NULL) {
+            perror(argv[2]);
+            result = -1;
+        } else {
+            result = cmd_write_eeprom(in);
+            fclose(in);
+        }
+    } else if ((strcmp(command, "write") == 0) && (argc == 3) && (strcmp(argv[1], "flash") == 0)) {
+        FILE* in = fopen(argv[2], "rb");
+        if (in == NULL) {
+            perror(argv[2]);
+            result = -1;
+        } else {
+            if (compress) {
+                result = cmd_write_flash_lz(in, update);
+            } else if ((page_words != 0) || (device_page_words(&page_words) == 0)) {
+                result = cmd_write_flash(in, page_words, update);
+            } else {
+                result = -1;
+            }
+            fclose(in);
+        }
+    } else if ((strcmp(command, "store") == 0) && ((argc == 3) || (argc == 6) || (argc == 7))) {
+        uint8_t fuse[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+        FILE* in = fopen(argv[1], "rb");
+        if (argc >= 6) {
+            for (int i = 0; i < argc - 3; i++) {
+                fuse[i] = strtoul(argv[3 + i], NULL, 16);
+            }
+        }
+        if (page_words == 0) {
+            fprintf(stderr, "store: -P page_words is required\n");
+            if (in != NULL) {
+                fclose(in);
+            }
+            result = -1;
+        } else if (in == NULL) {
+            perror(argv[1]);
+            result = -1;
+        } else {
+            result = cmd_store(in, page_words, strtoul(argv[2], NULL, 16), argc >= 6, fuse);
+            fclose(in);
+        }
+    } else if ((strcmp(command, "verify") == 0) && (argc == 3)) {
+        FILE* in = fopen(argv[2], "rb");
+        if (in == NULL) {
+            perror(argv[2]);
+            result = -1;
+        } else {
+            result = cmd_verify((strcmp(argv[1], "eeprom") == 0) ? FRAME_MEMORY_EEPROM : FRAME_MEMORY_FLASH, in);
+            fclose(in);
+        }
+    } else {
+        usage();
+        result = -1;
+    }
+    link_request(FRAME_OP_TEXT, NULL, 0);
+    link_close();
+    return (result == 0) ? 0 : 1;
+}
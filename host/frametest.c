@@ -0,0 +1,116 @@
+/*
+ * File:   frametest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Loopback of ../frame.c: frames encoded by frame_send() are fed byte by
+ * byte to frame_feed(), as the firmware receives them, together with noise
+ * between frames, corrupted CRC and bad lengths the parser has to reject
+ * and resynchronize after.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "frame.h"
+#include "crc.h"
+
+static int failures = 0;
+
+static uint8_t wire[2 * FRAME_DATA_MAX + 64];
+static size_t wire_length;
+
+static void expect(const int condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "frametest: %s\n", what);
+        failures++;
+    }
+}
+
+static void wire_put(const uint8_t byte) {
+    wire[wire_length++] = byte;
+}
+
+/**
+ * Feeds the wire to the parser, returns the number of complete frames and
+ * counts errors; the last complete frame is left in frame.
+ */
+static int feed(frame_t* frame, int* errors) {
+    int complete = 0;
+    *errors = 0;
+    for (size_t i = 0; i < wire_length; i++) {
+        int8_t result = frame_feed(frame, wire[i]);
+        if (result == FRAME_COMPLETE) {
+            complete++;
+        } else if (result == FRAME_ERROR) {
+            (*errors)++;
+        }
+    }
+    return complete;
+}
+
+int main(void) {
+    static frame_t frame;
+    uint8_t payload[FRAME_DATA_MAX];
+    int errors;
+    for (uint16_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = i * 7 + (i >> 8);
+    }
+    frame_reset(&frame);
+
+    /* Every payload length, including none and the largest */
+    for (uint16_t length = 0; length < FRAME_DATA_MAX; length++) {
+        wire_length = 0;
+        frame_send(wire_put, length, 0x30, payload, length);
+        expect(wire_length == length + 7u, "frame size");
+        int complete = feed(&frame, &errors);
+        if ((complete != 1) || errors || (frame.sequence != (length & 0xFF)) ||
+            (frame.length != length + 1) || (frame.data[0] != 0x30) ||
+            (memcmp(frame.data + 1, payload, length) != 0)) {
+            fprintf(stderr, "frametest: payload of %u bytes\n", length);
+            failures++;
+        }
+    }
+
+    /* Noise before and between frames is skipped */
+    wire_length = 0;
+    wire_put(0x00);
+    wire_put(0x55);
+    frame_send(wire_put, 1, FRAME_OP_PING, NULL, 0);
+    wire_put(0xAA);
+    frame_send(wire_put, 2, FRAME_OP_ENTER, payload, 3);
+    expect((feed(&frame, &errors) == 2) && !errors && (frame.sequence == 2) &&
+            (frame.data[0] == FRAME_OP_ENTER), "resynchronization on noise");
+
+    /* Corrupted payload and CRC are reported, the next frame still parses */
+    for (uint8_t corrupt = 4; corrupt < 10; corrupt++) {
+        wire_length = 0;
+        frame_send(wire_put, 3, FRAME_OP_WRITE_EEPROM, payload, 3);
+        wire[corrupt] ^= 0x01;
+        frame_send(wire_put, 4, FRAME_OP_PING, NULL, 0);
+        expect((feed(&frame, &errors) == 1) && (errors == 1) && (frame.sequence == 4),
+                "corrupted frame not rejected");
+    }
+
+    /* Length 0 and beyond FRAME_DATA_MAX are rejected right after the header */
+    static const uint16_t lengths[] = { 0, FRAME_DATA_MAX + 1, 0xFFFF };
+    for (uint8_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        wire_length = 0;
+        wire_put(FRAME_SYNC);
+        wire_put(5);
+        wire_put(lengths[i] & 0xFF);
+        wire_put(lengths[i] >> 8);
+        frame_send(wire_put, 6, FRAME_OP_PING, NULL, 0);
+        expect((feed(&frame, &errors) == 1) && (errors == 1) && (frame.sequence == 6),
+                "bad length not rejected");
+    }
+
+    /* Sync byte inside a frame is data */
+    wire_length = 0;
+    payload[0] = FRAME_SYNC;
+    frame_send(wire_put, FRAME_SYNC, FRAME_SYNC, payload, 1);
+    expect((feed(&frame, &errors) == 1) && !errors && (frame.sequence == FRAME_SYNC) &&
+            (frame.data[0] == FRAME_SYNC) && (frame.data[1] == FRAME_SYNC), "sync byte as data");
+
+    printf("frametest %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*
+ * File:   ihextest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Intel HEX uploads through ../ihex.c and the page writer of ../image.c,
+ * wired as 'write flash hex' of main.c, onto the simulated target of sim.c
+ * (ATmega1284P, so extended addresses reach past 64 KB). Corrupted records
+ * have to be refused before anything of them is written.
+ */
+
+#include "ihex.h"
+#include "image.h"
+
+#define IHEXTEST_SIGNATURE 0x1E9705
+
+static int failures = 0;
+static const avr_record* record;
+static int8_t write_result;
+static uint32_t written;                /* Data bytes passed by the parser */
+
+static int8_t write_hex_data(const uint32_t address, const uint8_t* data, const uint8_t length) {
+    written += length;
+    write_result = image_seek(address);
+    for (uint8_t i = 0; (i < length) && (write_result >= 0); i++) {
+        write_result = image_put(data[i]);
+    }
+    return write_result;
+}
+
+/**
+ * Appends a record with its checksum to text.
+ */
+static void hex_record(char* text, const uint8_t type, const uint16_t address, 
+        const uint8_t* data, const uint8_t length) {
+    uint8_t sum = length + (address >> 8) + (address & 0xFF) + type;
+    text += strlen(text);
+    text += sprintf(text, ":%02X%04X%02X", length, address, type);
+    for (uint8_t i = 0; i < length; i++) {
+        text += sprintf(text, "%02X", data[i]);
+        sum += data[i];
+    }
+    sprintf(text, "%02X\r\n", (uint8_t) -sum);
+}
+
+/**
+ * Feeds text to a fresh parser over an erased target, returns the parser
+ * result and leaves the page writer result in write_result.
+ */
+static int8_t upload(const char* text) {
+    static ihex_parser parser;
+    int8_t result = IHEX_OK;
+    enter_programming();
+    erase_chip();
+    image_start(0, record->flash_page_words, AVR_FLASH_SIZE(record));
+    ihex_reset(&parser);
+    write_result = PROG_OK;
+    written = 0;
+    for (; *text && (result == IHEX_OK); text++) {
+        result = ihex_feed(&parser, *text, write_hex_data);
+    }
+    if (write_result >= 0) {
+        write_result = image_flush();
+    } else {
+        program_flash_finish();
+    }
+    exit_programming();
+    return result;
+}
+
+static void expect(const int condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "ihextest: %s\n", what);
+        failures++;
+    }
+}
+
+static uint8_t flash_byte(const uint32_t address) {
+    uint16_t word = sim_flash()[address >> 1];
+    return (address & 1) ? (word >> 8) : (word & 0xFF);
+}
+
+static int flash_blank(void) {
+    for (uint32_t i = 0; i < AVR_FLASH_WORDS(record); i++) {
+        if (sim_flash()[i] != 0xFFFF) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    static char text[8192];
+    uint8_t data[32];
+    record = lookup_signature(IHEXTEST_SIGNATURE);
+    sim_target device = {
+        record->signature, record->flash_page_words, record->flash_pages,
+        record->eeprom_page_size, record->eeprom_size,
+        {record->fuse_low_factory, record->fuse_high_factory, record->fuse_extended_factory},
+        record->lock_factory
+    };
+    sim_init(&device);
+    const uint32_t size = AVR_FLASH_SIZE(record);
+    for (uint8_t i = 0; i < sizeof(data); i++) {
+        data[i] = 0xA0 + i;
+    }
+
+    /* Plain, segment (02) and linear (04) addressing, lowercase, blank lines */
+    text[0] = '\0';
+    hex_record(text, IHEX_TYPE_DATA, 0x0000, data, 16);
+    hex_record(text, IHEX_TYPE_DATA, 0x0010, data + 16, 16);
+    strcat(text, "\r\n\n");
+    hex_record(text, IHEX_TYPE_SEGMENT, 0x0000, (const uint8_t*) "\x01\x00", 2);
+    hex_record(text, IHEX_TYPE_DATA, 0x0000, data, 4);          /* 0x01000 */
+    hex_record(text, IHEX_TYPE_LINEAR, 0x0000, (const uint8_t*) "\x00\x01", 2);
+    hex_record(text, IHEX_TYPE_DATA, 0x0102, data + 8, 8);      /* 0x10102 */
+    hex_record(text, IHEX_TYPE_START_LINEAR, 0x0000, data, 4);
+    hex_record(text, IHEX_TYPE_END, 0x0000, NULL, 0);
+    strcat(text, "junk after end of file");
+    for (char* c = text; *c; c++) {
+        *c = ((*c >= 'A') && (*c <= 'F') && ((c - text) % 3 == 0)) ? *c - 'A' + 'a' : *c;
+    }
+    expect((upload(text) == IHEX_END) && (write_result == PROG_OK), "valid file rejected");
+    expect((memcmp(sim_flash(), data, 32) == 0) && (flash_byte(32) == 0xFF), "data records");
+    expect((flash_byte(0x1000) == data[0]) && (flash_byte(0x1003) == data[3]) && 
+            (flash_byte(0x1004) == 0xFF), "extended segment address");
+    expect((flash_byte(0x10101) == 0xFF) && (flash_byte(0x10102) == data[8]) && 
+            (flash_byte(0x10109) == data[15]) && (flash_byte(0x0102) == 0xFF), "extended linear address");
+    expect((image_length == 44) && (image_pages == 3), "bytes or pages written");
+
+    /* Bad checksum */
+    text[0] = '\0';
+    hex_record(text, IHEX_TYPE_DATA, 0x0000, data, 16);
+    text[10] ^= 0x01;                   /* A0 to A1 */
+    expect((upload(text) == IHEX_ERROR_CHECKSUM) && (written == 0) && flash_blank(), 
+            "bad checksum not refused");
+
+    /* Short, odd length, too long */
+    expect((upload(":1000000001020304\r\n") == IHEX_ERROR_SYNTAX) && (written == 0), 
+            "short record not refused");
+    expect((upload(":0100000041B\r\n") == IHEX_ERROR_SYNTAX) && (written == 0), 
+            "odd number of digits not refused");
+    expect((upload(":000000000000\r\n") == IHEX_ERROR_SYNTAX), "digits after checksum not refused");
+    expect((upload(":00000001F\r\n") == IHEX_ERROR_SYNTAX), "truncated end record not refused");
+    expect((upload(":0000000G01\r\n") == IHEX_ERROR_SYNTAX), "non-hex digit not refused");
+    expect((upload("00000001FF\r\n") == IHEX_ERROR_SYNTAX), "missing start code not refused");
+
+    /* Unknown type, bad length for type */
+    static const struct {
+        uint8_t type;
+        uint8_t length;
+    } bad[] = { { 0x06, 0 }, { 0xFF, 2 }, { IHEX_TYPE_END, 1 }, { IHEX_TYPE_SEGMENT, 1 },
+        { IHEX_TYPE_LINEAR, 3 }, { IHEX_TYPE_START_SEGMENT, 2 }, { IHEX_TYPE_START_LINEAR, 0 } };
+    for (uint8_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        text[0] = '\0';
+        hex_record(text, bad[i].type, 0x0000, data, bad[i].length);
+        hex_record(text, IHEX_TYPE_DATA, 0x0000, data, 16);
+        if ((upload(text) != IHEX_ERROR_RECORD) || written) {
+            fprintf(stderr, "ihextest: record type %02X, length %u not refused\n", bad[i].type, bad[i].length);
+            failures++;
+        }
+    }
+
+    /* Out of order within a page is fine, back to a written page is not */
+    text[0] = '\0';
+    hex_record(text, IHEX_TYPE_DATA, 0x0010, data + 16, 16);
+    hex_record(text, IHEX_TYPE_DATA, 0x0000, data, 16);
+    hex_record(text, IHEX_TYPE_END, 0x0000, NULL, 0);
+    expect((upload(text) == IHEX_END) && (write_result == PROG_OK) && (memcmp(sim_flash(), data, 32) == 0),
+            "out of order within a page refused");
+    text[0] = '\0';
+    hex_record(text, IHEX_TYPE_DATA, 2 * record->flash_page_words, data, 16);
+    hex_record(text, IHEX_TYPE_DATA, 0x0000, data, 16);
+    hex_record(text, IHEX_TYPE_END, 0x0000, NULL, 0);
+    expect((upload(text) == IHEX_ERROR_WRITE) && (write_result == IMAGE_ERROR_ORDER),
+            "address in a written page not refused");
+
+    /* Past the end of Flash, starting there or running into it */
+    text[0] = '\0';
+    hex_record(text, IHEX_TYPE_LINEAR, 0x0000, (const uint8_t[]) { size >> 24, size >> 16 }, 2);
+    hex_record(text, IHEX_TYPE_DATA, size & 0xFFFF, data, 16);
+    expect((upload(text) == IHEX_ERROR_WRITE) && (write_result == IMAGE_ERROR_RANGE), 
+            "data beyond Flash not refused");
+    text[0] = '\0';
+    hex_record(text, IHEX_TYPE_LINEAR, 0x0000, (const uint8_t[]) { (size - 8) >> 24, (size - 8) >> 16 }, 2);
+    hex_record(text, IHEX_TYPE_DATA, (size - 8) & 0xFFFF, data, 16);
+    expect((upload(text) == IHEX_ERROR_WRITE) && (write_result == IMAGE_ERROR_RANGE), 
+            "data running past Flash not refused");
+
+    if (sim_violations) {
+        fprintf(stderr, "ihextest: %u bus timing or protocol violations\n", sim_violations);
+        failures++;
+    }
+    printf("ihextest %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
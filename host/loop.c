@@ -0,0 +1,233 @@
+/*
+ * File:   loop.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Host side of config.c, for the whole firmware built for Linux (ecloop):
+ * the console is a pseudo terminal instead of USART1, the I2C bus and its
+ * image store are those of simtwi.c, and the programming bus drives the
+ * simulated target of sim.c. Host tools talk to
+ * the slave side of the pty exactly as to the programmer, so the whole
+ * stack runs without hardware.
+ *
+ * Environment:
+ *   ECLOOP_SIGNATURE  simulated target, 1E950F (ATmega328P) by default
+ *   ECLOOP_GANG       number of targets behind a gang expander (1..4),
+ *                     a single target without expander by default
+ *   ECLOOP_STORE      file keeping the image store between runs, mapped
+ *                     as the store memory
+ *   ECLOOP_FD         master side of a pty opened by the caller (ecp -l);
+ *                     otherwise a new pty is opened and its path printed
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "config.h"
+#include "prog.h"
+#include "store.h"
+
+static int uart = -1;
+static int uart_owned = 0;              /* pty opened here, outlives its clients */
+static uint32_t usart1_baudrate = USART1_BAUDRATE;
+
+static uint8_t tx[4096];
+static size_t tx_length = 0;
+
+static void tx_flush(void) {
+    const uint8_t* p = tx;
+    while (tx_length > 0) {
+        ssize_t r = write(uart, p, tx_length);
+        if ((r < 0) && (errno != EINTR) && (errno != EAGAIN)) {
+            break; /* No client, output is lost like on an unconnected UART */
+        }
+        if (r > 0) {
+            p += r;
+            tx_length -= r;
+        }
+    }
+    tx_length = 0;
+}
+
+/**
+ * Waits up to timeout_ms for input, returns nonzero when there is some.
+ * A pty without a client reports a hangup: the owned one waits for the
+ * next client, one handed over by ecp ends with it.
+ */
+static int rx_wait(const int timeout_ms) {
+    struct pollfd pfd = { .fd = uart, .events = POLLIN };
+    tx_flush();
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return 0;
+    }
+    if (pfd.revents & POLLIN) {
+        return 1;
+    }
+    if (!uart_owned) {
+        exit(EXIT_SUCCESS);
+    }
+    usleep(10000);
+    return 0;
+}
+
+static ssize_t stdout_write(void* cookie, const char* data, size_t length) {
+    (void) cookie;
+    for (size_t i = 0; i < length; i++) {
+        usart1_putc(data[i], NULL);
+    }
+    return length;
+}
+
+/**
+ * Maps the store file, which grows blank (0xFF) to STORE_SIZE, so writes
+ * of simtwi.c reach the file as they happen.
+ */
+static void store_open(const char* path) {
+    struct stat st;
+    if (path == NULL) {
+        return;
+    }
+    int file = open(path, O_RDWR | O_CREAT, 0644);
+    if ((file < 0) || (fstat(file, &st) < 0) || (ftruncate(file, STORE_SIZE) < 0)) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    uint8_t* memory = mmap(NULL, STORE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (memory == MAP_FAILED) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    close(file);
+    if (st.st_size < (off_t) STORE_SIZE) {
+        memset(memory + st.st_size, 0xFF, STORE_SIZE - st.st_size);
+    }
+    sim_store_attach(memory);
+}
+
+/**
+ * Opens the console and powers the simulated target.
+ */
+void init(void) {
+    const char* fd = getenv("ECLOOP_FD");
+    const char* signature = getenv("ECLOOP_SIGNATURE");
+    const avr_record* record = lookup_signature((signature != NULL) ? strtoul(signature, NULL, 16) : 0x1E950F);
+    if (record == NULL) {
+        fprintf(stderr, "ecloop: unknown signature %s\n", signature);
+        exit(EXIT_FAILURE);
+    }
+    sim_target device = {
+        record->signature, record->flash_page_words, record->flash_pages,
+        record->eeprom_page_size, record->eeprom_size,
+        {record->fuse_low_factory, record->fuse_high_factory, record->fuse_extended_factory},
+        record->lock_factory
+    };
+    sim_init(&device);
+    if (getenv("ECLOOP_GANG") != NULL) {
+        sim_gang(atoi(getenv("ECLOOP_GANG")));
+    }
+    store_open(getenv("ECLOOP_STORE"));
+    if (fd != NULL) {
+        uart = atoi(fd);
+    } else {
+        uart = posix_openpt(O_RDWR | O_NOCTTY);
+        if ((uart < 0) || (grantpt(uart) < 0) || (unlockpt(uart) < 0)) {
+            perror("ecloop: pty");
+            exit(EXIT_FAILURE);
+        }
+        uart_owned = 1;
+        fprintf(stderr, "ecloop: %s on %s\n", record->name, ptsname(uart));
+    }
+    stdout = fopencookie(NULL, "w", (cookie_io_functions_t) { .write = stdout_write });
+    setvbuf(stdout, NULL, _IONBF, 0);
+}
+
+int usart1_putc(const char c, FILE *stream) {
+    if (c == '\n') {
+        usart1_putc('\r', stream);
+    }
+    usart1_write(c);
+    return 0;
+}
+
+/**
+ * Output is collected and sent once the firmware waits for input.
+ */
+void usart1_write(const uint8_t c) {
+    if (tx_length == sizeof(tx)) {
+        tx_flush();
+    }
+    tx[tx_length++] = c;
+}
+
+void usart1_puts(const char* s) {
+    while (*s) {
+        usart1_putc(*(s++), NULL);
+    }
+}
+
+int usart1_getc(FILE* stream) {
+    uint8_t data;
+    (void) stream;
+    while (1) {
+        if (rx_wait(-1) && (read(uart, &data, 1) == 1)) {
+            return data;
+        }
+    }
+}
+
+/**
+ * Waits up to 1 ms for input, so the firmware's idle loops sleep instead
+ * of spinning.
+ */
+uint8_t usart1_available(void) {
+    int count = 0;
+    if (rx_wait(1) && (ioctl(uart, FIONREAD, &count) < 0)) {
+        count = 0;
+    }
+    return (count > 255) ? 255 : count;
+}
+
+void usart1_flush(void) {
+    tx_flush();
+}
+
+uint32_t usart1_get_baudrate(void) {
+    return usart1_baudrate;
+}
+
+/**
+ * Any rate, the pty has no clock.
+ */
+int8_t usart1_check_baudrate(const uint32_t baudrate) {
+    return (baudrate != 0) ? 0 : -1;
+}
+
+int8_t usart1_set_baudrate(const uint32_t baudrate) {
+    if (usart1_check_baudrate(baudrate) < 0) {
+        return -1;
+    }
+    usart1_baudrate = baudrate;
+    return 0;
+}
+
+/**
+ * Same handshake as on the programmer: falls back unless the host sends
+ * anything within USART1_BAUD_TIMEOUT_MS.
+ */
+int8_t usart1_negotiate_baudrate(const uint32_t baudrate) {
+    uint32_t previous = usart1_baudrate;
+    if (usart1_set_baudrate(baudrate) < 0) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < USART1_BAUD_TIMEOUT_MS; i++) {
+        if (usart1_available()) {
+            return 0;
+        }
+    }
+    usart1_baudrate = previous;
+    return -2;
+}
@@ -0,0 +1,443 @@
+/*
+ * File:   looptest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * The whole firmware through its console: ecloop is started on a pty, as
+ * by ecp -l, for each of two sessions.
+ *
+ * A text console session has to reproduce looptest.txt byte for byte.
+ * The transcript was captured before console output moved from printf to
+ * fmt.c, and guards text mode against formatting changes.
+ * Machine mode answers of a few commands are checked in full as well.
+ *
+ * In binary mode, image store writes have to stay within the image,
+ * whatever offset the host gives.
+ *
+ * A session of STK500v2 messages is replayed the way avrdude -c stk500pp
+ * -p m328p sends them, with every answer checked byte for byte. Page
+ * writes which the firmware cannot do as asked, bad checksums and commands
+ * outside programming mode have to be refused without touching the target.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "stk500.h"
+#include "frame.h"
+#include "store.h"
+
+#define TIMEOUT_MS 5000
+/* Output has ended when nothing more comes in this time */
+#define IDLE_MS 500
+#define TRANSCRIPT_MAX 16384
+/* ATmega328P */
+#define PAGE_BYTES 128
+#define PAGES 4
+
+static int failures = 0;
+static int port = -1;
+static uint8_t sequence = 0;
+
+static uint8_t wire[FRAME_DATA_MAX + 7];
+static size_t wire_length;
+
+static void expect(const int condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "looptest: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * Path of a file in the directory of this program.
+ */
+static void sibling(const char* self, const char* name, char* path, const size_t size) {
+    const char* slash = strrchr(self, '/');
+    snprintf(path, size, "%.*s%s", (slash != NULL) ? (int) (slash - self + 1) : 0, self, name);
+}
+
+/**
+ * Starts ecloop next to this program on a new pty, with a single ATmega328P
+ * and no image store. Returns its pid or -1.
+ */
+static pid_t spawn(const char* self) {
+    char program[4096], fd[16];
+    struct termios tio;
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((master < 0) || (grantpt(master) < 0) || (unlockpt(master) < 0)) {
+        return -1;
+    }
+    port = open(ptsname(master), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if ((port < 0) || (tcgetattr(port, &tio) < 0)) {
+        return -1;
+    }
+    cfmakeraw(&tio);
+    if (tcsetattr(port, TCSANOW, &tio) < 0) {
+        return -1;
+    }
+    sibling(self, "ecloop", program, sizeof(program));
+    snprintf(fd, sizeof(fd), "%d", master);
+    pid_t pid = fork();
+    if (pid == 0) {
+        setenv("ECLOOP_FD", fd, 1);
+        setenv("ECLOOP_SIGNATURE", "1E950F", 1);
+        unsetenv("ECLOOP_GANG");
+        unsetenv("ECLOOP_STORE");
+        execlp(program, program, (char*) NULL);
+        perror(program);
+        _exit(127);
+    }
+    close(master);
+    return pid;
+}
+
+static void stop(const pid_t pid) {
+    close(port);
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+}
+
+static int receive(uint8_t* data, const size_t length) {
+    struct pollfd pfd = { .fd = port, .events = POLLIN };
+    for (size_t done = 0; done < length; ) {
+        if (poll(&pfd, 1, TIMEOUT_MS) <= 0) {
+            return -1;
+        }
+        ssize_t n = read(port, data + done, length - done);
+        if (n <= 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/**
+ * Sends a line to the console and reads until the output ends with text.
+ */
+static int console(const char* line, const char* text) {
+    char output[512];
+    size_t length = 0, text_length = strlen(text);
+    if ((write(port, line, strlen(line)) < 0) || (write(port, "\r", 1) < 0)) {
+        return -1;
+    }
+    while ((length < text_length) || (memcmp(output + length - text_length, text, text_length) != 0)) {
+        if ((length == sizeof(output)) || (receive((uint8_t*) output + length, 1) < 0)) {
+            return -1;
+        }
+        length++;
+    }
+    return 0;
+}
+
+/**
+ * Sends body as one message, corrupting its checksum if asked, and
+ * receives the answer body. Returns its length or -1 when the answer is
+ * not a well formed message with the same sequence number.
+ */
+static int message(const uint8_t* body, const uint16_t length, uint8_t* answer, const uint8_t corrupt) {
+    uint8_t wire[5 + STK500_BODY_MAX + 1];
+    uint8_t header[5], checksum = 0;
+    sequence++;
+    wire[0] = STK500_MESSAGE_START;
+    wire[1] = sequence;
+    wire[2] = length >> 8;
+    wire[3] = length & 0xFF;
+    wire[4] = STK500_TOKEN;
+    memcpy(wire + 5, body, length);
+    for (uint16_t i = 0; i < 5 + length; i++) {
+        checksum ^= wire[i];
+    }
+    wire[5 + length] = checksum ^ corrupt;
+    if ((write(port, wire, 6 + length) < 0) || (receive(header, sizeof(header)) < 0) ||
+        (header[0] != STK500_MESSAGE_START) || (header[1] != sequence) || (header[4] != STK500_TOKEN)) {
+        return -1;
+    }
+    uint16_t size = ((uint16_t) header[2] << 8) | header[3];
+    if ((size > STK500_BODY_MAX) || (receive(answer, size + 1) < 0)) {
+        return -1;
+    }
+    checksum = 0;
+    for (uint8_t i = 0; i < sizeof(header); i++) {
+        checksum ^= header[i];
+    }
+    for (uint16_t i = 0; i <= size; i++) {
+        checksum ^= answer[i];
+    }
+    return (checksum == 0) ? size : -1;
+}
+
+static void wire_put(const uint8_t byte) {
+    wire[wire_length++] = byte;
+}
+
+/**
+ * Sends one binary frame, returns the FRAME_STATUS_* of its response or -1.
+ * Console text before the response is skipped by the frame parser.
+ */
+static int request(const uint8_t opcode, const uint8_t* payload, const uint16_t length) {
+    static frame_t frame;
+    uint8_t byte;
+    wire_length = 0;
+    frame_send(wire_put, ++sequence, opcode, payload, length);
+    if (write(port, wire, wire_length) < 0) {
+        return -1;
+    }
+    while (receive(&byte, 1) == 0) {
+        if ((frame_feed(&frame, byte) == FRAME_COMPLETE) && (frame.sequence == sequence)) {
+            return (frame.length >= 2) ? frame.data[1] : -1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * FRAME_OP_STORE_WRITE of 16 bytes at an image offset.
+ */
+static int image_write(const uint32_t offset) {
+    uint8_t payload[4 + 16];
+    for (uint8_t i = 0; i < 4; i++) {
+        payload[i] = offset >> (8 * i);
+    }
+    memset(payload + 4, 0x5A, 16);
+    return request(FRAME_OP_STORE_WRITE, payload, sizeof(payload));
+}
+
+static uint16_t hex(const char* text, uint8_t* data) {
+    uint16_t length = 0;
+    unsigned byte;
+    for (int n; sscanf(text, " %2x%n", &byte, &n) == 1; text += n) {
+        data[length++] = byte;
+    }
+    return length;
+}
+
+/**
+ * One message given in hex and the answer expected to it.
+ */
+static void exchange(const char* command, const char* expected) {
+    uint8_t body[STK500_BODY_MAX], answer[STK500_BODY_MAX + 1], reference[STK500_BODY_MAX];
+    int length = message(body, hex(command, body), answer, 0);
+    uint16_t reference_length = hex(expected, reference);
+    if ((length != reference_length) || (memcmp(answer, reference, reference_length) != 0)) {
+        fprintf(stderr, "looptest: %s answered", command);
+        for (int i = 0; i < length; i++) {
+            fprintf(stderr, " %02X", answer[i]);
+        }
+        fprintf(stderr, ", expected %s\n", expected);
+        failures++;
+    }
+}
+
+/**
+ * Program Flash PP of one page at the current address with the given mode.
+ */
+static uint8_t program_page(const uint8_t* data, const uint8_t mode) {
+    uint8_t body[5 + PAGE_BYTES], answer[STK500_BODY_MAX + 1];
+    body[0] = STK500_CMD_PROGRAM_FLASH_PP;
+    body[1] = PAGE_BYTES >> 8;
+    body[2] = PAGE_BYTES & 0xFF;
+    body[3] = mode;
+    body[4] = 5;                        /* Poll timeout, ignored */
+    memcpy(body + 5, data, PAGE_BYTES);
+    int length = message(body, sizeof(body), answer, 0);
+    return ((length == 2) && (answer[0] == STK500_CMD_PROGRAM_FLASH_PP)) ? answer[1] : 0xFF;
+}
+
+/**
+ * Reads the pages back from address 0, 256 bytes at a time as avrdude does.
+ */
+static int flash_matches(const uint8_t* image) {
+    static const uint8_t read[] = { STK500_CMD_READ_FLASH_PP, 0x01, 0x00 };
+    uint8_t answer[STK500_BODY_MAX + 1];
+    exchange("06 00 00 00 00", "06 00");
+    for (uint16_t offset = 0; offset < PAGES * PAGE_BYTES; offset += 256) {
+        if ((message(read, sizeof(read), answer, 0) != 3 + 256) || (answer[1] != STK500_STATUS_CMD_OK) ||
+            (answer[2 + 256] != STK500_STATUS_CMD_OK) || (memcmp(answer + 2, image + offset, 256) != 0)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Types all lines at once and compares the whole output, echo included,
+ * with the transcript. Returns 0, or -1 when ecloop cannot be started.
+ */
+static int transcript(const char* self) {
+    static const char* const lines[] = {
+        "help", "enter x", "exit", "run", "run", "exit",
+        "job", "job add enter 1E950F", "job add delay 10", "job add fuse low=E2 lock=FC",
+        "job add write flash 0 100 0", "job add bogus", "job", "job clear",
+        "gang", "gang 9", "timing",
+        "enter", "enter", "fuse", "fuse set low=E2", "fuse set lock=FC", "fuse", "fuse reset",
+        "fuse bogus", "fuse low E2",
+        "read flash 0 20", "read eeprom 0 8", "read flash 0 0", "read flash 7FF0 20", "read flash 7FF0 21",
+        "write eeprom 0 DEADBEEF", "write eeprom 0 DEADBEEF", "write eeprom 3 ABC", "read eeprom 0 8",
+        "verify crc 0 100", "verify", "timing", "erase", "timing", "read flash 0 8",
+        "write hex", ":ZZ", "write hex", ":00000001FF", "exit", "bogus",
+        NULL
+    };
+    static char expected[TRANSCRIPT_MAX], output[TRANSCRIPT_MAX];
+    char path[4096];
+    sibling(self, "looptest.txt", path, sizeof(path));
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+    size_t expected_length = fread(expected, 1, sizeof(expected), file);
+    fclose(file);
+    pid_t pid = spawn(self);
+    if (pid < 0) {
+        perror("looptest");
+        return -1;
+    }
+    for (uint8_t i = 0; lines[i] != NULL; i++) {
+        if ((write(port, lines[i], strlen(lines[i])) < 0) || (write(port, "\r", 1) < 0)) {
+            stop(pid);
+            return -1;
+        }
+    }
+    struct pollfd pfd = { .fd = port, .events = POLLIN };
+    size_t length = 0;
+    ssize_t n = 0;
+    while ((length < sizeof(output)) && (poll(&pfd, 1, length ? IDLE_MS : TIMEOUT_MS) > 0) &&
+        ((n = read(port, output + length, sizeof(output) - length)) > 0)) {
+        length += n;
+    }
+    stop(pid);
+    size_t same = 0, line = 1;
+    for (; (same < length) && (same < expected_length) && (output[same] == expected[same]); same++) {
+        line += (output[same] == '\n');
+    }
+    if ((length != expected_length) || (same != length)) {
+        fprintf(stderr, "looptest: console output differs from looptest.txt at line %zu\n", line);
+        failures++;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    static const char* const start[] = {
+        "01", "01 00 08 53 54 4B 35 30 30 5F 32",           /* Sign on */
+        "03 90", "03 00 02",                                /* Hardware, software version */
+        "03 91", "03 00 02",
+        "03 92", "03 00 0A",
+        "03 94", "03 00 32",                                /* Target voltage */
+        "02 9E 01", "02 00",
+        "2D 00 01 08 09 0A 0B 0C 0D 0E 0F 10 11 12 13 14 15"
+        " 16 17 18 19 1A 1B 1C 1D 1E 1F 20 21 22 23 24 25", "2D 00",
+        "22 00 0A", "22 C0",                                /* Erase before entering */
+        "20 64 0A 0F 00 0F 00 00", "20 00",
+        "2B 00", "2B 00 1E",
+        "2B 01", "2B 00 95",
+        "2B 02", "2B 00 0F",
+        "22 00 0A", "22 00",
+        "06 00 00 00 00", "06 00",
+        NULL
+    };
+    static const char* const finish[] = {
+        "28 00", "28 00 62",                                /* lfuse:w:0xE2:m */
+        "27 00 E2 00 05", "27 00",
+        "28 00", "28 00 E2",
+        "2A 00", "2A 00 FF",
+        "1D", "1D C9",
+        "21 01 00", "21 00",
+        NULL
+    };
+    uint8_t image[PAGES * PAGE_BYTES], other[PAGE_BYTES], answer[STK500_BODY_MAX + 1];
+    (void) argc;
+    for (uint16_t i = 0; i < sizeof(image); i++) {
+        image[i] = i * 7 + 3;
+    }
+    for (uint16_t i = 0; i < sizeof(other); i++) {
+        other[i] = ~image[i];
+    }
+    if (transcript(argv[0]) < 0) {
+        return EXIT_FAILURE;
+    }
+
+    /* End of the range wraps into the store header */
+    pid_t pid = spawn(argv[0]);
+    if (pid < 0) {
+        perror("looptest");
+        return EXIT_FAILURE;
+    }
+    expect(write(port, "\rmode binary\r", 13) == 13, "no binary mode");
+    expect(image_write(0) == FRAME_STATUS_OK, "store write");
+    expect(image_write(STORE_IMAGE_MAX - 16) == FRAME_STATUS_OK, "store write at the end of the image");
+    expect(image_write(STORE_IMAGE_MAX - 8) == FRAME_STATUS_ARGUMENT, "store write past the image");
+    expect(image_write(0xFFFFFFF8UL) == FRAME_STATUS_ARGUMENT, "store write wrapping into the header");
+    stop(pid);
+
+    pid = spawn(argv[0]);
+    if (pid < 0) {
+        perror("looptest");
+        return EXIT_FAILURE;
+    }
+    /* Machine mode, without echo */
+    expect((console("\rmode machine", "ok=Machine mode\r\n") == 0) &&
+            (console("enter", "signature=1E950F\r\ndevice=ATmega328P\r\n"
+                "flash.size=32768 pages=256 page_words=64\r\neeprom.size=1024 page_size=4\r\n"
+                "ok=Entered programming mode for device\r\n") == 0) &&
+            (console("timing", "timing.erase_ms=0.000 timeout_ms=36.000\r\n"
+                "timing.flash_page_ms=0.000 timeout_ms=18.000\r\ntiming.eeprom_page_ms=0.000 timeout_ms=18.000\r\n"
+                "timing.fuse_lock_ms=0.000 timeout_ms=18.000\r\n") == 0) &&
+            (console("fuse set low=62 high=DA", "fuse.low=62 written=0\r\nfuse.high=DA written=1\r\n"
+                "ok=Fuse/lock bits verified\r\n") == 0) &&
+            (console("read eeprom 0 4", "eeprom.00000=FFFFFFFF\r\nok=Read 4 bytes\r\n") == 0) &&
+            (console("read flash FFFFFF00 10", "error=Range beyond Flash\r\n") == 0) &&
+            (console("verify crc FFFFFFF0 20", "error=Range beyond Flash\r\n") == 0) &&
+            (console("write eeprom FFFFFFFF 0102", "error=Range beyond EEPROM\r\n") == 0) &&
+            (console("exit", "ok=Programming mode left, power down\r\n") == 0), "machine mode output");
+
+    if (console("mode stk500", "to leave\r\n") < 0) {
+        fprintf(stderr, "looptest: no STK500v2 mode\n");
+        stop(pid);
+        return EXIT_FAILURE;
+    }
+
+    /* avrdude -U flash:w, then -U lfuse:w:0xE2:m */
+    for (uint8_t i = 0; start[i] != NULL; i += 2) {
+        exchange(start[i], start[i + 1]);
+    }
+    for (uint8_t page = 0; page < PAGES; page++) {
+        expect(program_page(image + page * PAGE_BYTES, 0xCF) == STK500_STATUS_CMD_OK, "page write");
+    }
+    expect(flash_matches(image), "Flash readback");
+
+    /* Word mode, a page loaded without being written, an unaligned page */
+    expect(program_page(other, 0x00) == STK500_STATUS_CMD_FAILED, "word mode accepted");
+    expect(program_page(other, 0x41) == STK500_STATUS_CMD_FAILED, "page load without write accepted");
+    exchange("06 00 00 00 20", "06 00");
+    expect(program_page(other, 0xCF) == STK500_STATUS_CMD_FAILED, "unaligned page accepted");
+    expect(flash_matches(image), "Flash changed by a refused write");
+
+    /* Word address whose byte address wraps to 0 */
+    exchange("06 7F FF FF 80", "06 00");
+    exchange("24 01 00", "24 C0");
+
+    /* Checksum error, the message is not carried out */
+    static const uint8_t erase[] = { STK500_CMD_CHIP_ERASE_PP, 0x00, 0x0A };
+    expect((message(erase, sizeof(erase), answer, 0x01) == 2) && (answer[0] == STK500_ANSWER_CKSUM_ERROR) &&
+            (answer[1] == STK500_STATUS_CKSUM_ERROR), "checksum error not answered");
+    expect(flash_matches(image), "Flash erased by a corrupted message");
+
+    for (uint8_t i = 0; finish[i] != NULL; i += 2) {
+        exchange(finish[i], finish[i + 1]);
+    }
+    expect(console("mode text", "Text mode\r\n") == 0, "no return to text mode");
+
+    stop(pid);
+    printf("looptest %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+/*
+ * File:   lzc.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Reference compressor for the stream format described in ../lz.h.
+ * Greedy longest match over the whole window, with one step of lazy 
+ * evaluation; images are small enough for an exhaustive search.
+ */
+
+#include "lz.h"
+#include "lzc.h"
+
+static size_t longest_match(const uint8_t* in, const size_t length, const size_t position, 
+        size_t* distance) {
+    size_t best = 0;
+    size_t limit = length - position;
+    if (limit > LZ_MATCH_MAX) {
+        limit = LZ_MATCH_MAX;
+    }
+    for (size_t d = 1; (d <= LZ_WINDOW_SIZE) && (d <= position); d++) {
+        size_t n = 0;
+        while ((n < limit) && (in[position + n] == in[position + n - d])) {
+            n++;
+        }
+        if (n > best) {
+            best = n;
+            *distance = d;
+            if (n == limit) {
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Compresses length bytes of in, out has to hold LZC_BOUND(length) bytes.
+ * Returns the compressed length.
+ */
+size_t lz_compress(const uint8_t* in, const size_t length, uint8_t* out) {
+    size_t position = 0, written = 0, control = 0;
+    unsigned items = 8;
+    while (position < length) {
+        size_t distance = 0, next_distance;
+        size_t match = longest_match(in, length, position, &distance);
+        if ((match >= LZ_MATCH_MIN) && (position + 1 < length) &&
+            (longest_match(in, length, position + 1, &next_distance) > match + 1)) {
+            match = 0;                  /* Better match starts at the next byte */
+        }
+        if (items == 8) {
+            control = written++;
+            out[control] = 0;
+            items = 0;
+        }
+        if (match >= LZ_MATCH_MIN) {
+            out[written++] = distance - 1;
+            out[written++] = match - LZ_MATCH_MIN;
+            position += match;
+        } else {
+            out[control] |= 1 << items;
+            out[written++] = in[position++];
+        }
+        items++;
+    }
+    return written;
+}
+
@@ -0,0 +1,18 @@
+/*
+ * File:   lzc.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#ifndef LZC_H
+#define	LZC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Worst case: a control byte per 8 literals */
+#define LZC_BOUND(length) ((length) + ((length) + 7) / 8)
+
+size_t lz_compress(const uint8_t* in, const size_t length, uint8_t* out);
+
+#endif	/* LZC_H */
+
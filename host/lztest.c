@@ -0,0 +1,184 @@
+/*
+ * File:   lztest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Round trip of lzc.c streams through the firmware decoder of ../lz.c.
+ * Streams are fed in LZ_DATA frame sized chunks and byte by byte, and the
+ * output is collected in Flash pages as binary.c does. The inputs are made
+ * to produce overlapping copies (distance < length), matches reaching the
+ * whole window back, matches whose encoding is split between two chunks and
+ * matches whose output crosses a page; the stream is parsed to make sure
+ * each of those actually occurs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lz.h"
+#include "lzc.h"
+#include "frame.h"
+
+#define LZTEST_SIZE 65536
+#define LZTEST_PAGE 128                 /* Flash page bytes of a 64-word page */
+#define LZTEST_CHUNK (FRAME_DATA_MAX - 1)
+
+static int failures = 0;
+
+static uint8_t output[LZTEST_SIZE];
+static size_t output_length;
+static uint8_t page[LZTEST_PAGE];
+static size_t page_fill;
+
+static void expect(const int condition, const char* name, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "lztest: %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+static int8_t put(const uint8_t byte) {
+    page[page_fill++] = byte;
+    if (page_fill == sizeof(page)) {
+        if (output_length + sizeof(page) > sizeof(output)) {
+            return -1;
+        }
+        memcpy(output + output_length, page, sizeof(page));
+        output_length += sizeof(page);
+        page_fill = 0;
+    }
+    return LZ_OK;
+}
+
+static void decode(const uint8_t* stream, const size_t length, const size_t chunk) {
+    static lz_decoder decoder;
+    output_length = 0;
+    page_fill = 0;
+    lz_reset(&decoder);
+    for (size_t i = 0; i < length; i += chunk) {
+        for (size_t j = i; (j < i + chunk) && (j < length); j++) {
+            if (lz_feed(&decoder, stream[j], put) < 0) {
+                return;
+            }
+        }
+    }
+    /* Last partial page, as LZ_END flushes it */
+    memcpy(output + output_length, page, page_fill);
+    output_length += page_fill;
+}
+
+typedef struct {
+    unsigned matches;
+    unsigned overlapping;               /* Distance shorter than length */
+    unsigned window;                    /* Distance LZ_WINDOW_SIZE */
+    unsigned split;                     /* Distance and length bytes in two chunks */
+    unsigned paged;                     /* Output crosses a page boundary */
+} stream_stats;
+
+/**
+ * Walks the groups of a stream, see lz.h.
+ */
+static stream_stats parse(const uint8_t* stream, const size_t length) {
+    stream_stats stats = { 0 };
+    size_t out = 0;
+    size_t i = 0;
+    while (i < length) {
+        uint8_t control = stream[i++];
+        for (uint8_t item = 0; (item < 8) && (i < length); item++, control >>= 1) {
+            if (control & 1) {
+                i++;
+                out++;
+                continue;
+            }
+            size_t distance = stream[i] + 1;
+            size_t count = stream[i + 1] + LZ_MATCH_MIN;
+            stats.matches++;
+            stats.overlapping += distance < count;
+            stats.window += distance == LZ_WINDOW_SIZE;
+            stats.split += (i + 1) % LZTEST_CHUNK == 0;
+            stats.paged += out / LZTEST_PAGE != (out + count - 1) / LZTEST_PAGE;
+            out += count;
+            i += 2;
+        }
+    }
+    return stats;
+}
+
+static void round_trip(const char* name, const uint8_t* in, const size_t length, stream_stats* total) {
+    uint8_t* stream = malloc(LZC_BOUND(length));
+    size_t stream_length = lz_compress(in, length, stream);
+    expect(stream_length <= LZC_BOUND(length), name, "stream longer than bound");
+    static const size_t chunks[] = { LZTEST_CHUNK, 1, 7 };
+    for (uint8_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        decode(stream, stream_length, chunks[c]);
+        if ((output_length != length) || (memcmp(output, in, length) != 0)) {
+            fprintf(stderr, "lztest: %s: mismatch in chunks of %zu\n", name, chunks[c]);
+            failures++;
+        }
+    }
+    stream_stats stats = parse(stream, stream_length);
+    printf("%-10s %6zu -> %6zu  matches %5u  overlapping %4u  window %4u  split %3u  paged %3u\n", 
+            name, length, stream_length, stats.matches, stats.overlapping, stats.window, 
+            stats.split, stats.paged);
+    total->matches += stats.matches;
+    total->overlapping += stats.overlapping;
+    total->window += stats.window;
+    total->split += stats.split;
+    total->paged += stats.paged;
+    free(stream);
+}
+
+int main(void) {
+    static uint8_t in[LZTEST_SIZE];
+    stream_stats total = { 0 };
+    uint32_t seed = 1;
+
+    round_trip("empty", in, 0, &total);
+    in[0] = 0x42;
+    round_trip("one", in, 1, &total);
+
+    /* Runs and short periods: overlapping copies up to LZ_MATCH_MAX */
+    memset(in, 0xFF, sizeof(in));
+    round_trip("blank", in, 4096, &total);
+    for (size_t i = 0; i < 8192; i++) {
+        in[i] = "\x0C\x94\x34\x00\x0C\x94\x51"[i % ((i / 1024) % 7 + 1)];
+    }
+    round_trip("periodic", in, 8192, &total);
+
+    /* Random blocks repeated exactly one window back */
+    for (size_t i = 0; i < 16384; i++) {
+        seed = seed * 1103515245UL + 12345;
+        in[i] = ((i / LZ_WINDOW_SIZE) % 2) ? in[i - LZ_WINDOW_SIZE] : (seed >> 16);
+    }
+    round_trip("window", in, 16384, &total);
+
+    /* Code-like image: random words, sequences repeated from up to a window back, blank pages */
+    for (size_t i = 0; i < sizeof(in); i += 8) {
+        seed = seed * 1103515245UL + 12345;
+        size_t back = 8 * (1 + (seed >> 16) % 31);
+        for (size_t j = i; j < i + 8; j++) {
+            if ((j / LZTEST_PAGE) % 5 == 4) {
+                in[j] = 0xFF;
+            } else if ((i >= back) && (seed & 0x80000000UL)) {
+                in[j] = in[j - back];
+            } else {
+                seed = seed * 1103515245UL + 12345;
+                in[j] = seed >> 16;
+            }
+        }
+    }
+    round_trip("image", in, sizeof(in), &total);
+
+    /* Incompressible */
+    for (size_t i = 0; i < 4099; i++) {
+        seed = seed * 1103515245UL + 12345;
+        in[i] = seed >> 16;
+    }
+    round_trip("random", in, 4099, &total);
+
+    expect(total.overlapping > 0, "all", "no overlapping copies");
+    expect(total.window > 0, "all", "no matches a whole window back");
+    expect(total.split > 0, "all", "no match split between chunks");
+    expect(total.paged > 0, "all", "no match output crossing a page");
+    printf("lztest %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
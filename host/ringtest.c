@@ -0,0 +1,73 @@
+/*
+ * File:   ringtest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * ../ring.h on the host: empty and full conditions, FIFO order and index
+ * wraparound, for the smallest useful ring and the 256-byte one where the
+ * 8-bit indexes wrap by themselves.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ring.h"
+
+static int failures = 0;
+
+static void expect(const int condition, const char* what, const unsigned size) {
+    if (!condition) {
+        fprintf(stderr, "ringtest: %u bytes: %s\n", size, what);
+        failures++;
+    }
+}
+
+static void check(ring_t* ring, const unsigned size) {
+    uint8_t data = 0xA5;
+    uint8_t next = 0;
+    uint8_t expected = 0;
+
+    expect(ring_empty(ring) && (ring_count(ring) == 0), "not empty initially", size);
+    expect(!ring_get(ring, &data) && (data == 0xA5), "get from empty ring", size);
+
+    /* One slot is kept free */
+    for (unsigned i = 0; i < size - 1; i++) {
+        expect(ring_put(ring, next++), "put before full", size);
+    }
+    expect(ring_count(ring) == size - 1, "count when full", size);
+    expect(!ring_put(ring, 0xFF), "put into full ring", size);
+    expect(ring_count(ring) == size - 1, "count after rejected put", size);
+
+    for (unsigned i = 0; i < size - 1; i++) {
+        expect(ring_get(ring, &data) && (data == expected++), "order after full", size);
+    }
+    expect(ring_empty(ring) && !ring_get(ring, &data), "empty after draining", size);
+
+    /* Indexes pass the end of storage many times at every fill level */
+    for (unsigned fill = 1; fill < size; fill++) {
+        for (unsigned round = 0; round < 3 * size; round++) {
+            while (ring_count(ring) < fill) {
+                expect(ring_put(ring, next++), "put during wraparound", size);
+            }
+            expect(ring_get(ring, &data) && (data == expected++), "order during wraparound", size);
+        }
+        while (ring_get(ring, &data)) {
+            expect(data == expected++, "order while draining", size);
+        }
+    }
+    expect(ring_empty(ring) && (ring_count(ring) == 0), "empty at the end", size);
+}
+
+int main(void) {
+    static volatile uint8_t small_storage[2];
+    static volatile uint8_t storage[8];
+    static volatile uint8_t large_storage[256];
+    ring_t small = RING_INITIALIZER(small_storage);
+    ring_t ring = RING_INITIALIZER(storage);
+    ring_t large = RING_INITIALIZER(large_storage);
+
+    check(&small, sizeof(small_storage));
+    check(&ring, sizeof(storage));
+    check(&large, sizeof(large_storage));
+
+    printf("ringtest %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,723 @@
+/*
+ * File:   sim.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Cycle counting model of an ATmega in parallel programming mode, behind
+ * the HAL_* macros of sim.h. It follows "Parallel Programming" of
+ * the datasheets: XTAL1 loads command, address and data as selected by
+ * XA1, XA0 and BS1, PAGEL latches the page buffer, WR starts a write and
+ * OE reads DATA. Writes hold RDY/BSY low for their datasheet duration.
+ *
+ * With sim_gang(), up to SIM_TARGETS_MAX targets share the bus behind the
+ * MCP23017 of gang.h, on the I2C bus of simtwi.c: its outputs gate WR and
+ * OE and route 12V to each target, RDY/BSY is the AND of all targets and
+ * each one is also readable on GPB4..7. Outputs left as inputs (IODIR)
+ * are pulled low, so nothing is gated or routed until the expander is
+ * configured.
+ *
+ * Every access which breaks the protocol or the minimum timing of timing.h
+ * is reported on stderr and counted in sim_violations.
+ */
+
+#include "sim.h"
+#include "timing.h"
+#include "gang.h"
+
+/* WR low to RDY/BSY high, maximum, in us */
+#define SIM_ERASE_US 9000
+#define SIM_FLASH_WRITE_US 4500
+#define SIM_EEPROM_WRITE_US 3600
+#define SIM_FUSE_WRITE_US 4500
+
+#define SIM_CALIBRATION 0x9A
+#define SIM_VIOLATIONS_SHOWN 16
+
+/* MCP23017 registers up to OLATB, IOCON.BANK = 0 */
+#define SIM_EXPANDER_REGISTERS 0x16
+
+#define US_TO_CYCLES(us) ((int64_t) (us) * (F_CPU / 1000000UL))
+#define NEVER (INT64_MIN / 2)
+
+uint8_t sim_port_d = 0;
+uint8_t sim_port_f = 0;
+volatile uint8_t sim_ready_flag = 0;
+sim_counters sim_count;
+uint32_t sim_violations = 0;
+uint8_t sim_button = 0;                 /* ~{PROGRAM} held */
+
+/* A target on the bus */
+typedef struct {
+    sim_target target;
+    uint16_t* flash;
+    uint8_t* eeprom;
+    uint16_t flash_buffer[256];
+    uint8_t eeprom_buffer[256];
+    uint8_t eeprom_loaded[256];
+    uint8_t programming;                /* Powered with 12V on RESET */
+    uint8_t command;
+    uint8_t address_low;
+    uint8_t address_high;
+    uint8_t data_low;
+    uint8_t data_high;
+    uint8_t busy;
+    int64_t busy_until;
+} sim_device;
+
+static sim_device devices[SIM_TARGETS_MAX];
+static uint8_t device_count = 0;
+static uint8_t expander = 0;            /* Targets are behind the gang expander */
+static uint8_t expander_registers[SIM_EXPANDER_REGISTERS];
+
+static uint8_t bus_driven = 0;
+static uint8_t powered = 0;             /* 5V and 12V enabled */
+static uint8_t bs2 = 0;
+static uint8_t data = 0;
+static uint8_t data_driven = 0;
+
+static uint8_t hung = 0;
+
+/* Write timer, HAL_TIMER_HZ */
+#define SIM_TIMER_PRESCALER 64
+static uint8_t timer_running = 0;
+static uint8_t timer_armed = 0;
+static int64_t timer_start = 0;
+static int64_t timer_alarm = 0;
+static uint16_t timer_stopped = 0;
+
+/* Time of the last edge, in cycles */
+static int64_t t_control;               /* XA1, XA0, BS1 or DATA changed */
+static int64_t t_bs;                    /* BS1 or BS2 changed */
+static int64_t t_xtal1_high;
+static int64_t t_xtal1_low;
+static int64_t t_pagel_high;
+static int64_t t_pagel_low;
+static int64_t t_wr_low;
+static int64_t t_oe_low;
+static int64_t t_oe_high;
+
+static int64_t now(void) {
+    return (int64_t) sim_count.total;
+}
+
+static void violation(const char* what) {
+    if (hung) {
+        return; // Nothing is expected from a dead target
+    }
+    if (sim_violations++ < SIM_VIOLATIONS_SHOWN) {
+        fprintf(stderr, "sim: %s at cycle %llu\n", what, (unsigned long long) sim_count.total);
+    }
+}
+
+static void check(const int64_t since, const uint32_t ns, const char* what) {
+    if (now() - since < (int64_t) NS_TO_CYCLES(ns)) {
+        violation(what);
+    }
+}
+
+/**
+ * Level of an expander output, low while it is still an input.
+ */
+static uint8_t expander_output(const uint8_t port, const uint8_t bit) {
+    const uint8_t iodir = expander_registers[port ? MCP23017_IODIRB : MCP23017_IODIRA];
+    const uint8_t olat = expander_registers[port ? MCP23017_OLATB : MCP23017_OLATA];
+    return !(iodir & (1 << bit)) && (olat & (1 << bit));
+}
+
+/* WR, OE and 12V reach target n, always for a single target */
+static uint8_t wr_gate(const uint8_t n) {
+    return expander ? expander_output(0, n) : 1;
+}
+
+static uint8_t oe_gate(const uint8_t n) {
+    return expander ? expander_output(0, 4 + n) : 1;
+}
+
+static uint8_t route(const uint8_t n) {
+    return expander ? expander_output(1, n) : 1;
+}
+
+/**
+ * Combined RDY/BSY, high only when no target is writing.
+ */
+static uint8_t ready(void) {
+    for (uint8_t n = 0; n < device_count; n++) {
+        if (devices[n].busy) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Earliest write to complete, INT64_MAX when none is running.
+ */
+static int64_t next_ready(void) {
+    int64_t next = INT64_MAX;
+    for (uint8_t n = 0; n < device_count; n++) {
+        if (devices[n].busy && (devices[n].busy_until < next)) {
+            next = devices[n].busy_until;
+        }
+    }
+    return next;
+}
+
+/**
+ * Advances time. RDY/BSY going high and the timer compare match raise their
+ * interrupts at the cycle they happen.
+ */
+static void advance(const uint64_t cycles) {
+    const int64_t end = now() + cycles;
+    while (1) {
+        int64_t next = end;
+        const int64_t write_end = next_ready();
+        if (write_end < next) {
+            next = write_end;
+        }
+        if (timer_armed && (timer_alarm < next)) {
+            next = timer_alarm;
+        }
+        sim_count.total = next;
+        if (now() >= write_end) {
+            for (uint8_t n = 0; n < device_count; n++) {
+                if (devices[n].busy && (now() >= devices[n].busy_until)) {
+                    devices[n].busy = 0;
+                }
+            }
+            if (ready()) {
+                sim_ready_flag = 1;
+                sim_ready_isr();
+            }
+        } else if (timer_armed && (now() >= timer_alarm)) {
+            timer_armed = 0;
+            sim_timer_isr();
+        } else if (next == end) {
+            return;
+        }
+    }
+}
+
+static void start_write(sim_device* device, const uint32_t us) {
+    device->busy = 1;
+    device->busy_until = hung ? (INT64_MAX / 2) : (now() + US_TO_CYCLES(us));
+}
+
+static uint32_t flash_words(const sim_device* device) {
+    return (uint32_t) device->target.flash_page_words * device->target.flash_pages;
+}
+
+static uint16_t address(const sim_device* device) {
+    return (device->address_high << 8) | device->address_low;
+}
+
+static void load(sim_device* device) {
+    const uint8_t select = sim_port_d & (PD_XA1_bm | PD_XA0_bm);
+    const uint8_t bs1 = sim_port_d & PD_BS1_bm;
+    if (device->busy) {
+        violation("load while busy");
+    }
+    if (select == PD_XA1_bm) {
+        device->command = data;
+    } else if (select == 0) {
+        if (bs1) {
+            device->address_high = data;
+        } else {
+            device->address_low = data;
+        }
+    } else if (select == PD_XA0_bm) {
+        if (bs1) {
+            device->data_high = data;
+        } else {
+            device->data_low = data;
+        }
+    }
+}
+
+static void latch(sim_device* device) {
+    if (device->busy) {
+        violation("PAGEL while busy");
+    }
+    if (device->command == 0x10) {
+        device->flash_buffer[device->address_low & (device->target.flash_page_words - 1)] =
+            device->data_low | (device->data_high << 8);
+    } else if (device->command == 0x11) {
+        uint8_t i = device->address_low & (device->target.eeprom_page_size - 1);
+        device->eeprom_buffer[i] = device->data_low;
+        device->eeprom_loaded[i] = 1;
+    } else {
+        violation("PAGEL without page write command");
+    }
+}
+
+/**
+ * Returns the duration of the write started, in us, 0 when none was.
+ */
+static uint32_t write(sim_device* device) {
+    const uint8_t bs1 = (sim_port_d & PD_BS1_bm) ? 1 : 0;
+    sim_target* target = &device->target;
+    uint16_t page;
+    if (device->busy) {
+        violation("WR while busy");
+        return 0;
+    }
+    switch (device->command) {
+        case 0x80:
+            for (uint32_t i = 0; i < flash_words(device); i++) {
+                device->flash[i] = 0xFFFF;
+            }
+            if (target->fuses[1] & 0x08) { // EESAVE unprogrammed
+                memset(device->eeprom, 0xFF, target->eeprom_size);
+            }
+            target->lock = 0xFF;
+            start_write(device, SIM_ERASE_US);
+            return SIM_ERASE_US;
+        case 0x40:
+            if (bs1 && bs2) {
+                violation("fuse write with BS2, BS1 at 11");
+                return 0;
+            }
+            target->fuses[bs2 ? 2 : bs1] = device->data_low;
+            start_write(device, SIM_FUSE_WRITE_US);
+            return SIM_FUSE_WRITE_US;
+        case 0x20:
+            target->lock &= device->data_low;
+            start_write(device, SIM_FUSE_WRITE_US);
+            return SIM_FUSE_WRITE_US;
+        case 0x10:
+            if (bs1 || bs2) {
+                violation("Flash page write with BS2, BS1 not at 00");
+            }
+            if (address(device) >= flash_words(device)) {
+                violation("Flash page write out of range");
+                return 0;
+            }
+            page = address(device) & ~(target->flash_page_words - 1);
+            for (uint16_t i = 0; i < target->flash_page_words; i++) {
+                device->flash[page + i] &= device->flash_buffer[i];
+                device->flash_buffer[i] = 0xFFFF;
+            }
+            start_write(device, SIM_FLASH_WRITE_US);
+            return SIM_FLASH_WRITE_US;
+        case 0x11:
+            if (bs1 || bs2) {
+                violation("EEPROM page write with BS2, BS1 not at 00");
+            }
+            if (address(device) >= target->eeprom_size) {
+                violation("EEPROM page write out of range");
+                return 0;
+            }
+            page = address(device) & ~(target->eeprom_page_size - 1);
+            for (uint16_t i = 0; i < target->eeprom_page_size; i++) {
+                if (device->eeprom_loaded[i]) {
+                    device->eeprom[page + i] = device->eeprom_buffer[i];
+                }
+                device->eeprom_loaded[i] = 0;
+            }
+            start_write(device, SIM_EEPROM_WRITE_US);
+            return SIM_EEPROM_WRITE_US;
+        default:
+            violation("WR without write command");
+            return 0;
+    }
+}
+
+static uint8_t output(const sim_device* device) {
+    const uint8_t bs1 = (sim_port_d & PD_BS1_bm) ? 1 : 0;
+    const sim_target* target = &device->target;
+    const uint16_t* flash = device->flash;
+    const uint8_t address_low = device->address_low;
+    switch (device->command) {
+        case 0x02:
+            if (address(device) >= flash_words(device)) {
+                return 0xFF;
+            }
+            return bs1 ? (flash[address(device)] >> 8) : (flash[address(device)] & 0xFF);
+        case 0x03:
+            return device->eeprom[address(device) % target->eeprom_size];
+        case 0x08:
+            if (bs1) {
+                return SIM_CALIBRATION;
+            }
+            return (address_low < 3) ? (target->signature >> (16 - 8 * address_low)) : 0xFF;
+        case 0x04:
+            if (bs2) {
+                return bs1 ? target->fuses[1] : target->fuses[2];
+            }
+            return bs1 ? target->lock : target->fuses[0];
+        default:
+            violation("OE without read command");
+            return 0xFF;
+    }
+}
+
+/**
+ * Enters or leaves programming mode of every target, as 12V reaches it.
+ */
+static void update_programming(void) {
+    for (uint8_t n = 0; n < device_count; n++) {
+        sim_device* device = &devices[n];
+        const uint8_t enabled = powered && route(n);
+        if (enabled && !device->programming) {
+            device->command = 0;
+            memset(device->eeprom_loaded, 0, sizeof(device->eeprom_loaded));
+            for (uint16_t i = 0; i < 256; i++) {
+                device->flash_buffer[i] = 0xFFFF;
+            }
+        }
+        device->programming = enabled;
+    }
+}
+
+void sim_control(const uint8_t value, const uint8_t cycles) {
+    advance(cycles);
+    const uint8_t changed = sim_port_d ^ value;
+    sim_port_d = value;
+    if (!bus_driven) {
+        return;
+    }
+    if (changed & (PD_XA1_bm | PD_XA0_bm | PD_BS1_bm)) {
+        check(t_xtal1_low, T_XLDX_NS, "XA1, XA0 or BS1 hold after XTAL1 low (tXLDX)");
+        t_control = now();
+    }
+    if (changed & PD_BS1_bm) {
+        check(t_pagel_low, T_PLBX_NS, "BS1 hold after PAGEL low (tPLBX)");
+        check(t_wr_low, T_WLBX_NS, "BS1 hold after WR low (tWLBX)");
+        t_bs = now();
+    }
+    if (changed & PD_XTAL1_bm) {
+        if (value & PD_XTAL1_bm) {
+            check(t_xtal1_low, T_XLXH_NS, "XTAL1 low to XTAL1 high (tXLXH)");
+            check(t_control, T_DVXH_NS, "data and control valid before XTAL1 high (tDVXH)");
+            check(t_pagel_low, T_PLXH_NS, "PAGEL low to XTAL1 high (tPLXH)");
+            t_xtal1_high = now();
+            if (powered) {
+                if (!data_driven) {
+                    violation("load with DATA not driven");
+                }
+                sim_count.loads++;
+                for (uint8_t n = 0; n < device_count; n++) {
+                    if (devices[n].programming) {
+                        load(&devices[n]);
+                    }
+                }
+            }
+        } else {
+            check(t_xtal1_high, T_XHXL_NS, "XTAL1 pulse width high (tXHXL)");
+            t_xtal1_low = now();
+        }
+    }
+    if (!powered) {
+        if (changed & value & (PD_PAGEL_bm | PD_OE_bm)) {
+            violation("PAGEL or OE outside programming mode");
+        }
+        return;
+    }
+    if (changed & PD_PAGEL_bm) {
+        if (value & PD_PAGEL_bm) {
+            check(t_bs, T_BVPH_NS, "BS1 valid before PAGEL high (tBVPH)");
+            t_pagel_high = now();
+            if (!(sim_port_d & PD_BS1_bm)) {
+                violation("PAGEL with BS1 low");
+            }
+            sim_count.latches++;
+            for (uint8_t n = 0; n < device_count; n++) {
+                if (devices[n].programming) {
+                    latch(&devices[n]);
+                }
+            }
+        } else {
+            check(t_pagel_high, T_PHPL_NS, "PAGEL pulse width high (tPHPL)");
+            t_pagel_low = now();
+        }
+    }
+    if (changed & PD_WR_bm) { // INVEN, set is low
+        if (value & PD_WR_bm) {
+            uint32_t longest = 0;
+            check(t_bs, T_BVWL_NS, "BS1 valid to WR low (tBVWL)");
+            t_wr_low = now();
+            for (uint8_t n = 0; n < device_count; n++) {
+                if (devices[n].programming && wr_gate(n)) {
+                    uint32_t us = write(&devices[n]);
+                    longest = (us > longest) ? us : longest;
+                }
+            }
+            if (longest) {
+                sim_count.writes++;
+                sim_count.busy += US_TO_CYCLES(longest);
+            }
+        } else {
+            check(t_wr_low, T_WLWH_NS, "WR pulse width low (tWLWH)");
+        }
+    }
+    if (changed & PD_OE_bm) { // INVEN, set is low
+        if (value & PD_OE_bm) {
+            for (uint8_t n = 0; n < device_count; n++) {
+                if (devices[n].busy && oe_gate(n)) {
+                    violation("OE while busy");
+                }
+            }
+            if (data_driven) {
+                violation("OE low while DATA is driven");
+            }
+            t_oe_low = now();
+        } else {
+            t_oe_high = now();
+        }
+    }
+}
+
+void sim_bs2(const uint8_t level) {
+    advance(SIM_PORT_CYCLES);
+    if (bus_driven && (bs2 != level)) {
+        check(t_wr_low, T_WLBX_NS, "BS2 hold after WR low (tWLBX)");
+        t_bs = now();
+    }
+    bs2 = level;
+}
+
+void sim_data_output(const uint8_t value) {
+    advance(2 * SIM_PORT_CYCLES); // DIR and OUT
+    if (sim_port_d & PD_OE_bm) {
+        violation("DATA driven while OE is low");
+    }
+    if (!data_driven) {
+        check(t_oe_high, T_OHDZ_NS, "DATA driven before the target released it (tOHDZ)");
+    }
+    if (!data_driven || (data != value)) {
+        check(t_xtal1_low, T_XLDX_NS, "DATA hold after XTAL1 low (tXLDX)");
+        t_control = now();
+    }
+    data = value;
+    data_driven = 1;
+}
+
+void sim_data_input(void) {
+    advance(SIM_PORT_CYCLES);
+    data_driven = 0;
+}
+
+/**
+ * DATA driven by the target OE is gated to, pulled up (0xFF) when there
+ * is none; two targets driving it at once is a violation.
+ */
+uint8_t sim_data_read(void) {
+    advance(SIM_PORT_CYCLES);
+    if (!powered || !(sim_port_d & PD_OE_bm)) {
+        violation("DATA read with OE high");
+        return 0xFF;
+    }
+    // Value sampled by the input synchronizer
+    const int64_t sampled = now() - T_SYNC_CYCLES;
+    if ((sampled - t_oe_low < (int64_t) NS_TO_CYCLES(T_OLDV_NS)) ||
+            (sampled - t_bs < (int64_t) NS_TO_CYCLES(T_BVDV_NS))) {
+        violation("DATA read before it is valid (tOLDV, tBVDV)");
+    }
+    const sim_device* source = NULL;
+    for (uint8_t n = 0; n < device_count; n++) {
+        if (devices[n].programming && oe_gate(n)) {
+            if (source != NULL) {
+                violation("DATA driven by more than one target");
+            }
+            source = &devices[n];
+        }
+    }
+    return (source != NULL) ? output(source) : 0xFF;
+}
+
+uint8_t sim_ready(void) {
+    advance(SIM_PORT_CYCLES);
+    return ready();
+}
+
+void sim_supply(const uint8_t value) {
+    advance(SIM_PORT_CYCLES);
+    if (!(value & PF_5V_EN_bm)) {
+        for (uint8_t n = 0; n < device_count; n++) {
+            if (devices[n].busy && !hung) {
+                violation("supply removed during write");
+            }
+            devices[n].busy = 0;
+        }
+    }
+    powered = (value & PF_5V_EN_bm) && (value & PF_12V_EN_bm);
+    update_programming();
+    sim_port_f = value;
+}
+
+void sim_bus(const uint8_t driven) {
+    advance(3 * SIM_PORT_CYCLES);
+    bus_driven = driven;
+    if (!driven) {
+        sim_port_d = 0;
+        bs2 = 0;
+        data_driven = 0;
+        sim_port_f = 0;
+        powered = 0;
+        update_programming();
+    }
+}
+
+void sim_delay(const uint64_t cycles) {
+    advance(cycles);
+}
+
+/**
+ * Sleeps until RDY/BSY goes high or the timer expires.
+ */
+void sim_idle(void) {
+    int64_t next = next_ready();
+    if (timer_armed && (timer_alarm < next)) {
+        next = timer_alarm;
+    }
+    if (next == INT64_MAX) {
+        violation("sleep with nothing to wake up");
+        sim_ready_flag = 1;
+        sim_ready_isr();
+        return;
+    }
+    sim_count.idle += next - now();
+    advance(next - now());
+}
+
+void sim_timer_start(const uint16_t ticks) {
+    advance(6 * SIM_PORT_CYCLES);
+    timer_running = 1;
+    timer_armed = 1;
+    timer_start = now();
+    timer_alarm = now() + (int64_t) ticks * SIM_TIMER_PRESCALER;
+}
+
+void sim_timer_stop(void) {
+    advance(2 * SIM_PORT_CYCLES);
+    if (timer_running) {
+        timer_stopped = sim_timer_ticks();
+    }
+    timer_running = 0;
+    timer_armed = 0;
+}
+
+uint16_t sim_timer_ticks(void) {
+    if (!timer_running) {
+        return timer_stopped;
+    }
+    return (now() - timer_start) / SIM_TIMER_PRESCALER;
+}
+
+static void device_init(sim_device* device, const sim_target* target) {
+    device->target = *target;
+    free(device->flash);
+    free(device->eeprom);
+    device->flash = malloc(flash_words(device) * sizeof(uint16_t));
+    device->eeprom = malloc(target->eeprom_size);
+    if ((device->flash == NULL) || (device->eeprom == NULL)) {
+        fputs("sim: out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < flash_words(device); i++) {
+        device->flash[i] = 0xFFFF;
+    }
+    memset(device->eeprom, 0xFF, target->eeprom_size);
+    device->programming = 0;
+    device->busy = 0;
+}
+
+/**
+ * Powers a blank target with the given signature, geometry and fuses.
+ */
+void sim_init(const sim_target* target) {
+    device_init(&devices[0], target);
+    device_count = 1;
+    expander = 0;
+    memset(&sim_count, 0, sizeof(sim_count));
+    sim_violations = 0;
+    hung = 0;
+    timer_running = 0;
+    timer_armed = 0;
+    powered = 0;
+    bus_driven = 0;
+    t_control = t_bs = t_xtal1_high = t_xtal1_low = NEVER;
+    t_pagel_high = t_pagel_low = t_wr_low = t_oe_low = t_oe_high = NEVER;
+}
+
+/**
+ * Puts count blank copies of the sim_init() target behind the gang
+ * expander, which starts with all pins as inputs.
+ */
+void sim_gang(const uint8_t count) {
+    const sim_target target = devices[0].target;
+    device_count = (count > SIM_TARGETS_MAX) ? SIM_TARGETS_MAX : count;
+    for (uint8_t n = 0; n < device_count; n++) {
+        device_init(&devices[n], &target);
+    }
+    expander = 1;
+    memset(expander_registers, 0, sizeof(expander_registers));
+    expander_registers[MCP23017_IODIRA] = 0xFF;
+    expander_registers[MCP23017_IODIRB] = 0xFF;
+}
+
+uint16_t* sim_flash(void) {
+    return devices[0].flash;
+}
+
+uint8_t* sim_eeprom(void) {
+    return devices[0].eeprom;
+}
+
+const sim_target* sim_state(void) {
+    return &devices[0].target;
+}
+
+uint16_t* sim_flash_of(const uint8_t n) {
+    return devices[n].flash;
+}
+
+const sim_target* sim_state_of(const uint8_t n) {
+    return &devices[n].target;
+}
+
+/**
+ * With hung set, writes started from now on never complete, RDY/BSY stays
+ * low until the target is powered down.
+ */
+void sim_hang(const uint8_t stuck) {
+    hung = stuck;
+}
+
+/**
+ * Returns nonzero when the gang expander answers on the I2C bus.
+ */
+uint8_t sim_expander_present(void) {
+    return expander;
+}
+
+/**
+ * Writing GPIOA or GPIOB writes the output latch.
+ */
+void sim_expander_write(uint8_t address, const uint8_t value) {
+    advance(SIM_PORT_CYCLES);
+    if ((address == MCP23017_GPIOB - 1) || (address == MCP23017_GPIOB)) {
+        address += MCP23017_OLATA - (MCP23017_GPIOB - 1);
+    }
+    if (address < SIM_EXPANDER_REGISTERS) {
+        expander_registers[address] = value;
+    }
+    update_programming();
+}
+
+/**
+ * GPIOB reads the pins: 12V routes as driven, RDY/BSY of each target
+ * (high when ready or not fitted).
+ */
+uint8_t sim_expander_read(const uint8_t address) {
+    advance(SIM_PORT_CYCLES);
+    if (address == MCP23017_GPIOB) {
+        uint8_t value = 0xF0;
+        for (uint8_t n = 0; n < GANG_TARGETS_MAX; n++) {
+            value |= route(n) << n;
+            if ((n < device_count) && devices[n].busy) {
+                value &= ~(1 << (4 + n));
+            }
+        }
+        return value;
+    }
+    return (address < SIM_EXPANDER_REGISTERS) ? expander_registers[address] : 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * File:   sim.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Host side of hal.h: the programming bus of a simulated ATmega (see sim.c).
+ * Every port access advances a cycle counter clocked at F_CPU, so the same
+ * prog.c which runs on the programmer can be profiled and checked against
+ * the parallel programming timing on Linux. Also stands in for the AVR 
+ * headers of config.h when the whole firmware is built for the host.
+ */
+
+#ifndef SIM_H
+#define	SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIN0_bm 0x01
+#define PIN1_bm 0x02
+#define PIN2_bm 0x04
+#define PIN3_bm 0x08
+#define PIN4_bm 0x10
+#define PIN5_bm 0x20
+#define PIN6_bm 0x40
+#define PIN7_bm 0x80
+
+#include "pins.h"
+
+/* Port writes and reads, cost in CPU cycles of the equivalent AVR code */
+#define SIM_PORT_CYCLES 1
+#define SIM_LOAD_CYCLES 3
+
+#define HAL_CONTROL_SET(bits) sim_control(sim_port_d | (bits), SIM_PORT_CYCLES)
+#define HAL_CONTROL_CLEAR(bits) sim_control(sim_port_d & ~(bits), SIM_PORT_CYCLES)
+#define HAL_CONTROL_LOAD(mask, bits) sim_control((sim_port_d & ~(mask)) | (bits), SIM_LOAD_CYCLES)
+#define HAL_BS2_SET() sim_bs2(1)
+#define HAL_BS2_CLEAR() sim_bs2(0)
+
+#define HAL_DATA_OUTPUT(data) sim_data_output(data)
+#define HAL_DATA_INPUT() sim_data_input()
+#define HAL_DATA_READ() sim_data_read()
+
+#define HAL_READY() sim_ready()
+#define HAL_READY_FLAG() (sim_ready_flag)
+#define HAL_READY_FLAG_CLEAR() (sim_ready_flag = 0)
+#define HAL_READY_ISR() void sim_ready_isr(void)
+#define HAL_READY_PULLDOWN() ((void) 0)
+#define HAL_READY_RELEASE() ((void) 0)
+
+#define HAL_SUPPLY_SET(bits) sim_supply(sim_port_f | (bits))
+#define HAL_SUPPLY_CLEAR(bits) sim_supply(sim_port_f & ~(bits))
+
+#define HAL_PROGRAM_PRESSED() (sim_button)
+
+#define HAL_BUS_CONTROL() sim_bus(1)
+#define HAL_BUS_RELEASE() sim_bus(0)
+
+#define HAL_DELAY_CYCLES(cycles) sim_delay(cycles)
+#define HAL_DELAY_US(us) sim_delay((uint64_t) (us) * (F_CPU / 1000000UL))
+#define HAL_DELAY_MS(ms) sim_delay((uint64_t) (ms) * (F_CPU / 1000UL))
+/* util/delay.h, for firmware sources outside hal.h built for the host */
+#define _delay_us(us) HAL_DELAY_US(us)
+#define _delay_ms(ms) HAL_DELAY_MS(ms)
+
+#define HAL_TIMER_HZ (F_CPU / 64)
+#define HAL_TIMER_START(ticks) sim_timer_start(ticks)
+#define HAL_TIMER_STOP() sim_timer_stop()
+#define HAL_TIMER_TICKS() sim_timer_ticks()
+#define HAL_TIMER_FLAG_CLEAR() ((void) 0)
+#define HAL_TIMER_ISR() void sim_timer_isr(void)
+
+#define HAL_CLOCK_HZ 1024
+#define HAL_CLOCK() ((uint16_t) (sim_count.total * HAL_CLOCK_HZ / F_CPU))
+
+/* Nothing preempts the simulated ISR, it runs from sim_idle() and port accesses */
+#define HAL_INTERRUPTS_DISABLE() ((void) 0)
+#define HAL_INTERRUPTS_ENABLE() ((void) 0)
+#define HAL_IDLE() sim_idle()
+
+/* Targets behind the gang expander, see sim_gang() */
+#define SIM_TARGETS_MAX 4
+
+/* Simulated target */
+typedef struct {
+    uint32_t signature;
+    uint8_t flash_page_words;
+    uint16_t flash_pages;
+    uint8_t eeprom_page_size;
+    uint16_t eeprom_size;
+    uint8_t fuses[3];                   /* Low, high, extended */
+    uint8_t lock;
+} sim_target;
+
+/* Time spent, in CPU cycles */
+typedef struct {
+    uint64_t total;
+    uint64_t idle;                      /* Sleeping in target_wait() */
+    uint64_t busy;                      /* Target busy writing */
+    uint32_t writes;                    /* WR pulses which started a write */
+    uint32_t loads;                     /* XTAL1 pulses loading command, address or data */
+    uint32_t latches;                   /* PAGEL pulses latching a page buffer word */
+} sim_counters;
+
+extern uint8_t sim_port_d;
+extern uint8_t sim_port_f;
+extern volatile uint8_t sim_ready_flag;
+extern sim_counters sim_count;
+extern uint32_t sim_violations;
+extern uint8_t sim_button;
+
+void sim_ready_isr(void);
+void sim_timer_isr(void);
+
+void sim_control(const uint8_t value, const uint8_t cycles);
+void sim_bs2(const uint8_t level);
+void sim_data_output(const uint8_t data);
+void sim_data_input(void);
+uint8_t sim_data_read(void);
+uint8_t sim_ready(void);
+void sim_supply(const uint8_t value);
+void sim_bus(const uint8_t driven);
+void sim_delay(const uint64_t cycles);
+void sim_idle(void);
+void sim_timer_start(const uint16_t ticks);
+void sim_timer_stop(void);
+uint16_t sim_timer_ticks(void);
+
+void sim_init(const sim_target* target);
+uint16_t* sim_flash(void);
+uint8_t* sim_eeprom(void);
+const sim_target* sim_state(void);
+void sim_hang(const uint8_t hung);
+void sim_gang(const uint8_t count);
+uint16_t* sim_flash_of(const uint8_t n);
+const sim_target* sim_state_of(const uint8_t n);
+uint8_t sim_expander_present(void);
+void sim_expander_write(uint8_t address, const uint8_t value);
+uint8_t sim_expander_read(const uint8_t address);
+
+/* I2C bus of twi.h, see simtwi.c */
+uint8_t* sim_store(void);
+void sim_store_attach(uint8_t* memory);
+
+#endif	/* SIM_H */
@@ -0,0 +1,437 @@
+/*
+ * File:   simbench.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Runs ../prog.c against the simulated target of sim.c and prints how long
+ * each operation keeps the programmer busy, split into bus time (driving
+ * the target) and waiting for RDY/BSY. Exits with failure when contents
+ * read back do not match or the bus timing is violated. The image store
+ * of standalone mode is the simulated 24xx1025 of simtwi.c, gang mode runs
+ * on targets behind its simulated expander.
+ *
+ *   simbench [signature]
+ */
+
+#include "prog.h"
+#include "job.h"
+#include "store.h"
+#include "standalone.h"
+#include "session.h"
+#include "gang.h"
+
+static int failures = 0;
+static sim_counters mark;
+
+static void begin(void) {
+    mark = sim_count;
+}
+
+static void end(const char* name) {
+    uint64_t total = sim_count.total - mark.total;
+    uint64_t idle = sim_count.idle - mark.idle;
+    printf("%-16s %10llu %10.1f %10.1f %6u\n", name,
+            (unsigned long long) (total - idle),
+            (total - idle) * 1e6 / F_CPU,
+            idle * 1e3 / F_CPU,
+            sim_count.writes - mark.writes);
+}
+
+static void expect(const int condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "simbench: %s\n", what);
+        failures++;
+    }
+}
+
+/* Console of ../job.c, see fmt.c */
+int usart1_putc(const char c, FILE* stream) {
+    (void) stream;
+    return putchar(c);
+}
+
+void usart1_puts(const char* s) {
+    fputs(s, stdout);
+}
+
+/* Image store of job runs: Flash image, then EEPROM data */
+static uint8_t* store;
+static uint32_t store_length;
+
+static int8_t store_reader(const uint32_t offset, uint8_t* data, const uint16_t length) {
+    if (offset + length > store_length) {
+        return -1;
+    }
+    memcpy(data, store + offset, length);
+    return 0;
+}
+
+/**
+ * Compiles job steps given in text, one per string, NULL terminated.
+ */
+static int16_t compile(uint8_t* job, const char* const* steps) {
+    int16_t length = 0;
+    char text[64];
+    for (; (*steps != NULL) && (length >= 0); steps++) {
+        snprintf(text, sizeof(text), "%s", *steps);
+        length = job_compile(text, job, length);
+    }
+    return length;
+}
+
+static uint32_t image_crc32(const uint16_t* image, const uint32_t words) {
+    uint32_t crc = CRC32_INIT;
+    for (uint32_t i = 0; i < words; i++) {
+        crc = crc32_update(crc, image[i] & 0xFF);
+        crc = crc32_update(crc, image[i] >> 8);
+    }
+    return CRC32_FINAL(crc);
+}
+
+int main(int argc, char** argv) {
+    uint32_t signature = (argc > 1) ? strtoul(argv[1], NULL, 16) : 0x1E950F;
+    const avr_record* record = lookup_signature(signature);
+    if (record == NULL) {
+        fprintf(stderr, "simbench: unknown signature %06X\n", signature);
+        return EXIT_FAILURE;
+    }
+    sim_target device = {
+        signature, record->flash_page_words, record->flash_pages,
+        record->eeprom_page_size, record->eeprom_size,
+        {record->fuse_low_factory, record->fuse_high_factory, record->fuse_extended_factory},
+        record->lock_factory
+    };
+    sim_init(&device);
+    // program_flash() counts words in 16 bits, 128 KiB parts are covered up to 64 KiB
+    const uint32_t words = (AVR_FLASH_WORDS(record) > 0x8000) ? 0x8000 : AVR_FLASH_WORDS(record);
+    const uint8_t page_words = record->flash_page_words;
+    printf("%s, %u pages of %u words, EEPROM %u bytes\n", record->name,
+            record->flash_pages, page_words, record->eeprom_size);
+    printf("%-16s %10s %10s %10s %6s\n", "operation", "bus cycles", "bus us", "busy ms", "writes");
+
+    /* Image with a blank hole, which is skipped after chip erase */
+    uint16_t* image = malloc(words * sizeof(uint16_t));
+    uint8_t* data = malloc(record->eeprom_size);
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < words; i++) {
+        seed = seed * 1103515245UL + 12345;
+        image[i] = ((i / page_words) % 4 == 3) ? 0xFFFF : (seed >> 16);
+    }
+    for (uint16_t i = 0; i < record->eeprom_size; i++) {
+        data[i] = i ^ 0x5A;
+    }
+
+    begin();
+    enter_programming();
+    end("enter");
+
+    uint32_t read;
+    begin();
+    read_signature(&read);
+    end("signature");
+    expect(read == signature, "signature mismatch");
+
+    uint8_t fuses[4];
+    begin();
+    read_fuse_and_lock_bits(fuses, record->flags & AVR_FLAG_FUSE_EXTENDED);
+    end("read fuses");
+    expect((fuses[0] == record->fuse_low_factory) && (fuses[1] == record->fuse_high_factory),
+            "factory fuses mismatch");
+
+    begin();
+    erase_chip();
+    end("erase");
+
+    begin();
+    expect(program_flash(0, image, words, page_words) == PROG_OK, "Flash programming failed");
+    end("write flash");
+    expect(memcmp(sim_flash(), image, words * sizeof(uint16_t)) == 0, "Flash contents mismatch");
+    /* Every fourth page is blank and skipped after erase */
+    const uint32_t image_pages = (words + page_words - 1) / page_words;
+    expect(sim_count.writes - mark.writes == image_pages - image_pages / 4, 
+            "blank pages written after erase");
+    /* Page buffer: one PAGEL per word, one WR per page */
+    expect(sim_count.latches - mark.latches == (sim_count.writes - mark.writes) * page_words, 
+            "Flash page buffer not loaded word by word");
+
+    begin();
+    uint32_t crc = read_flash_crc32(0, 2 * words);
+    end("crc flash");
+    expect(crc == image_crc32(image, words), "Flash CRC-32 mismatch");
+    /* Streaming readback: command once, address high byte only when it changes */
+    expect(sim_count.loads - mark.loads == 1 + words + (words + 255) / 256, 
+            "Flash readback reloads command or address high byte");
+
+    begin();
+    read_eeprom_start();
+    for (uint16_t i = 0; i < record->eeprom_size; i++) {
+        read = read_eeprom_next(i);
+        expect(read == sim_eeprom()[i], "EEPROM readback mismatch");
+    }
+    end("read eeprom");
+    expect(sim_count.loads - mark.loads == 1 + (uint32_t) record->eeprom_size + (record->eeprom_size + 255) / 256,
+            "EEPROM readback reloads command or address high byte");
+
+    begin();
+    int16_t pages = program_eeprom(0, data, record->eeprom_size, record->eeprom_page_size);
+    end("write eeprom");
+    expect((pages == record->eeprom_size / record->eeprom_page_size) && 
+            (sim_count.writes - mark.writes == (uint32_t) pages), "EEPROM pages written");
+    expect(memcmp(sim_eeprom(), data, record->eeprom_size) == 0, "EEPROM contents mismatch");
+
+    begin();
+    pages = program_eeprom(0, data, record->eeprom_size, record->eeprom_page_size);
+    end("rewrite eeprom");
+    expect((pages == 0) && (sim_count.writes == mark.writes), "unchanged EEPROM pages written");
+
+    data[5] ^= 0xFF;
+    begin();
+    pages = program_eeprom(5, data + 5, 1, record->eeprom_page_size);
+    end("write 1 byte");
+    expect((pages == 1) && (sim_count.writes == mark.writes + 1) && 
+            (memcmp(sim_eeprom(), data, record->eeprom_size) == 0), "EEPROM partial page mismatch");
+
+    begin();
+    program_fuse_low_bits(0xFF);
+    program_fuse_high_bits(record->fuse_high_factory);
+    if (record->flags & AVR_FLAG_FUSE_EXTENDED) {
+        program_fuse_extended_bits(record->fuse_extended_factory);
+    }
+    read_fuse_and_lock_bits(fuses, record->flags & AVR_FLAG_FUSE_EXTENDED);
+    end("write fuses");
+    expect(fuses[0] == 0xFF, "fuse low mismatch");
+
+    /* Transaction writes only the bytes which differ, lock last */
+    const uint8_t extended = record->flags & AVR_FLAG_FUSE_EXTENDED;
+    const uint8_t all = FUSE_LOW_bm | FUSE_HIGH_bm | FUSE_LOCK_bm | (extended ? FUSE_EXTENDED_bm : 0);
+    uint8_t bits[FUSE_BYTES] = { 0xFF, record->fuse_high_factory, 
+        extended ? record->fuse_extended_factory : 0xFF, record->lock_factory };
+    uint32_t writes = sim_count.writes;
+    begin();
+    int8_t written = program_fuse_and_lock_bits(bits, all, extended, 0);
+    end("fuse set same");
+    expect((written == 0) && (sim_count.writes == writes), "unchanged fuse bytes written");
+    bits[FUSE_LOW] = record->fuse_low_factory;
+    bits[FUSE_LOCK] = record->lock_factory & 0xFC;
+    begin();
+    written = program_fuse_and_lock_bits(bits, all, extended, 0);
+    end("fuse set 2");
+    expect((written == (FUSE_LOW_bm | FUSE_LOCK_bm)) && (sim_count.writes == writes + 2) &&
+            (bits[FUSE_LOW] == record->fuse_low_factory) && (bits[FUSE_LOCK] == (record->lock_factory & 0xFC)),
+            "fuse transaction mismatch");
+    bits[FUSE_LOCK] = record->lock_factory;
+    expect(program_fuse_and_lock_bits(bits, FUSE_LOCK_bm, extended, 0) == PROG_ERROR_NOT_ERASED,
+            "lock bits cleared without chip erase");
+
+    /* Longest write times measured by target_wait() */
+    static const char* const kinds[WRITE_KINDS] = { "erase", "flash page", "eeprom page", "fuse, lock" };
+    for (uint8_t kind = 0; kind < WRITE_KINDS; kind++) {
+        printf("%-16s %10.3f ms, timeout %.3f ms\n", kinds[kind], 
+                target_write_time_us(kind) / 1e3, target_timeout_us(kind) / 1e3);
+    }
+
+    /* Host slower than the write: RDY/BSY is high before target_wait() */
+    exit_programming();
+    enter_programming();
+    expect(program_flash_page_start(0, image, page_words) == PROG_OK, "pipelined page write failed");
+    HAL_DELAY_MS(10);
+    expect(program_flash_finish() == PROG_OK, "pipelined page write timed out");
+    const uint32_t measured = target_write_time_us(WRITE_FLASH);
+    const uint32_t timeout = target_timeout_us(WRITE_FLASH);
+    expect((measured > 0) && (timeout >= 2 * measured) && (timeout < T_TIMEOUT_FACTOR * T_WLRH_US),
+            "write completed before target_wait() not measured");
+
+    exit_programming();
+    enter_programming(); // Clears update mode
+    set_flash_update_mode(1);
+    begin();
+    expect(program_flash(0, image, words, page_words) == PROG_OK, "Flash update failed");
+    end("update same");
+    expect(sim_count.writes == mark.writes, "unchanged pages written in update mode");
+    image[0] = 0xFFFF;
+    begin();
+    expect(program_flash(0, image, page_words, page_words) == PROG_ERROR_NOT_ERASED,
+            "Flash update did not refuse erasing bits");
+    end("update erase");
+    set_flash_update_mode(0);
+
+    begin();
+    exit_programming();
+    end("exit");
+
+    /* Whole per-board flow as one job */
+    store_length = 2 * words + record->eeprom_size;
+    store = malloc(store_length);
+    memcpy(store, image, 2 * words);
+    memcpy(store + 2 * words, data, record->eeprom_size);
+    uint32_t eeprom_crc = CRC32_INIT;
+    for (uint16_t i = 0; i < record->eeprom_size; i++) {
+        eeprom_crc = crc32_update(eeprom_crc, data[i]);
+    }
+    char steps[6][48];
+    snprintf(steps[0], sizeof(steps[0]), "enter %06X", signature);
+    snprintf(steps[1], sizeof(steps[1]), "write flash 0 %X 0", 2 * words);
+    snprintf(steps[2], sizeof(steps[2]), "verify flash 0 %X %08X", 2 * words, image_crc32(image, words));
+    snprintf(steps[3], sizeof(steps[3]), "write eeprom 0 %X %X", record->eeprom_size, 2 * words);
+    snprintf(steps[4], sizeof(steps[4]), "verify eeprom 0 %X %08X", record->eeprom_size, 
+            (unsigned) CRC32_FINAL(eeprom_crc));
+    snprintf(steps[5], sizeof(steps[5]), "fuse low=%02X high=%02X", record->fuse_low_factory, 
+            record->fuse_high_factory);
+    const char* const flow[] = { steps[0], "erase", steps[1], steps[2], steps[3], steps[4], steps[5], 
+        "delay 10", "run", "exit", NULL };
+    uint8_t job[JOB_SIZE_MAX];
+    job_status status;
+    int16_t length = compile(job, flow);
+    expect(length > 0, "job compile failed");
+    begin();
+    job_execute(job, length, store_reader, &status);
+    end("job");
+    expect((status.result == JOB_OK) && (status.step == 10) && (status.target == JOB_TARGET_OFF), 
+            "job failed");
+    expect((memcmp(sim_flash(), image, words * sizeof(uint16_t)) == 0) && 
+            (memcmp(sim_eeprom(), data, record->eeprom_size) == 0), "job contents mismatch");
+    /* HAL_CLOCK() ticks are just below 1 ms */
+    expect(abs((int32_t) status.ms - (int32_t) ((sim_count.total - mark.total) * 1000 / F_CPU)) <= 2, 
+            "job duration");
+    const char* const broken[] = { steps[0], "verify flash 0 100 0", "erase", NULL };
+    length = compile(job, broken);
+    job_execute(job, length, store_reader, &status);
+    expect((status.result == JOB_ERROR_VERIFY) && (status.step == 1) && (status.op == JOB_OP_VERIFY_FLASH) &&
+            (status.target == JOB_TARGET_OFF), "job failure not reported");
+    /* Ranges past the end of memory, including ones where address + length wraps */
+    char range[5][48];
+    snprintf(range[0], sizeof(range[0]), "write flash %X %X 0", 0U - 2 * page_words, 4 * page_words);
+    snprintf(range[1], sizeof(range[1]), "verify flash 0 %X 0", (unsigned) AVR_FLASH_SIZE(record) + 1);
+    snprintf(range[2], sizeof(range[2]), "verify flash FFFFFFFF 2 0");
+    snprintf(range[3], sizeof(range[3]), "verify eeprom 1 %X 0", record->eeprom_size);
+    snprintf(range[4], sizeof(range[4]), "write eeprom %X 1 0", record->eeprom_size);
+    for (uint8_t i = 0; i < 5; i++) {
+        const char* const outside[] = { steps[0], range[i], NULL };
+        length = compile(job, outside);
+        job_execute(job, length, store_reader, &status);
+        expect((status.result == JOB_ERROR_FORMAT) && (status.step == 1), "range past the end of memory");
+    }
+    char text[] = "write flash 0";
+    expect(job_compile(text, job, 0) == JOB_ERROR_FORMAT, "malformed step compiled");
+    free(store);
+
+    /* Standalone: image stored over I2C, programmed on a ~{PROGRAM} press */
+    uint16_t* stored = malloc(words * sizeof(uint16_t));
+    for (uint32_t i = 0; i < words; i++) {
+        stored[i] = image[i] ^ (uint16_t) i;
+    }
+    store_header header = { 0 };
+    header.signature = signature;
+    header.image_length = 2 * words;
+    header.image_crc = image_crc32(stored, words);
+    header.page_words = page_words;
+    header.flags = STORE_FLAG_FUSES;
+    header.fuse_low = 0xFF;
+    header.fuse_high = record->fuse_high_factory;
+    header.fuse_extended = record->fuse_extended_factory;
+    header.lock = 0xFF;
+    store_init();
+    begin();
+    for (uint32_t offset = 0; offset < 2 * words; offset += 4096) {
+        uint16_t chunk = (2 * words - offset < 4096) ? (2 * words - offset) : 4096;
+        expect(store_write(STORE_IMAGE_OFFSET + offset, (const uint8_t*) stored + offset, chunk) == 0,
+                "store write failed");
+    }
+    expect(store_write_header(&header) == 0, "store header write failed");
+    expect((store_write(0xFFFFFFF0UL, (const uint8_t*) stored, 32) < 0) &&
+            (store_read(0xFFFFFFF0UL, (uint8_t*) stored, 32) < 0), "store range wrapping to the start");
+    end("store image");
+    expect(memcmp(sim_store() + STORE_IMAGE_OFFSET, stored, 2 * words) == 0, "store contents mismatch");
+    uint32_t stored_crc;
+    expect((store_image_crc32(2 * words, &stored_crc) == 0) && (stored_crc == header.image_crc), 
+            "store CRC-32 mismatch");
+    sim_button = 1;
+    writes = sim_count.writes;
+    for (uint8_t i = 0; i < STANDALONE_DEBOUNCE_MS; i++) {
+        standalone_poll();
+    }
+    expect(sim_count.writes == writes, "button not debounced");
+    begin();
+    standalone_poll();
+    end("standalone");
+    expect(sim_count.writes > writes, "standalone did not start after debounce");
+    for (uint8_t i = 0; i < STANDALONE_DEBOUNCE_MS; i++) {
+        standalone_poll();
+    }
+    sim_button = 0;
+    standalone_poll();
+    expect(memcmp(sim_flash(), stored, words * sizeof(uint16_t)) == 0, "standalone Flash mismatch");
+    expect(sim_state()->fuses[0] == 0xFF, "standalone fuses not programmed");
+    expect((session_mode == SESSION_OFF) && (sim_port_f == 0), "standalone left target powered");
+    writes = sim_count.writes;
+    for (uint8_t i = 0; i < 2 * STANDALONE_DEBOUNCE_MS; i++) {
+        standalone_poll();
+    }
+    expect(sim_count.writes == writes, "standalone ran without a press");
+    free(stored);
+
+    /* Gang: expander fitted for four targets, three present */
+    sim_gang(3);
+    gang_disable(); // As at startup, the expander pins are still inputs
+    enter_programming();
+    read_signature(&read);
+    exit_programming();
+    expect(read == signature, "gang expander does not route target 0");
+    expect(gang_enable(4) == GANG_OK, "gang expander not found");
+    begin();
+    expect((session_enter(&read) == SESSION_OK) && (gang_targets == 0x07), "gang targets not matched");
+    expect(erase_chip() == PROG_OK, "gang erase failed");
+    expect(program_flash(0, image, words, page_words) == PROG_OK, "gang programming failed");
+    uint8_t ready_mask = 0;
+    expect((gang_ready(&ready_mask) == GANG_OK) && (ready_mask == 0x0F), "gang RDY/BSY not read");
+    sim_flash_of(1)[words / 2] ^= 0x0100;
+    uint8_t matching = gang_verify_flash(0, 2 * words, image_crc32(image, words));
+    end("gang 3 of 4");
+    expect(matching == 0x05, "gang verify does not single out the corrupted target");
+    for (uint8_t n = 0; n < 3; n++) {
+        expect((memcmp(sim_flash_of(n), image, words * sizeof(uint16_t)) == 0) == (n != 1), 
+                "gang Flash contents mismatch");
+    }
+    session_exit();
+    gang_disable();
+    const uint8_t fuse_low = sim_state_of(2)->fuses[0];
+    enter_programming();
+    program_fuse_low_bits(fuse_low ^ 0x10);
+    exit_programming();
+    expect((sim_state_of(0)->fuses[0] == (fuse_low ^ 0x10)) && (sim_state_of(2)->fuses[0] == fuse_low), 
+            "gang disable does not return to target 0 alone");
+
+    if (sim_violations) {
+        fprintf(stderr, "simbench: %u bus timing or protocol violations\n", sim_violations);
+        failures++;
+    }
+
+    /* Target stops responding after the first page */
+    enter_programming();
+    expect(erase_chip() == PROG_OK, "erase before hang");
+    begin();
+    expect(program_flash_page_start(0, image, page_words) == PROG_OK, "page before hang");
+    sim_hang(1);
+    expect(program_flash_page_start(page_words, image + page_words, page_words) == PROG_OK, 
+            "page before hang");
+    expect(program_flash_finish() == PROG_ERROR_TIMEOUT, "hung page write not detected");
+    end("hung page");
+    expect((sim_count.idle - mark.idle) * 1e6 / F_CPU < 
+            target_timeout_us(WRITE_FLASH) + target_write_time_us(WRITE_FLASH) + 100,
+            "hung page write detected late");
+    begin();
+    expect(erase_chip() == PROG_ERROR_TIMEOUT, "hung erase not detected");
+    expect(program_fuse_low_bits(0xFF) == PROG_ERROR_TIMEOUT, "hung fuse write not detected");
+    end("hung erase, fuse");
+    /* The readback of the next page waits out the hung one, the timeout still reaches the caller */
+    memcpy(data, sim_eeprom(), 2 * record->eeprom_page_size);
+    data[0] ^= 0xFF;
+    begin();
+    expect(program_eeprom(0, data, 2 * record->eeprom_page_size, record->eeprom_page_size) == PROG_ERROR_TIMEOUT,
+            "hung EEPROM page write not detected");
+    end("hung eeprom");
+    exit_programming();
+    printf("total %.1f ms, %s\n", sim_count.total * 1e3 / F_CPU, failures ? "FAILED" : "ok");
+    free(image);
+    free(data);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/*
+ * File:   simtwi.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Host side of twi.c: the I2C bus of the programmer with the image store
+ * (24xx1025) on it, and the gang expander (MCP23017) once sim_gang() has
+ * fitted one, on the simulated clock of sim.c. Every byte takes its
+ * 9 bus clocks at TWI0_FREQUENCY. Writes wrap within a page, reads run on
+ * through the 64 KB block as on the chip; after a page write the device
+ * NACKs its address for SIM_STORE_WRITE_US, so the acknowledge polling of 
+ * store.c is exercised. Expander registers are written and read through 
+ * sim.c, from the register pointer set by the first byte written and then
+ * incremented (IOCON.SEQOP = 0).
+ */
+
+#include "sim.h"
+#include "store.h"
+#include "twi.h"
+#include "gang.h"
+
+/* Write cycle, 5 ms maximum */
+#define SIM_STORE_WRITE_US 3500
+
+#define SIM_TWI_BYTE_CYCLES (9 * F_CPU / TWI0_FREQUENCY)
+#define SIM_TWI_BIT_CYCLES (F_CPU / TWI0_FREQUENCY)
+
+static uint8_t store_memory[STORE_SIZE];
+static uint8_t* store = NULL;
+
+static uint32_t store_block;            /* Selected by the block select bit */
+static uint32_t store_pointer;
+static uint8_t store_phase;             /* Address bytes received after a write start */
+static uint8_t store_written;           /* Data bytes received since the start */
+static uint64_t store_busy_until = 0;
+
+static uint8_t selected = 0;            /* Device addressed by the last start */
+
+static uint8_t expander_pointer;
+static uint8_t expander_phase;          /* Register pointer received after a write start */
+
+/**
+ * Store contents, blank (0xFF) until written or attached.
+ */
+uint8_t* sim_store(void) {
+    if (store == NULL) {
+        memset(store_memory, 0xFF, sizeof(store_memory));
+        store = store_memory;
+    }
+    return store;
+}
+
+/**
+ * Keeps the store in the given STORE_SIZE bytes instead, e.g. a mapped file.
+ */
+void sim_store_attach(uint8_t* memory) {
+    store = memory;
+}
+
+void twi_init(void) {
+    sim_store();
+}
+
+int8_t twi_start(const uint8_t address, const uint8_t direction) {
+    sim_delay(SIM_TWI_BIT_CYCLES + SIM_TWI_BYTE_CYCLES);
+    selected = 0;
+    if ((address == GANG_I2C_ADDRESS) && sim_expander_present()) {
+        selected = GANG_I2C_ADDRESS;
+        expander_phase = (direction == TWI_WRITE) ? 0 : 1;
+        return 0;
+    }
+    if (((address & ~STORE_I2C_BLOCK_bm) != STORE_I2C_ADDRESS) || 
+        (sim_count.total < store_busy_until)) {
+        return -1;
+    }
+    sim_store();
+    selected = STORE_I2C_ADDRESS;
+    store_block = (address & STORE_I2C_BLOCK_bm) ? 0x10000UL : 0;
+    store_pointer = store_block | (store_pointer & 0xFFFF);
+    store_phase = (direction == TWI_WRITE) ? 0 : 2;
+    store_written = 0;
+    return 0;
+}
+
+int8_t twi_write(const uint8_t data) {
+    sim_delay(SIM_TWI_BYTE_CYCLES);
+    if (selected == GANG_I2C_ADDRESS) {
+        if (expander_phase == 0) {
+            expander_pointer = data;
+            expander_phase++;
+        } else {
+            sim_expander_write(expander_pointer++, data);
+        }
+        return 0;
+    }
+    if (selected != STORE_I2C_ADDRESS) {
+        return -1;
+    }
+    if (store_phase == 0) {
+        store_pointer = store_block | ((uint32_t) data << 8);
+        store_phase++;
+    } else if (store_phase == 1) {
+        store_pointer |= data;
+        store_phase++;
+    } else {
+        store[store_pointer] = data;
+        store_pointer = (store_pointer & ~(STORE_PAGE_SIZE - 1UL)) | ((store_pointer + 1) & (STORE_PAGE_SIZE - 1));
+        store_written = 1;
+    }
+    return 0;
+}
+
+uint8_t twi_read(const uint8_t last) {
+    (void) last;
+    sim_delay(SIM_TWI_BYTE_CYCLES);
+    if (selected == GANG_I2C_ADDRESS) {
+        return sim_expander_read(expander_pointer++);
+    }
+    if (selected != STORE_I2C_ADDRESS) {
+        return 0xFF;
+    }
+    uint8_t data = store[store_pointer];
+    store_pointer = store_block | ((store_pointer + 1) & 0xFFFF);
+    return data;
+}
+
+/**
+ * Stop after data bytes starts the write cycle.
+ */
+void twi_stop(void) {
+    sim_delay(SIM_TWI_BIT_CYCLES);
+    if ((selected == STORE_I2C_ADDRESS) && store_written) {
+        store_busy_until = sim_count.total + (uint64_t) SIM_STORE_WRITE_US * (F_CPU / 1000000UL);
+    }
+    selected = 0;
+    store_written = 0;
+}
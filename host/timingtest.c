@@ -0,0 +1,69 @@
+/*
+ * File:   timingtest.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Delays derived by ../timing.h, at every OSCHF clock the firmware can be
+ * built for: a port write followed by WAIT_CYCLES(ns) has to last at least
+ * the datasheet minimum, and a read after WAIT_READ_NS has to leave the
+ * data (maximum) settle time plus the input synchronizer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "timing.h"
+
+#define T_BUS(X) \
+    X(T_DVXH_NS) X(T_XLXH_NS) X(T_XHXL_NS) X(T_XLDX_NS) X(T_BVPH_NS) \
+    X(T_PHPL_NS) X(T_PLBX_NS) X(T_PLXH_NS) X(T_BVWL_NS) X(T_WLWH_NS) \
+    X(T_WLBX_NS) X(T_OHDZ_NS)
+
+#define T_READ(X) X(T_BVDV_NS) X(T_OLDV_NS) X(T_MAX(T_OLDV_NS, T_BVDV_NS))
+
+static int failures = 0;
+
+static void check(const uint32_t clock, const char* name, const uint32_t ns, 
+        const uint32_t cycles) {
+    /* Compared in cycles * 1e9 to avoid rounding */
+    if ((uint64_t) cycles * 1000000000ULL < (uint64_t) ns * clock) {
+        fprintf(stderr, "timingtest: %lu Hz: %s %lu ns got %lu cycles\n",
+                (unsigned long) clock, name, (unsigned long) ns, (unsigned long) cycles);
+        failures++;
+    }
+}
+
+#define CHECK_WRITE(t) check(F_CPU, #t, t, WAIT_CYCLES(t) + T_WRITE_CYCLES);
+/* T_SYNC_CYCLES come on top of WAIT_READ_NS, the settle time alone has to do */
+#define CHECK_READ(t) check(F_CPU, #t, t, NS_TO_CYCLES(t));
+
+#define CHECK_CLOCK() do { \
+    T_BUS(CHECK_WRITE) \
+    T_READ(CHECK_READ) \
+    printf("%2lu MHz  tWLWH %2lu cycles  tOLDV %2lu + %u cycles\n", F_CPU / 1000000UL, \
+            (unsigned long) (WAIT_CYCLES(T_WLWH_NS) + T_WRITE_CYCLES), \
+            (unsigned long) NS_TO_CYCLES(T_OLDV_NS), T_SYNC_CYCLES); \
+} while (0)
+
+int main(void) {
+#undef F_CPU
+#define F_CPU 4000000UL
+    CHECK_CLOCK();
+#undef F_CPU
+#define F_CPU 8000000UL
+    CHECK_CLOCK();
+#undef F_CPU
+#define F_CPU 12000000UL
+    CHECK_CLOCK();
+#undef F_CPU
+#define F_CPU 16000000UL
+    CHECK_CLOCK();
+#undef F_CPU
+#define F_CPU 20000000UL
+    CHECK_CLOCK();
+#undef F_CPU
+#define F_CPU 24000000UL
+    CHECK_CLOCK();
+
+    printf("timingtest %s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
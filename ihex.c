@@ -0,0 +1,126 @@
+/*
+ * File:   ihex.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Kept free of any AVR headers, so it can be built for the host as well.
+ */
+
+#include "ihex.h"
+
+#define IHEX_STATE_IDLE 0               /* Between records, expecting ':' */
+#define IHEX_STATE_RECORD 1
+#define IHEX_STATE_LINE_END 2           /* Record processed, expecting end of line */
+#define IHEX_STATE_DONE 3               /* End of file record processed */
+#define IHEX_STATE_ERROR 4
+
+void ihex_reset(ihex_parser* parser) {
+    parser->state = IHEX_STATE_IDLE;
+    parser->base = 0;
+    parser->line = 1;
+}
+
+static int8_t ihex_hex_digit(const char c) {
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    } else if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    } else if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static int8_t ihex_record(ihex_parser* parser, 
+        int8_t (*write)(const uint32_t address, const uint8_t* data, const uint8_t length)) {
+    const uint8_t* record = parser->record;
+    const uint8_t length = record[0];
+    const uint16_t offset = ((uint16_t) record[1] << 8) | record[2];
+    uint8_t sum = 0;
+    for (uint16_t i = 0; i < 5 + length; i++) {
+        sum += record[i];
+    }
+    if (sum != 0) {
+        return IHEX_ERROR_CHECKSUM;
+    }
+    switch (record[3]) {
+        case IHEX_TYPE_DATA:
+            if ((length > 0) && (write(parser->base + offset, record + 4, length) < 0)) {
+                return IHEX_ERROR_WRITE;
+            }
+            return IHEX_OK;
+        case IHEX_TYPE_END:
+            return (length == 0) ? IHEX_END : IHEX_ERROR_RECORD;
+        case IHEX_TYPE_SEGMENT:
+            if (length != 2) {
+                return IHEX_ERROR_RECORD;
+            }
+            parser->base = (((uint32_t) record[4] << 8) | record[5]) << 4;
+            return IHEX_OK;
+        case IHEX_TYPE_LINEAR:
+            if (length != 2) {
+                return IHEX_ERROR_RECORD;
+            }
+            parser->base = (((uint32_t) record[4] << 8) | record[5]) << 16;
+            return IHEX_OK;
+        case IHEX_TYPE_START_SEGMENT:
+        case IHEX_TYPE_START_LINEAR:
+            return (length == 4) ? IHEX_OK : IHEX_ERROR_RECORD;
+    }
+    return IHEX_ERROR_RECORD;
+}
+
+/**
+ * Processes a single character. A record is processed as soon as its last
+ * digit arrives, data records are passed to write() with absolute byte 
+ * addresses. Line endings and blank lines are accepted anywhere between 
+ * records, anything after the end of file record is ignored.
+ * Returns IHEX_OK, IHEX_END once the end of file record is processed or 
+ * IHEX_ERROR_*; after an error the parser has to be reset.
+ */
+int8_t ihex_feed(ihex_parser* parser, const char c, 
+        int8_t (*write)(const uint32_t address, const uint8_t* data, const uint8_t length)) {
+    int8_t result = IHEX_OK;
+    if (parser->state == IHEX_STATE_DONE) {
+        return IHEX_END;
+    } else if (parser->state == IHEX_STATE_ERROR) {
+        return IHEX_ERROR_SYNTAX;
+    }
+    if ((c == '\r') || (c == '\n')) {
+        if (parser->state == IHEX_STATE_RECORD) {
+            result = IHEX_ERROR_SYNTAX;
+        } else {
+            parser->line += (c == '\n');
+            parser->state = IHEX_STATE_IDLE;
+            return IHEX_OK;
+        }
+    } else if (parser->state == IHEX_STATE_IDLE) {
+        if (c == ':') {
+            parser->state = IHEX_STATE_RECORD;
+            parser->index = 0;
+            return IHEX_OK;
+        }
+        result = ((c == ' ') || (c == '\t')) ? IHEX_OK : IHEX_ERROR_SYNTAX;
+    } else if (parser->state == IHEX_STATE_LINE_END) {
+        result = ((c == ' ') || (c == '\t')) ? IHEX_OK : IHEX_ERROR_SYNTAX;
+    } else {
+        int8_t digit = ihex_hex_digit(c);
+        if (digit < 0) {
+            result = IHEX_ERROR_SYNTAX;
+        } else if (!(parser->index & 1)) {
+            parser->nibble = digit;
+            parser->index++;
+        } else {
+            uint16_t byte = parser->index++ >> 1;
+            parser->record[byte] = (parser->nibble << 4) | digit;
+            if (byte == 4u + parser->record[0]) {
+                result = ihex_record(parser, write);
+                parser->state = (result == IHEX_END) ? IHEX_STATE_DONE : IHEX_STATE_LINE_END;
+            }
+        }
+    }
+    if (result < 0) {
+        parser->state = IHEX_STATE_ERROR;
+    }
+    return result;
+}
+
@@ -0,0 +1,46 @@
+/* 
+ * File:   ihex.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Incremental Intel HEX parser, fed one character at a time. Each record is
+ * validated (length, checksum) before its data is passed on, so nothing is 
+ * written from a corrupted line.
+ */
+
+#ifndef IHEX_H
+#define	IHEX_H
+
+#include <stdint.h>
+
+#define IHEX_DATA_MAX 255
+
+#define IHEX_TYPE_DATA 0x00
+#define IHEX_TYPE_END 0x01
+#define IHEX_TYPE_SEGMENT 0x02          /* Extended segment address */
+#define IHEX_TYPE_START_SEGMENT 0x03    /* Ignored */
+#define IHEX_TYPE_LINEAR 0x04           /* Extended linear address */
+#define IHEX_TYPE_START_LINEAR 0x05     /* Ignored */
+
+/* ihex_feed() results */
+#define IHEX_OK 0
+#define IHEX_END 1                      /* End of file record processed */
+#define IHEX_ERROR_SYNTAX -1            /* Unexpected character */
+#define IHEX_ERROR_CHECKSUM -2
+#define IHEX_ERROR_RECORD -3            /* Unknown type or bad length for type */
+#define IHEX_ERROR_WRITE -4             /* Data callback failed */
+
+typedef struct {
+    uint8_t state;
+    uint8_t nibble;                     /* High nibble of the pending byte */
+    uint16_t index;                     /* Digits received in the record */
+    uint32_t base;                      /* Extended address */
+    uint32_t line;                      /* Line number, for error reports */
+    uint8_t record[5 + IHEX_DATA_MAX];  /* length, address (2), type, data, checksum */
+} ihex_parser;
+
+void ihex_reset(ihex_parser* parser);
+int8_t ihex_feed(ihex_parser* parser, const char c, 
+        int8_t (*write)(const uint32_t address, const uint8_t* data, const uint8_t length));
+
+#endif	/* IHEX_H */
+
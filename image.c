@@ -0,0 +1,122 @@
+/*
+ * File:   image.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Collects Flash bytes into a page buffer and starts a page write whenever 
+ * the buffer fills up or the stream moves on to another page, so only 
+ * a single page has to be kept in SRAM. Pages are pipelined with 
+ * program_flash_page_start(), the write of one page overlaps receiving 
+ * the next. Bytes not supplied are left erased (0xFF).
+ */
+
+#include "image.h"
+
+uint32_t image_length;
+uint16_t image_pages;
+uint16_t image_skipped;
+
+static uint16_t image_page[FLASH_PAGE_WORDS_MAX];
+static uint32_t image_address;          /* Word address of the buffered page */
+static uint16_t image_index;            /* Next byte in the buffered page */
+static uint8_t image_page_words;
+static uint8_t image_dirty;             /* Buffered page holds any data */
+static uint32_t image_size;             /* Flash size in bytes */
+
+static void image_clear(void) {
+    for (uint8_t i = 0; i < image_page_words; i++) {
+        image_page[i] = 0xFFFF;
+    }
+    image_index = 0;
+    image_dirty = 0;
+}
+
+/**
+ * Starts a new image at word address, which has to be aligned to page_words,
+ * for a Flash of size bytes.
+ */
+void image_start(const uint16_t address, const uint8_t page_words, const uint32_t size) {
+    image_address = address;
+    image_size = size;
+    image_page_words = page_words;
+    image_length = 0;
+    image_pages = 0;
+    image_skipped = 0;
+    image_clear();
+}
+
+static int8_t image_write_page(void) {
+    int8_t result = program_flash_page_start(image_address, image_page, image_page_words);
+    if (result < 0) {
+        return result;
+    }
+    image_pages++;
+    image_skipped += (result == PROG_SKIPPED);
+    image_address += image_page_words;
+    image_clear();
+    return PROG_OK;
+}
+
+/**
+ * Moves to a byte address. Addresses within the buffered page may come in 
+ * any order, moving past it writes the page, moving back to a page already 
+ * written is refused with IMAGE_ERROR_ORDER.
+ */
+int8_t image_seek(const uint32_t address) {
+    const uint32_t page_start = 2UL * image_address;
+    if (address >= image_size) {
+        return IMAGE_ERROR_RANGE;
+    }
+    if (address < page_start) {
+        return IMAGE_ERROR_ORDER;
+    }
+    if (address >= page_start + 2 * image_page_words) {
+        if (image_dirty) {
+            int8_t result = image_write_page();
+            if (result < 0) {
+                return result;
+            }
+        }
+        uint32_t word = address >> 1;
+        image_address = word - (word % image_page_words);
+        image_clear();
+    }
+    image_index = address - 2UL * image_address;
+    return PROG_OK;
+}
+
+/**
+ * Stores a byte at the current address and moves to the next one, words are
+ * little endian. Returns PROG_OK, PROG_ERROR_NOT_ERASED or IMAGE_ERROR_RANGE.
+ */
+int8_t image_put(const uint8_t byte) {
+    uint16_t* word = image_page + (image_index >> 1);
+    if (2UL * image_address + image_index >= image_size) {
+        return IMAGE_ERROR_RANGE;
+    }
+    if (image_index & 1) {
+        *word = (*word & 0x00FF) | ((uint16_t) byte << 8);
+    } else {
+        *word = (*word & 0xFF00) | byte;
+    }
+    image_dirty = 1;
+    image_length++;
+    if (++image_index == 2 * image_page_words) {
+        return image_write_page();
+    }
+    return PROG_OK;
+}
+
+/**
+ * Writes the partially filled last page and finishes page programming.
+ */
+int8_t image_flush(void) {
+    int8_t result = PROG_OK;
+    if (image_dirty) {
+        result = image_write_page();
+    }
+    if (program_flash_finish() < 0) {
+        return PROG_ERROR_TIMEOUT;
+    }
+    return result;
+}
+
@@ -0,0 +1,29 @@
+/* 
+ * File:   image.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Byte stream to Flash page writer, for uploads which do not arrive 
+ * as whole pages.
+ */
+
+#ifndef IMAGE_H
+#define	IMAGE_H
+
+#include "prog.h"
+
+/* image_put() / image_seek() results besides PROG_OK, PROG_ERROR_NOT_ERASED 
+   and PROG_ERROR_TIMEOUT */
+#define IMAGE_ERROR_ORDER -2            /* Address in a page already written */
+#define IMAGE_ERROR_RANGE -3            /* Address beyond Flash */
+
+extern uint32_t image_length;           /* Bytes received since image_start() */
+extern uint16_t image_pages;            /* Pages handed to the target */
+extern uint16_t image_skipped;          /* Of which skipped */
+
+void image_start(const uint16_t address, const uint8_t page_words, const uint32_t size);
+int8_t image_seek(const uint32_t address);
+int8_t image_put(const uint8_t byte);
+int8_t image_flush(void);
+
+#endif	/* IMAGE_H */
+
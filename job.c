@@ -0,0 +1,386 @@
+/*
+ * File:   job.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include "job.h"
+#include "prog.h"
+#include "fmt.h"
+#include "range.h"
+
+const char* const job_names[JOB_OPS] = {
+    NULL, "enter", "erase", "write flash", "write eeprom", "verify flash", "verify eeprom",
+    "fuse", "delay", "exit", "run"
+};
+
+/* Step lengths including the opcode */
+static const uint8_t job_lengths[JOB_OPS] = { 0, 4, 1, 13, 9, 13, 9, 6, 3, 1, 1 };
+
+static const char* const job_fuses[FUSE_BYTES] = { "low", "high", "extended", "lock" };
+
+static uint16_t page[FLASH_PAGE_WORDS_MAX];
+
+static uint32_t get(const uint8_t* data, const uint8_t bytes) {
+    uint32_t value = 0;
+    for (uint8_t i = bytes; i > 0; i--) {
+        value = (value << 8) | data[i - 1];
+    }
+    return value;
+}
+
+static void put(uint8_t* data, uint32_t value, const uint8_t bytes) {
+    for (uint8_t i = 0; i < bytes; i++) {
+        data[i] = value;
+        value >>= 8;
+    }
+}
+
+/**
+ * Next hexadecimal argument of the step being compiled, up to max.
+ */
+static uint8_t next_hex(uint32_t* value, const uint32_t max) {
+    char* arg = strtok(NULL, " ");
+    char* end;
+    if (arg == NULL) {
+        return 0;
+    }
+    *value = strtoul(arg, &end, 16);
+    return (*end == 0) && (*value <= max);
+}
+
+/**
+ * Parses fuse arguments in the syntax of the fuse set command.
+ */
+static uint8_t compile_fuse(uint8_t* step) {
+    char* arg;
+    step[1] = 0;
+    memset(step + 2, 0xFF, FUSE_BYTES);
+    while ((arg = strtok(NULL, " ")) != NULL) {
+        char* value = strchr(arg, '=');
+        char* end;
+        uint8_t i;
+        if (value == NULL) {
+            return 0;
+        }
+        *value++ = 0;
+        for (i = 0; (i < FUSE_BYTES) && (strcmp(arg, job_fuses[i]) != 0); i++);
+        uint32_t bits = strtoul(value, &end, 16);
+        if ((i == FUSE_BYTES) || (*value == 0) || (*end != 0) || (bits > 0xFF)) {
+            return 0;
+        }
+        step[1] |= (1 << i);
+        step[2 + i] = bits;
+    }
+    return step[1] != 0;
+}
+
+/**
+ * Appends a step given in text (e.g. "write flash 0 1000 0") to a job of
+ * length bytes, returns the new length or JOB_ERROR_FORMAT. The step
+ * string is modified.
+ */
+int16_t job_compile(char* text, uint8_t* job, const uint16_t length) {
+    char* word = strtok(text, " ");
+    char* kind = NULL;
+    uint8_t op;
+    uint32_t a, b, c;
+    if (word == NULL) {
+        return JOB_ERROR_FORMAT;
+    }
+    if ((strcmp(word, "write") == 0) || (strcmp(word, "verify") == 0)) {
+        kind = strtok(NULL, " ");
+        if (kind == NULL) {
+            return JOB_ERROR_FORMAT;
+        }
+    }
+    for (op = 1; op < JOB_OPS; op++) {
+        const char* name = job_names[op];
+        size_t n = strlen(word);
+        if ((strncmp(name, word, n) == 0) &&
+            ((kind == NULL) ? (name[n] == 0) : ((name[n] == ' ') && (strcmp(name + n + 1, kind) == 0)))) {
+            break;
+        }
+    }
+    if ((op == JOB_OPS) || (length + job_lengths[op] > JOB_SIZE_MAX)) {
+        return JOB_ERROR_FORMAT;
+    }
+    uint8_t* step = job + length;
+    step[0] = op;
+    switch (op) {
+        case JOB_OP_ENTER:
+            if (!next_hex(&a, 0xFFFFFF)) {
+                return JOB_ERROR_FORMAT;
+            }
+            put(step + 1, a, 3);
+            break;
+        case JOB_OP_WRITE_FLASH:
+        case JOB_OP_VERIFY_FLASH:
+            if (!next_hex(&a, 0xFFFFFFFFUL) || !next_hex(&b, 0xFFFFFFFFUL) || !next_hex(&c, 0xFFFFFFFFUL)) {
+                return JOB_ERROR_FORMAT;
+            }
+            put(step + 1, a, 4);
+            put(step + 5, b, 4);
+            put(step + 9, c, 4);
+            break;
+        case JOB_OP_WRITE_EEPROM:
+        case JOB_OP_VERIFY_EEPROM:
+            if (!next_hex(&a, 0xFFFF) || !next_hex(&b, 0xFFFF) || !next_hex(&c, 0xFFFFFFFFUL)) {
+                return JOB_ERROR_FORMAT;
+            }
+            put(step + 1, a, 2);
+            put(step + 3, b, 2);
+            put(step + 5, c, 4);
+            break;
+        case JOB_OP_FUSE:
+            if (!compile_fuse(step)) {
+                return JOB_ERROR_FORMAT;
+            }
+            break;
+        case JOB_OP_DELAY: {
+            char* arg = strtok(NULL, " ");
+            char* end;
+            if (arg == NULL) {
+                return JOB_ERROR_FORMAT;
+            }
+            a = strtoul(arg, &end, 10);
+            if ((*end != 0) || (a > 0xFFFF)) {
+                return JOB_ERROR_FORMAT;
+            }
+            put(step + 1, a, 2);
+            break;
+        }
+    }
+    if (strtok(NULL, " ") != NULL) {
+        return JOB_ERROR_FORMAT;
+    }
+    return length + job_lengths[op];
+}
+
+/**
+ * Length of the step at job, or JOB_ERROR_FORMAT when it is unknown or
+ * truncated.
+ */
+int16_t job_step_length(const uint8_t* job, const uint16_t length) {
+    if ((length == 0) || (job[0] == 0) || (job[0] >= JOB_OPS) || (job_lengths[job[0]] > length)) {
+        return JOB_ERROR_FORMAT;
+    }
+    return job_lengths[job[0]];
+}
+
+/**
+ * Prints a step in the syntax accepted by job_compile().
+ */
+void job_print(const uint8_t* step) {
+    fmt_str(job_names[step[0]]);
+    switch (step[0]) {
+        case JOB_OP_ENTER:
+            fmt_char(' ');
+            fmt_hex(get(step + 1, 3), 6);
+            break;
+        case JOB_OP_WRITE_FLASH:
+        case JOB_OP_VERIFY_FLASH:
+            for (uint8_t i = 1; i < 13; i += 4) {
+                fmt_char(' ');
+                fmt_hex(get(step + i, 4), 0);
+            }
+            break;
+        case JOB_OP_WRITE_EEPROM:
+        case JOB_OP_VERIFY_EEPROM:
+            fmt_char(' ');
+            fmt_hex(get(step + 1, 2), 0);
+            fmt_char(' ');
+            fmt_hex(get(step + 3, 2), 0);
+            fmt_char(' ');
+            fmt_hex(get(step + 5, 4), 0);
+            break;
+        case JOB_OP_FUSE:
+            for (uint8_t i = 0; i < FUSE_BYTES; i++) {
+                if (step[1] & (1 << i)) {
+                    fmt_char(' ');
+                    fmt_str(job_fuses[i]);
+                    fmt_char('=');
+                    fmt_hex(step[2 + i], 2);
+                }
+            }
+            break;
+        case JOB_OP_DELAY:
+            fmt_char(' ');
+            fmt_dec(get(step + 1, 2), 0);
+            break;
+    }
+    fmt_end();
+}
+
+/**
+ * Flash pages from the image store, the next page is read from the store
+ * while the target writes the previous one.
+ */
+static int8_t job_write_flash(const avr_record* record, const uint32_t address, const uint32_t length,
+        const uint32_t offset, job_reader read) {
+    const uint16_t page_bytes = 2 * record->flash_page_words;
+    if ((address % page_bytes) || !range_fits(address, length, AVR_FLASH_SIZE(record))) {
+        return JOB_ERROR_FORMAT;
+    }
+    for (uint32_t done = 0; done < length; done += page_bytes) {
+        uint16_t chunk = page_bytes;
+        if (length - done < chunk) {
+            chunk = length - done;
+            memset(page, 0xFF, page_bytes);
+        }
+        if (read(offset + done, (uint8_t*) page, chunk) < 0) {
+            program_flash_finish();
+            return JOB_ERROR_STORE;
+        }
+        if (program_flash_page_start((address + done) >> 1, page, record->flash_page_words) < 0) {
+            program_flash_finish();
+            return JOB_ERROR_TARGET;
+        }
+    }
+    return (program_flash_finish() < 0) ? JOB_ERROR_TARGET : JOB_OK;
+}
+
+/**
+ * EEPROM in chunks of the page buffer, unchanged pages are skipped.
+ */
+static int8_t job_write_eeprom(const avr_record* record, uint16_t address, uint16_t length,
+        uint32_t offset, job_reader read) {
+    if (!range_fits(address, length, record->eeprom_size)) {
+        return JOB_ERROR_FORMAT;
+    }
+    while (length > 0) {
+        uint16_t chunk = sizeof(page) - (address % sizeof(page));
+        if (length < chunk) {
+            chunk = length;
+        }
+        if (read(offset, (uint8_t*) page, chunk) < 0) {
+            return JOB_ERROR_STORE;
+        }
+        if (program_eeprom(address, (uint8_t*) page, chunk, record->eeprom_page_size) < 0) {
+            return JOB_ERROR_TARGET;
+        }
+        address += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+    return JOB_OK;
+}
+
+static int8_t job_fuse(const avr_record* record, const uint8_t* step) {
+    uint8_t extended = (record->flags & AVR_FLAG_SUPPORTED) ? (record->flags & AVR_FLAG_FUSE_EXTENDED) : 1;
+    uint8_t bits[FUSE_BYTES];
+    if ((step[1] & FUSE_EXTENDED_bm) && !extended) {
+        return JOB_ERROR_FORMAT;
+    }
+    memcpy(bits, step + 2, FUSE_BYTES);
+    switch (program_fuse_and_lock_bits(bits, step[1], extended, 0)) {
+        case PROG_ERROR_VERIFY:
+            return JOB_ERROR_VERIFY;
+        case PROG_ERROR_NOT_ERASED:     /* Lock bits need chip erase */
+        case PROG_ERROR_TIMEOUT:
+            return JOB_ERROR_TARGET;
+    }
+    return JOB_OK;
+}
+
+/**
+ * Runs one step; record is the device found by the enter step.
+ */
+static int8_t job_step(const uint8_t* step, const avr_record** record, uint8_t* target, job_reader read) {
+    uint32_t signature;
+    if ((step[0] != JOB_OP_ENTER) && (step[0] != JOB_OP_DELAY) && (step[0] != JOB_OP_EXIT) &&
+        (step[0] != JOB_OP_RUN) && (*target != JOB_TARGET_PROGRAMMING)) {
+        return JOB_ERROR_STATE;
+    }
+    switch (step[0]) {
+        case JOB_OP_ENTER:
+            if (*target == JOB_TARGET_PROGRAMMING) {
+                return JOB_ERROR_STATE;
+            }
+            enter_programming();
+            read_signature(&signature);
+            *record = lookup_signature(signature);
+            if ((signature != get(step + 1, 3)) || (*record == NULL)) {
+                exit_programming();
+                *target = JOB_TARGET_OFF;
+                return JOB_ERROR_DEVICE;
+            }
+            *target = JOB_TARGET_PROGRAMMING;
+            return JOB_OK;
+        case JOB_OP_ERASE:
+            return (erase_chip() < 0) ? JOB_ERROR_TARGET : JOB_OK;
+        case JOB_OP_WRITE_FLASH:
+            return job_write_flash(*record, get(step + 1, 4), get(step + 5, 4), get(step + 9, 4), read);
+        case JOB_OP_WRITE_EEPROM:
+            return job_write_eeprom(*record, get(step + 1, 2), get(step + 3, 2), get(step + 5, 4), read);
+        case JOB_OP_VERIFY_FLASH:
+            if (!range_fits(get(step + 1, 4), get(step + 5, 4), AVR_FLASH_SIZE(*record))) {
+                return JOB_ERROR_FORMAT;
+            }
+            return (read_flash_crc32(get(step + 1, 4), get(step + 5, 4)) == get(step + 9, 4)) ?
+                JOB_OK : JOB_ERROR_VERIFY;
+        case JOB_OP_VERIFY_EEPROM:
+            if (!range_fits(get(step + 1, 2), get(step + 3, 2), (*record)->eeprom_size)) {
+                return JOB_ERROR_FORMAT;
+            }
+            return (read_eeprom_crc32(get(step + 1, 2), get(step + 3, 2)) == get(step + 5, 4)) ?
+                JOB_OK : JOB_ERROR_VERIFY;
+        case JOB_OP_FUSE:
+            return job_fuse(*record, step);
+        case JOB_OP_DELAY:
+            for (uint16_t ms = get(step + 1, 2); ms > 0; ms--) {
+                HAL_DELAY_MS(1);
+            }
+            return JOB_OK;
+        case JOB_OP_EXIT:
+            if (*target == JOB_TARGET_PROGRAMMING) {
+                exit_programming();
+            } else if (*target == JOB_TARGET_RUNNING) {
+                power_down();
+            }
+            *target = JOB_TARGET_OFF;
+            return JOB_OK;
+        case JOB_OP_RUN:
+            if (*target == JOB_TARGET_PROGRAMMING) {
+                exit_programming();
+            }
+            if (*target != JOB_TARGET_RUNNING) {
+                power_up();
+            }
+            *target = JOB_TARGET_RUNNING;
+            return JOB_OK;
+    }
+    return JOB_ERROR_FORMAT;
+}
+
+/**
+ * Runs a job with the target powered down, stops at the first failing step.
+ * Reports the result, the steps completed, the target state left and the
+ * time taken (up to 64 s, see HAL_CLOCK()).
+ */
+void job_execute(const uint8_t* job, const uint16_t length, job_reader read, job_status* status) {
+    const avr_record* record = NULL;
+    const uint16_t start = HAL_CLOCK();
+    uint16_t position = 0;
+    status->result = JOB_OK;
+    status->step = 0;
+    status->op = 0;
+    status->target = JOB_TARGET_OFF;
+    while ((position < length) && (status->result == JOB_OK)) {
+        int16_t size = job_step_length(job + position, length - position);
+        if (size < 0) {
+            status->result = JOB_ERROR_FORMAT;
+            break;
+        }
+        status->op = job[position];
+        status->result = job_step(job + position, &record, &status->target, read);
+        if (status->result == JOB_OK) {
+            status->step++;
+        }
+        position += size;
+    }
+    if (status->target == JOB_TARGET_PROGRAMMING) {
+        exit_programming();
+        status->target = JOB_TARGET_OFF;
+    }
+    status->ms = (uint16_t) (HAL_CLOCK() - start) * 1000UL / HAL_CLOCK_HZ;
+}
@@ -0,0 +1,78 @@
+/*
+ * File:   job.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Job scripts: a whole per-board flow (enter, erase, write, verify, fuses,
+ * run) stored on the programmer and executed by a single command, without
+ * a host round trip per step. Data written to the target is taken from the
+ * image store.
+ *
+ * A job is a sequence of steps, an opcode followed by its arguments
+ * (multi-byte fields are little endian):
+ *   JOB_OP_ENTER         signature (3)
+ *   JOB_OP_ERASE
+ *   JOB_OP_WRITE_FLASH   byte address (4), length (4), image offset (4)
+ *   JOB_OP_WRITE_EEPROM  byte address (2), length (2), image offset (4)
+ *   JOB_OP_VERIFY_FLASH  byte address (4), length (4), CRC-32 (4)
+ *   JOB_OP_VERIFY_EEPROM byte address (2), length (2), CRC-32 (4)
+ *   JOB_OP_FUSE          select (1, FUSE_*_bm), low, high, extended, lock
+ *   JOB_OP_DELAY         milliseconds (2)
+ *   JOB_OP_EXIT
+ *   JOB_OP_RUN
+ * Flash writes start at a page boundary and pad the last page with 0xFF.
+ * A job which leaves the target in programming mode, or fails, powers it
+ * down.
+ */
+
+#ifndef JOB_H
+#define	JOB_H
+
+#include <stdint.h>
+
+/* Fits the job area of the image store, see store.h */
+#define JOB_SIZE_MAX 252
+
+#define JOB_OP_ENTER 0x01
+#define JOB_OP_ERASE 0x02
+#define JOB_OP_WRITE_FLASH 0x03
+#define JOB_OP_WRITE_EEPROM 0x04
+#define JOB_OP_VERIFY_FLASH 0x05
+#define JOB_OP_VERIFY_EEPROM 0x06
+#define JOB_OP_FUSE 0x07
+#define JOB_OP_DELAY 0x08
+#define JOB_OP_EXIT 0x09
+#define JOB_OP_RUN 0x0A
+#define JOB_OPS 0x0B
+
+#define JOB_OK 0
+#define JOB_ERROR_FORMAT -1             /* Malformed step or argument out of range */
+#define JOB_ERROR_STATE -2              /* Step not allowed in the current target state */
+#define JOB_ERROR_DEVICE -3             /* Signature does not match */
+#define JOB_ERROR_STORE -4              /* Image store read failed */
+#define JOB_ERROR_TARGET -5             /* Write failed or timed out */
+#define JOB_ERROR_VERIFY -6             /* CRC-32 or fuse readback mismatch */
+
+/* Target state after a job */
+#define JOB_TARGET_OFF 0
+#define JOB_TARGET_PROGRAMMING 1
+#define JOB_TARGET_RUNNING 2
+
+typedef struct {
+    int8_t result;                      /* JOB_OK or JOB_ERROR_* */
+    uint8_t step;                       /* Steps completed, the failed one is next */
+    uint8_t op;                         /* Last step run */
+    uint8_t target;                     /* JOB_TARGET_* after the job */
+    uint32_t ms;                        /* Duration */
+} job_status;
+
+/* Reads image store data, offset relative to the image; 0 or -1 */
+typedef int8_t (*job_reader)(const uint32_t offset, uint8_t* data, const uint16_t length);
+
+extern const char* const job_names[JOB_OPS];
+
+int16_t job_compile(char* text, uint8_t* job, const uint16_t length);
+int16_t job_step_length(const uint8_t* job, const uint16_t length);
+void job_print(const uint8_t* step);
+void job_execute(const uint8_t* job, const uint16_t length, job_reader read, job_status* status);
+
+#endif	/* JOB_H */
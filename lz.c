@@ -0,0 +1,60 @@
+/*
+ * File:   lz.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Streaming decoder for the format described in lz.h. Kept free of any AVR 
+ * headers, so it can be built for the host as well.
+ */
+
+#include "lz.h"
+
+#define LZ_STATE_CONTROL 0
+#define LZ_STATE_ITEM 1
+#define LZ_STATE_LENGTH 2
+
+void lz_reset(lz_decoder* decoder) {
+    decoder->position = 0;
+    decoder->state = LZ_STATE_CONTROL;
+}
+
+static int8_t lz_output(lz_decoder* decoder, const uint8_t byte, int8_t (*put)(const uint8_t)) {
+    decoder->window[decoder->position++] = byte;
+    return put(byte);
+}
+
+/**
+ * Decodes a single stream byte, passing every decoded byte to put().
+ * Stops at and returns the first negative result of put(), LZ_OK otherwise.
+ * A single match byte produces up to LZ_MATCH_MAX bytes of output.
+ */
+int8_t lz_feed(lz_decoder* decoder, const uint8_t byte, int8_t (*put)(const uint8_t)) {
+    int8_t result = LZ_OK;
+    switch (decoder->state) {
+        case LZ_STATE_CONTROL:
+            decoder->control = byte;
+            decoder->items = 8;
+            decoder->state = LZ_STATE_ITEM;
+            return LZ_OK;
+        case LZ_STATE_ITEM:
+            if (!(decoder->control & 1)) {
+                decoder->distance = byte;
+                decoder->state = LZ_STATE_LENGTH;
+                return LZ_OK;
+            }
+            result = lz_output(decoder, byte, put);
+            break;
+        case LZ_STATE_LENGTH:
+        {
+            uint16_t length = byte + LZ_MATCH_MIN;
+            while ((length-- > 0) && (result >= 0)) {
+                uint8_t from = decoder->position - decoder->distance - 1;
+                result = lz_output(decoder, decoder->window[from], put);
+            }
+            break;
+        }
+    }
+    decoder->control >>= 1;
+    decoder->state = (--decoder->items == 0) ? LZ_STATE_CONTROL : LZ_STATE_ITEM;
+    return result;
+}
+
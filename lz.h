@@ -0,0 +1,43 @@
+/* 
+ * File:   lz.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Small-window LZ77 stream format used for compressed image uploads, 
+ * shared by the firmware (decoder) and host tools (host/lzc.c compressor).
+ * 
+ * The stream is a sequence of groups: a control byte followed by up to eight 
+ * items, described by control bits starting from the least significant one:
+ *   1 - literal byte
+ *   0 - match: distance - 1 (1), length - LZ_MATCH_MIN (1), copies length 
+ *       bytes starting distance bytes back in the output (may overlap)
+ * Matches reach at most LZ_WINDOW_SIZE bytes back, so the decoder only needs
+ * to keep the last LZ_WINDOW_SIZE bytes of output. The stream has no end 
+ * marker, its end is signalled by the transport.
+ */
+
+#ifndef LZ_H
+#define	LZ_H
+
+#include <stdint.h>
+
+/* Window index wraps with uint8_t arithmetic, do not change */
+#define LZ_WINDOW_SIZE 256
+#define LZ_MATCH_MIN 3
+#define LZ_MATCH_MAX (LZ_MATCH_MIN + 255)
+
+#define LZ_OK 0
+
+typedef struct {
+    uint8_t window[LZ_WINDOW_SIZE];
+    uint8_t position;                   /* Next window byte to be written */
+    uint8_t state;
+    uint8_t control;                    /* Remaining control bits */
+    uint8_t items;                      /* Items left in the current group */
+    uint8_t distance;                   /* Match distance - 1 */
+} lz_decoder;
+
+void lz_reset(lz_decoder* decoder);
+int8_t lz_feed(lz_decoder* decoder, const uint8_t byte, int8_t (*put)(const uint8_t));
+
+#endif	/* LZ_H */
+
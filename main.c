@@ -5,204 +5,980 @@
 
 #include "config.h"
 #include "prog.h"
+#include "session.h"
+#include "binary.h"
+#include "stk500.h"
+#include "gang.h"
+#include "image.h"
+#include "ihex.h"
+#include "store.h"
+#include "standalone.h"
+#include "job.h"
+#include "fmt.h"
+#include "range.h"
 
 static char line[255];
 
-static uint8_t mode = 0;
-static const avr_record* record = NULL;
+/**
+ * Reads a command line with echo and backspace, up to buf_size - 1 
+ * characters; anything but letters, digits, space and '=' is ignored.
+ * Machine mode does not echo.
+ */
+static int console_gets(char* buf, const unsigned int buf_size) {
+    unsigned int read = 0;
+    if (buf_size < 1) {
+        return -1;
+    }
+    while (read < buf_size - 1) {
+        char data = usart1_getc(NULL);
+        if (data == '\r') {
+            if (!fmt_machine) {
+                usart1_putc('\n', NULL);
+            }
+            break;
+        } else if (isalpha(data) || isdigit(data) || data == ' ' || data == '=') {
+            buf[read++] = data;
+            if (!fmt_machine) {
+                usart1_putc(data, NULL);
+            }
+        } else if ((data == 0x08) && (read > 0)) {
+            if (!fmt_machine) {
+                usart1_puts("\x08\x20\x08");
+            }
+            buf[--read] = 0;
+        }
+    }
+    buf[read] = 0;
+    return read;
+}
+
+static const char* const fuse_names[FUSE_BYTES] = { "low", "high", "extended", "lock" };
+
+static void print_signature(const uint32_t signature) {
+    fmt_tag("signature");
+    fmt_hex(signature, 6);
+    fmt_end();
+}
+
+/**
+ * Quotes a rejected argument: <prefix> '<arg>'<suffix>.
+ */
+static void print_rejected(const char* prefix, const char* arg, const char* suffix) {
+    fmt_tag("error");
+    fmt_str(prefix);
+    fmt_str(" '");
+    fmt_str(arg);
+    fmt_char('\'');
+    fmt_str(suffix);
+    fmt_end();
+}
 
 void cmd_enter() {
     if (strtok(NULL, " ")) {
-        puts("error     \tCommand does not accept arguments");
-    } else if (mode == 2) {
-        puts("error     \tAlready in programming mode");
-    } else {
-        enter_programming();
-        uint32_t s;
-        read_signature(&s);
-        printf("signature \t%06lX\n", s);
-        record = lookup_signature(s);
-        if (record == NULL) {
-            exit_programming();
-            if (mode == 1) {
-                power_up();
-                puts("error     \tDevice not recognized, back to running mode");
+        fmt_line("error", "Command does not accept arguments");
+        return;
+    }
+    uint8_t previous_mode = session_mode;
+    uint32_t s;
+    switch (session_enter(&s)) {
+        case SESSION_ERROR_STATE:
+            fmt_line("error", "Already in programming mode");
+            break;
+        case SESSION_ERROR_DEVICE:
+            print_signature(s);
+            if (previous_mode == SESSION_RUNNING) {
+                fmt_line("error", "Device not recognized, back to running mode");
             } else {
-                puts("error     \tDevice not recognized, power down");
+                fmt_line("error", "Device not recognized, power down");
             }
-        } else {
-            mode = 2;
-            printf("device    \t%s\n", record->name);
-            puts("ok        \tEntered programming mode for device");
-        }
+            break;
+        default:
+            print_signature(s);
+            fmt_line("device", session_record->name);
+            if (fmt_machine) {
+                if (gang_targets) {
+                    fmt_key("gang", "targets");
+                    fmt_hex(gang_targets, 2);
+                    fmt_end();
+                }
+                fmt_key("flash", "size");
+                fmt_dec(AVR_FLASH_SIZE(session_record), 0);
+                fmt_field("pages");
+                fmt_dec(session_record->flash_pages, 0);
+                fmt_field("page_words");
+                fmt_dec(session_record->flash_page_words, 0);
+                fmt_end();
+                fmt_key("eeprom", "size");
+                fmt_dec(session_record->eeprom_size, 0);
+                fmt_field("page_size");
+                fmt_dec(session_record->eeprom_page_size, 0);
+                fmt_end();
+            } else {
+                if (gang_targets) {
+                    fmt_tag("gang");
+                    fmt_str("Targets ");
+                    fmt_hex(gang_targets, 2);
+                    fmt_str(" matching");
+                    fmt_end();
+                }
+                fmt_tag("flash");
+                fmt_dec(AVR_FLASH_SIZE(session_record), 0);
+                fmt_str(" bytes, ");
+                fmt_dec(session_record->flash_pages, 0);
+                fmt_str(" pages of ");
+                fmt_dec(session_record->flash_page_words, 0);
+                fmt_str(" words");
+                fmt_end();
+                fmt_tag("eeprom");
+                fmt_dec(session_record->eeprom_size, 0);
+                fmt_str(" bytes, ");
+                fmt_dec(session_record->eeprom_page_size, 0);
+                fmt_str(" byte pages");
+                fmt_end();
+            }
+            fmt_line("ok", "Entered programming mode for device");
     }
 }
 
 void cmd_exit() {
     if (strtok(NULL, " ")) {
-        puts("error     \tCommand does not accept arguments");
-    } else if (mode == 0) {
-        puts("error     \tNot in programming or running mode");
-    } else if (mode == 1) {
-        power_down();
-        mode = 0;
-        puts("ok        \tPower down");
-    } else if (mode == 2) {
-        exit_programming();
-        mode = 0;
-        puts("ok        \tProgramming mode left, power down");
+        fmt_line("error", "Command does not accept arguments");
+        return;
+    }
+    uint8_t previous_mode = session_mode;
+    if (session_exit() != SESSION_OK) {
+        fmt_line("error", "Not in programming or running mode");
+    } else if (previous_mode == SESSION_RUNNING) {
+        fmt_line("ok", "Power down");
+    } else {
+        fmt_line("ok", "Programming mode left, power down");
     }
-    record = NULL;
 }
 
 void cmd_run() {
     if (strtok(NULL, " ")) {
-        puts("error     \tCommand does not accept arguments");
-    } else if (mode == 1) {
-        puts("error     \tAlready in running mode");
-    } else if (mode == 0) {
-        power_up();
-        mode = 1;
-        puts("ok        \tRunning");
-    } else if (mode == 2) {
-        exit_programming();
-        power_up();
-        mode = 1;
-        puts("ok        \tProgramming mode left, running");
-    }
-    record = NULL;
+        fmt_line("error", "Command does not accept arguments");
+        return;
+    }
+    uint8_t previous_mode = session_mode;
+    if (session_run() != SESSION_OK) {
+        fmt_line("error", "Already in running mode");
+    } else if (previous_mode == SESSION_PROGRAMMING) {
+        fmt_line("ok", "Programming mode left, running");
+    } else {
+        fmt_line("ok", "Running");
+    }
 }
 
+void cmd_erase() {
+    if (strtok(NULL, " ")) {
+        fmt_line("error", "Command does not accept arguments");
+        return;
+    }
+    if (session_mode != SESSION_PROGRAMMING) {
+        fmt_line("error", "Not in programming mode");
+        return;
+    }
+    if (erase_chip() < 0) {
+        fmt_line("error", "Target does not respond (RDY/BSY timeout)");
+        return;
+    }
+    fmt_line("ok", "Chip erased");
+}
+
+/**
+ * Hexadecimal value, then in text mode the bits, and the named bits when 
+ * the map is known, in red where they differ from the factory default.
+ */
 void print_fuse(uint8_t value, uint8_t default_value, const char* const* map) {
-    printf(
-        "%s%01X%s%01X%s\t", 
-        ((value & 0xF0) == (default_value & 0xF0)) ? "\x1b[0m" : "\x1b[31m",
-        value >> 4,
-        ((value & 0x0F) == (default_value & 0x0F)) ? "\x1b[0m" : "\x1b[31m",    
-        value & 0x0F,    
-        "\x1b[0m"    
-    );
-    for (int i = 7; i >= 0; i--) {
-        if ((value & (1 << i)) != (default_value & (1 << i))) {
-            printf("\x1b[31m%c", (value & (1 << i)) ? '1' : '0');
-        } else {
-            printf("\x1b[0m%c", (value & (1 << i)) ? '1' : '0');
-        }
+    uint8_t changed = value ^ default_value;
+    if (fmt_machine) {
+        fmt_hex(value, 2);
+        fmt_end();
+        return;
+    }
+    fmt_str((changed & 0xF0) ? FMT_RED : FMT_RESET);
+    fmt_hex(value >> 4, 1);
+    fmt_str((changed & 0x0F) ? FMT_RED : FMT_RESET);
+    fmt_hex(value & 0x0F, 1);
+    fmt_str(FMT_RESET "\t");
+    for (int8_t i = 7; i >= 0; i--) {
+        fmt_str((changed & (1 << i)) ? FMT_RED : FMT_RESET);
+        fmt_char((value & (1 << i)) ? '1' : '0');
     }
     if (map != NULL) {
-        for (int i = 0; i < 8; i++) {
+        for (uint8_t i = 0; i < 8; i++) {
             if (map[i] == NULL) 
                 continue;
-            if ((value & (1 << i)) != (default_value & (1 << i))) {
-                printf("\t\x1b[31m" "%-9s = %c", map[i], (value & (1 << i)) ? '1' : '0');
-            } else if (value & (1 << i)) {
-                printf("\t\x1b[0m" "%-9s = 1", map[i]);
-            } else {
-                printf("\t\x1b[32m" "%-9s = 0", map[i]);
-            }
+            fmt_char('\t');
+            fmt_str((changed & (1 << i)) ? FMT_RED : (value & (1 << i)) ? FMT_RESET : FMT_GREEN);
+            fmt_pad(map[i], 9);
+            fmt_str((value & (1 << i)) ? " = 1" : " = 0");
         }
     }
-    puts("\x1b[0m");
+    fmt_str(FMT_RESET);
+    fmt_end();
 }
 
-int print_fuse_status(int reset_mode) {
-    uint8_t flb[4];
-    if (record->flags & AVR_FLAG_SUPPORTED) {
-        read_fuse_and_lock_bits(flb, record->flags & AVR_FLAG_FUSE_EXTENDED);
-        printf("low       \t");
-        print_fuse(flb[0], record->fuse_low_factory, record->fuse_low_map);
-        printf("high      \t");
-        print_fuse(flb[1], record->fuse_high_factory, record->fuse_high_map);
-        if (record->flags & AVR_FLAG_FUSE_EXTENDED) {
-            printf("extended  \t");
-            print_fuse(flb[2], record->fuse_extended_factory, record->fuse_extended_map);
+int print_fuse_status(const uint8_t* flb, int reset_mode) {
+    if (session_record->flags & AVR_FLAG_SUPPORTED) {
+        fmt_tag(fuse_names[FUSE_LOW]);
+        print_fuse(flb[0], session_record->fuse_low_factory, session_record->fuse_low_map);
+        fmt_tag(fuse_names[FUSE_HIGH]);
+        print_fuse(flb[1], session_record->fuse_high_factory, session_record->fuse_high_map);
+        if (session_record->flags & AVR_FLAG_FUSE_EXTENDED) {
+            fmt_tag(fuse_names[FUSE_EXTENDED]);
+            print_fuse(flb[2], session_record->fuse_extended_factory, session_record->fuse_extended_map);
         }
-        printf("lock      \t");
-        print_fuse(flb[3], record->lock_factory, record->lock_map);
+        fmt_tag(fuse_names[FUSE_LOCK]);
+        print_fuse(flb[3], session_record->lock_factory, session_record->lock_map);
         if (
-            (flb[0] == record->fuse_low_factory) &&
-            (flb[1] == record->fuse_high_factory) &&
-            (flb[2] == record->fuse_extended_factory) &&
-            (flb[3] == record->lock_factory)
+            (flb[0] == session_record->fuse_low_factory) &&
+            (flb[1] == session_record->fuse_high_factory) &&
+            (flb[2] == session_record->fuse_extended_factory) &&
+            (flb[3] == session_record->lock_factory)
         ) {
-            puts("ok        \tAll fuse/lock bits are equal to factory defaults");
+            fmt_line("ok", "All fuse/lock bits are equal to factory defaults");
             return 0;
         } else if (reset_mode == 0) {
-            puts("warning   \tFound differences to factory defaults, use 'fuse reset' to restore");
+            fmt_line("warning", "Found differences to factory defaults, use 'fuse reset' to restore");
         } else if (reset_mode == 2) {
-            puts("error     \tFound differences to factory defaults, reset failed");
+            fmt_line("error", "Found differences to factory defaults, reset failed");
         }
         return 1;
     } else {
-        read_fuse_and_lock_bits(flb, 1);
-        printf("low       \t%02X\t" BYTE_TO_BINARY_PATTERN "\n", flb[0], BYTE_TO_BINARY(flb[0]));
-        printf("high      \t%02X\t" BYTE_TO_BINARY_PATTERN "\n", flb[1], BYTE_TO_BINARY(flb[1]));
-        printf("extended  \t%02X\t" BYTE_TO_BINARY_PATTERN "\n", flb[2], BYTE_TO_BINARY(flb[2]));
-        printf("lock      \t%02X\t" BYTE_TO_BINARY_PATTERN "\n", flb[3], BYTE_TO_BINARY(flb[3]));
-        puts("warning   \tDatabase record incomplete for this device, cannot compare to factory defaults");
+        for (uint8_t i = 0; i < FUSE_BYTES; i++) {
+            fmt_tag(fuse_names[i]);
+            fmt_hex(flb[i], 2);
+            if (!fmt_machine) {
+                fmt_char('\t');
+                fmt_bin(flb[i]);
+            }
+            fmt_end();
+        }
+        fmt_line("warning", "Database record incomplete for this device, cannot compare to factory defaults");
         return 0;
     }    
 }
 
+/**
+ * Extended fuse byte is read unless the database says the device has none.
+ */
+uint8_t fuse_extended(void) {
+    return (session_record->flags & AVR_FLAG_SUPPORTED) ? 
+        (session_record->flags & AVR_FLAG_FUSE_EXTENDED) : 1;
+}
+
+int parse_hex(const char* arg, uint32_t* value) {
+    char* end;
+    if (arg == NULL) {
+        return 0;
+    }
+    *value = strtoul(arg, &end, 16);
+    return (*end == 0);
+}
+
+/**
+ * Runs the fuse/lock transaction and reports its result, returns nonzero 
+ * when the bits were written and verified.
+ */
+int write_fuses(uint8_t* flb, const uint8_t select) {
+    int8_t result = program_fuse_and_lock_bits(flb, select, fuse_extended(), gang_targets != 0);
+    switch (result) {
+        case PROG_ERROR_NOT_ERASED:
+            fmt_line("error", "Lock bits can only be cleared by chip erase");
+            return 0;
+        case PROG_ERROR_TIMEOUT:
+            fmt_line("error", "Target does not respond (RDY/BSY timeout)");
+            return 0;
+        case PROG_ERROR_VERIFY:
+            fmt_line("error", "Fuse/lock bits read back differ");
+            return 0;
+    }
+    for (uint8_t i = 0; i < FUSE_BYTES; i++) {
+        if (!(select & (1 << i))) {
+            continue;
+        }
+        if (fmt_machine) {
+            fmt_key("fuse", fuse_names[i]);
+            fmt_hex(flb[i], 2);
+            fmt_field("written");
+            fmt_char((result & (1 << i)) ? '1' : '0');
+        } else {
+            fmt_tag("status");
+            fmt_pad(fuse_names[i], 8);
+            fmt_char(' ');
+            fmt_hex(flb[i], 2);
+            fmt_str((result & (1 << i)) ? " written" : " unchanged");
+        }
+        fmt_end();
+    }
+    return 1;
+}
+
+/**
+ * fuse set low=XX high=XX extended=XX lock=XX, any subset in any order.
+ */
+void set_fuses(void) {
+    uint8_t flb[FUSE_BYTES];
+    uint8_t select = 0;
+    char* arg;
+    while ((arg = strtok(NULL, " ")) != NULL) {
+        char* value = strchr(arg, '=');
+        uint32_t bits;
+        uint8_t i;
+        if (value != NULL) {
+            *value++ = 0;
+        }
+        for (i = 0; (i < FUSE_BYTES) && (strcmp(arg, fuse_names[i]) != 0); i++);
+        if ((i == FUSE_BYTES) || !parse_hex(value, &bits) || (bits > 0xFF)) {
+            fmt_line("error", "Expected low=XX, high=XX, extended=XX or lock=XX");
+            return;
+        }
+        if ((i == FUSE_EXTENDED) && !fuse_extended()) {
+            fmt_line("error", "Device has no extended fuse byte");
+            return;
+        }
+        flb[i] = bits;
+        select |= (1 << i);
+    }
+    if (select == 0) {
+        fmt_line("error", "Expected low=XX, high=XX, extended=XX or lock=XX");
+    } else if (write_fuses(flb, select)) {
+        fmt_line("ok", "Fuse/lock bits verified");
+    }
+}
+
 void cmd_fuse() {
     char* arg1 = strtok(NULL, " ");
-    if (mode != 2) {
-        puts("error     \tNot in programming mode");
+    if (session_mode != SESSION_PROGRAMMING) {
+        fmt_line("error", "Not in programming mode");
         return;
     }
+    uint8_t flb[FUSE_BYTES];
     if (arg1 == NULL) {
-        print_fuse_status(0);
+        read_fuse_and_lock_bits(flb, fuse_extended());
+        print_fuse_status(flb, 0);
     } else if (strcmp(arg1, "reset") == 0) {
         /* Check if we can reset fuses for this one */
-        if (!print_fuse_status(1))
+        read_fuse_and_lock_bits(flb, fuse_extended());
+        if (!print_fuse_status(flb, 1))
             return;
-        puts("status    \tProgramming low fuse bits");
-        program_fuse_low_bits(record->fuse_low_factory);
-        puts("status    \tProgramming high fuse bits");
-        program_fuse_high_bits(record->fuse_high_factory);
-        if (record->flags & AVR_FLAG_FUSE_EXTENDED) {
-            puts("status    \tProgramming extended fuse bits");
-            program_fuse_extended_bits(record->fuse_extended_factory);
-        }
-        print_fuse_status(2);
-    } else if (strcmp(arg1, "low") == 0) {
-        puts("status    \tProgramming low fuse bits");
-        program_fuse_low_bits(0xE0);
-        puts("ok        \tDone");
-    } else if (strcmp(arg1, "high") == 0) {
-        
-    } else if (strcmp(arg1, "extended") == 0) {
-        
-    } else if (strcmp(arg1, "lock") == 0) {
-        
+        uint8_t select = FUSE_LOW_bm | FUSE_HIGH_bm;
+        flb[FUSE_LOW] = session_record->fuse_low_factory;
+        flb[FUSE_HIGH] = session_record->fuse_high_factory;
+        if (session_record->flags & AVR_FLAG_FUSE_EXTENDED) {
+            flb[FUSE_EXTENDED] = session_record->fuse_extended_factory;
+            select |= FUSE_EXTENDED_bm;
+        }
+        if (write_fuses(flb, select)) {
+            print_fuse_status(flb, 2);
+        }
+    } else if (strcmp(arg1, "set") == 0) {
+        set_fuses();
     } else {
-        printf("error     \tInvalid argument '%s'; expected 'low', 'high', 'extended', 'lock' or 'reset'\n", arg1);
+        print_rejected("Invalid argument", arg1, "; expected 'set' or 'reset'");
     }
 }
 
+void cmd_read() {
+    char* arg1 = strtok(NULL, " ");
+    char* arg2 = strtok(NULL, " ");
+    char* arg3 = strtok(NULL, " ");
+    uint32_t start, length;
+    uint8_t flash;
+    if (session_mode != SESSION_PROGRAMMING) {
+        fmt_line("error", "Not in programming mode");
+        return;
+    }
+    if ((arg1 != NULL) && (strcmp(arg1, "flash") == 0)) {
+        flash = 1;
+    } else if ((arg1 != NULL) && (strcmp(arg1, "eeprom") == 0)) {
+        flash = 0;
+    } else {
+        fmt_line("error", "Expected 'flash' or 'eeprom'");
+        return;
+    }
+    if (!parse_hex(arg2, &start) || !parse_hex(arg3, &length) || strtok(NULL, " ")) {
+        fmt_line("error", "Expected hexadecimal <start> and <length> in bytes");
+        return;
+    }
+    if (!range_fits(start, length, flash ? AVR_FLASH_SIZE(session_record) : session_record->eeprom_size)) {
+        fmt_line("error", flash ? "Range beyond Flash" : "Range beyond EEPROM");
+        return;
+    }
+    if (flash) {
+        read_flash_start();
+    } else {
+        read_eeprom_start();
+    }
+    uint16_t word = 0;
+    for (uint32_t address = start; address < start + length; address++) {
+        if ((address - start) % 16 == 0) {
+            if (address != start) {
+                fmt_end();
+            }
+            if (fmt_machine) {
+                fmt_str(flash ? "flash." : "eeprom.");
+                fmt_hex(address, 5);
+                fmt_char('=');
+            } else {
+                fmt_tag(flash ? "flash" : "eeprom");
+                fmt_hex(address, 5);
+                fmt_char('\t');
+            }
+        }
+        uint8_t data;
+        if (!flash) {
+            data = read_eeprom_next(address);
+        } else if ((address & 1) && (address != start)) {
+            data = word >> 8;
+        } else {
+            word = read_flash_next(address >> 1);
+            data = (address & 1) ? (word >> 8) : (word & 0xFF);
+        }
+        fmt_hex(data, 2);
+        if (!fmt_machine) {
+            fmt_char(' ');
+        }
+    }
+    if (length) {
+        fmt_end();
+    }
+    fmt_tag("ok");
+    fmt_str("Read ");
+    fmt_dec(length, 0);
+    fmt_str(" bytes");
+    fmt_end();
+}
+
+void cmd_verify() {
+    char* arg1 = strtok(NULL, " ");
+    char* arg2 = strtok(NULL, " ");
+    char* arg3 = strtok(NULL, " ");
+    uint32_t start, length;
+    if (session_mode != SESSION_PROGRAMMING) {
+        fmt_line("error", "Not in programming mode");
+        return;
+    }
+    if ((arg1 == NULL) || (strcmp(arg1, "crc") != 0)) {
+        fmt_line("error", "Expected 'crc'");
+        return;
+    }
+    if (!parse_hex(arg2, &start) || !parse_hex(arg3, &length) || strtok(NULL, " ")) {
+        fmt_line("error", "Expected hexadecimal <start> and <length> in bytes");
+        return;
+    }
+    if (!range_fits(start, length, AVR_FLASH_SIZE(session_record))) {
+        fmt_line("error", "Range beyond Flash");
+        return;
+    }
+    if (!gang_targets) {
+        fmt_tag("crc32");
+        fmt_hex(read_flash_crc32(start, length), 8);
+        fmt_end();
+        return;
+    }
+    for (uint8_t target = 0; target < GANG_TARGETS_MAX; target++) {
+        if ((gang_targets & (1 << target)) && (gang_read_select(target) == GANG_OK)) {
+            fmt_tag("crc32");
+            fmt_hex(read_flash_crc32(start, length), 8);
+            fmt_str("\ttarget ");
+            fmt_dec(target, 0);
+            fmt_end();
+        }
+    }
+    gang_read_select(gang_first());
+}
+
+static int8_t write_result;
+
+static int8_t write_hex_data(const uint32_t address, const uint8_t* data, const uint8_t length) {
+    write_result = image_seek(address);
+    for (uint8_t i = 0; (i < length) && (write_result >= 0); i++) {
+        write_result = image_put(data[i]);
+    }
+    return write_result;
+}
+
+/**
+ * Discards input until the line stays quiet for 100 ms, so the rest of 
+ * a rejected upload is not taken for commands.
+ */
+static void write_drain(void) {
+    uint8_t idle = 0;
+    while (idle < 100) {
+        if (usart1_available()) {
+            usart1_getc(NULL);
+            idle = 0;
+        } else {
+            _delay_ms(1);
+            idle++;
+        }
+    }
+}
+
+static void print_write_error(const int8_t result) {
+    switch (result) {
+        case PROG_ERROR_NOT_ERASED:
+            fmt_line("error", "Page needs erasing, use 'erase' first");
+            break;
+        case IMAGE_ERROR_ORDER:
+            fmt_line("error", "Address goes back to a page already written");
+            break;
+        case IMAGE_ERROR_RANGE:
+            fmt_line("error", "Address beyond Flash");
+            break;
+        case PROG_ERROR_TIMEOUT:
+            fmt_line("error", "Target does not respond (RDY/BSY timeout)");
+            break;
+    }
+}
+
+/**
+ * Writes bytes given as a hexadecimal string, e.g. 'write eeprom 10 DEADBEEF'.
+ */
+static void write_eeprom(char* arg2, char* arg3) {
+    uint8_t data[sizeof(line) / 2];
+    uint32_t start;
+    uint16_t length = 0;
+    if (!parse_hex(arg2, &start) || (arg3 == NULL) || strtok(NULL, " ")) {
+        fmt_line("error", "Expected hexadecimal <start> and <data>");
+        return;
+    }
+    for (char* digit = arg3; *digit != 0; digit += 2) {
+        char byte[3] = { digit[0], digit[1], 0 };
+        uint32_t value;
+        if ((digit[1] == 0) || !parse_hex(byte, &value)) {
+            fmt_line("error", "Data has to be an even number of hexadecimal digits");
+            return;
+        }
+        data[length++] = value;
+    }
+    if (!range_fits(start, length, session_record->eeprom_size)) {
+        fmt_line("error", "Range beyond EEPROM");
+        return;
+    }
+    if (gang_targets) {
+        fmt_line("error", "EEPROM is written one target at a time, not in gang mode");
+        return;
+    }
+    int16_t written = program_eeprom(start, data, length, session_record->eeprom_page_size);
+    if (written < 0) {
+        print_write_error(written);
+        return;
+    }
+    fmt_tag("ok");
+    fmt_str("Written ");
+    fmt_dec(length, 0);
+    fmt_str(" bytes, ");
+    fmt_dec(written, 0);
+    fmt_str(" pages changed");
+    fmt_end();
+}
+
+/**
+ * Reads Intel HEX (up to the end of file record) or raw binary (given number
+ * of bytes, from address 0) straight from the UART and programs Flash page by 
+ * page while it arrives, e.g.:
+ *   printf 'write hex\r' > /dev/ttyACM0; cat firmware.hex > /dev/ttyACM0
+ */
+void cmd_write() {
+    char* arg1 = strtok(NULL, " ");
+    char* arg2 = strtok(NULL, " ");
+    uint32_t length = 0;
+    int8_t result = IHEX_OK;
+    if (session_mode != SESSION_PROGRAMMING) {
+        fmt_line("error", "Not in programming mode");
+        return;
+    }
+    if ((arg1 != NULL) && (strcmp(arg1, "eeprom") == 0)) {
+        write_eeprom(arg2, strtok(NULL, " "));
+        return;
+    }
+    uint8_t hex = (arg1 != NULL) && (strcmp(arg1, "hex") == 0);
+    if (!hex && ((arg1 == NULL) || (strcmp(arg1, "bin") != 0))) {
+        fmt_line("error", "Expected 'hex', 'bin' or 'eeprom'");
+        return;
+    }
+    if ((hex && (arg2 != NULL)) || (!hex && !parse_hex(arg2, &length)) || strtok(NULL, " ")) {
+        fmt_line("error", "Expected hexadecimal <length> in bytes for 'bin' only");
+        return;
+    }
+    if (length > AVR_FLASH_SIZE(session_record)) {
+        fmt_line("error", "Length beyond Flash");
+        return;
+    }
+    fmt_line("ok", hex ? "Send Intel HEX file" : "Send binary file");
+    image_start(0, session_record->flash_page_words, AVR_FLASH_SIZE(session_record));
+    write_result = PROG_OK;
+    if (hex) {
+        static ihex_parser parser;
+        ihex_reset(&parser);
+        do {
+            result = ihex_feed(&parser, usart1_getc(NULL), write_hex_data);
+        } while (result == IHEX_OK);
+        if (result < 0) {
+            fmt_tag("error");
+            fmt_str("Line ");
+            fmt_dec(parser.line, 0);
+            fmt_str(
+                (result == IHEX_ERROR_SYNTAX) ? ": syntax error" :
+                (result == IHEX_ERROR_CHECKSUM) ? ": checksum mismatch" :
+                (result == IHEX_ERROR_RECORD) ? ": invalid record" : ": write failed");
+            fmt_end();
+        }
+    } else {
+        for (uint32_t i = 0; (i < length) && (write_result >= 0); i++) {
+            write_result = image_put(usart1_getc(NULL));
+        }
+    }
+    if (write_result >= 0) {
+        write_result = image_flush();
+    } else {
+        program_flash_finish();
+    }
+    if ((result < 0) || (write_result < 0)) {
+        print_write_error(write_result);
+        write_drain();
+        return;
+    }
+    fmt_tag("ok");
+    fmt_str("Written ");
+    fmt_dec(image_length, 0);
+    fmt_str(" bytes, ");
+    fmt_dec(image_pages, 0);
+    fmt_str(" pages, ");
+    fmt_dec(image_skipped, 0);
+    fmt_str(" skipped");
+    fmt_end();
+}
+
+void cmd_store() {
+    store_header header;
+    char* arg1 = strtok(NULL, " ");
+    if ((arg1 != NULL) && (strcmp(arg1, "run") == 0) && !strtok(NULL, " ")) {
+        standalone_run();
+        return;
+    } else if (arg1 != NULL) {
+        fmt_line("error", "Expected no arguments or 'run'");
+        return;
+    }
+    if (store_read_header(&header) < 0) {
+        fmt_line("warning", "No valid image in store");
+        return;
+    }
+    print_signature(header.signature);
+    fmt_tag("image");
+    fmt_dec(header.image_length, 0);
+    fmt_str(" bytes, page ");
+    fmt_dec(header.page_words, 0);
+    fmt_str(" words, CRC-32 ");
+    fmt_hex(header.image_crc, 8);
+    fmt_end();
+    if (header.flags & STORE_FLAG_FUSES) {
+        const uint8_t flb[FUSE_BYTES] = { header.fuse_low, header.fuse_high, header.fuse_extended, header.lock };
+        fmt_tag("fuses");
+        for (uint8_t i = 0; i < FUSE_BYTES; i++) {
+            fmt_str(i ? ", " : "");
+            fmt_str(fuse_names[i]);
+            fmt_char(' ');
+            fmt_hex(flb[i], 2);
+        }
+        fmt_end();
+    }
+    fmt_line("ok", "Press PROGRAM button to program target");
+}
+
+static void print_job_length(const uint16_t length) {
+    fmt_tag("ok");
+    fmt_str("Job ");
+    fmt_dec(length, 0);
+    fmt_str(" bytes");
+    fmt_end();
+}
+
+/**
+ * Job script in the store: list, add a step, clear, or run it.
+ */
+void cmd_job() {
+    static const char* const errors[] = { 
+        "malformed step", "not allowed in this target state", "signature does not match",
+        "store read failed", "write failed", "verification failed" 
+    };
+    uint8_t job[JOB_SIZE_MAX];
+    int16_t length;
+    char* arg1 = strtok(NULL, " ");
+    if ((arg1 != NULL) && (strcmp(arg1, "run") == 0) && !strtok(NULL, " ")) {
+        job_status status;
+        switch (standalone_job(&status)) {
+            case STANDALONE_ERROR_STATE:
+                fmt_line("error", "Job requires target to be powered down, gang mode off");
+                return;
+            case STANDALONE_ERROR_JOB:
+                fmt_line("error", "No job in store");
+                return;
+        }
+        if (status.result == JOB_OK) {
+            fmt_tag("ok");
+            fmt_str("Job done, ");
+            fmt_dec(status.step, 0);
+            fmt_str(" steps in ");
+        } else {
+            fmt_tag("error");
+            fmt_str("Step ");
+            fmt_dec(status.step + 1, 0);
+            fmt_str(" (");
+            fmt_str(job_names[status.op]);
+            fmt_str(") ");
+            fmt_str(errors[-1 - status.result]);
+            fmt_str(" after ");
+        }
+        fmt_dec(status.ms, 0);
+        fmt_str(" ms");
+        fmt_end();
+        return;
+    } else if ((arg1 != NULL) && (strcmp(arg1, "clear") == 0) && !strtok(NULL, " ")) {
+        if (store_write_job(job, 0) < 0) {
+            fmt_line("error", "Store write failed");
+        } else {
+            fmt_line("ok", "Job cleared");
+        }
+        return;
+    } else if ((arg1 != NULL) && (strcmp(arg1, "add") == 0)) {
+        length = store_read_job(job);
+        length = job_compile(strtok(NULL, ""), job, (length < 0) ? 0 : length);
+        if (length < 0) {
+            fmt_line("error", "Invalid step or job full");
+        } else if (store_write_job(job, length) < 0) {
+            fmt_line("error", "Store write failed");
+        } else {
+            print_job_length(length);
+        }
+        return;
+    } else if (arg1 != NULL) {
+        fmt_line("error", "Expected no arguments, 'add <step>', 'clear' or 'run'");
+        return;
+    }
+    length = store_read_job(job);
+    if (length <= 0) {
+        fmt_line("warning", "No job in store");
+        return;
+    }
+    uint8_t step = 1;
+    int16_t size;
+    for (int16_t i = 0; (i < length) && ((size = job_step_length(job + i, length - i)) > 0); i += size) {
+        fmt_tag("job");
+        fmt_dec(step++, 2);
+        fmt_char(' ');
+        job_print(job + i);
+    }
+    print_job_length(length);
+}
+
+void cmd_gang() {
+    char* arg1 = strtok(NULL, " ");
+    char* end;
+    uint8_t ready;
+    if (arg1 == NULL) {
+        if (!gang_targets) {
+            fmt_line("gang", "Off, single target");
+        } else if (gang_ready(&ready) < 0) {
+            fmt_line("error", "GPIO expander does not respond");
+        } else {
+            for (uint8_t target = 0; target < GANG_TARGETS_MAX; target++) {
+                if (gang_targets & (1 << target)) {
+                    fmt_tag("gang");
+                    fmt_str("Target ");
+                    fmt_dec(target, 0);
+                    fmt_str((ready & (1 << target)) ? " ready" : " busy");
+                    fmt_end();
+                }
+            }
+        }
+        return;
+    }
+    if (session_mode != SESSION_OFF) {
+        fmt_line("error", "Gang mode can only be changed with targets powered down");
+        return;
+    }
+    if ((strcmp(arg1, "off") == 0) && !strtok(NULL, " ")) {
+        gang_disable();
+        fmt_line("ok", "Single target");
+        return;
+    }
+    uint32_t count = strtoul(arg1, &end, 10);
+    if ((*end != 0) || (count < 1) || (count > GANG_TARGETS_MAX) || strtok(NULL, " ")) {
+        fmt_tag("error");
+        fmt_str("Expected 'off' or number of targets up to ");
+        fmt_dec(GANG_TARGETS_MAX, 0);
+        fmt_end();
+        return;
+    }
+    if (gang_enable(count) < 0) {
+        fmt_line("error", "GPIO expander does not respond");
+        return;
+    }
+    fmt_tag("ok");
+    fmt_str("Gang mode with ");
+    fmt_dec(count, 0);
+    fmt_str(" targets");
+    fmt_end();
+}
+
+/**
+ * Tagged line with a baud rate between two texts.
+ */
+static void print_baud(const char* tag, const char* prefix, const uint32_t baudrate, const char* suffix) {
+    fmt_tag(tag);
+    fmt_str(prefix);
+    fmt_dec(baudrate, 0);
+    fmt_str(suffix);
+    fmt_end();
+}
+
+void cmd_baud() {
+    char* arg1 = strtok(NULL, " ");
+    char* end;
+    if (arg1 == NULL) {
+        print_baud("baud", "", usart1_get_baudrate(), "");
+        return;
+    }
+    uint32_t baudrate = strtoul(arg1, &end, 10);
+    if ((*end != 0) || strtok(NULL, " ")) {
+        fmt_line("error", "Expected decimal <rate>");
+        return;
+    }
+    print_baud("ok", "Switching to ", baudrate, " baud, send a line to confirm");
+    switch (usart1_negotiate_baudrate(baudrate)) {
+        case 0:
+            print_baud("ok", "Baud rate ", baudrate, "");
+            break;
+        case -1:
+            print_baud("error", "Baud rate ", baudrate, " not achievable");
+            break;
+        default:
+            print_baud("error", "No response, back to ", usart1_get_baudrate(), " baud");
+    }
+}
+
+static void print_console_mode(void) {
+    fmt_line("ok", fmt_machine ? "Machine mode" : "Text mode");
+}
+
+/**
+ * A binary session returns to the console mode it was started from, text 
+ * or machine; STK500v2 is left with 'mode text' and returns to text.
+ */
+void cmd_mode() {
+    char* arg1 = strtok(NULL, " ");
+    if ((arg1 == NULL) || strtok(NULL, " ")) {
+        fmt_line("error", "Expected 'text', 'machine', 'binary' or 'stk500'");
+    } else if (strcmp(arg1, "text") == 0) {
+        fmt_machine = 0;
+        print_console_mode();
+    } else if (strcmp(arg1, "machine") == 0) {
+        fmt_machine = 1;
+        print_console_mode();
+    } else if (strcmp(arg1, "binary") == 0) {
+        fmt_line("ok", "Binary mode, send FRAME_OP_TEXT frame to leave");
+        binary_session();
+        print_console_mode();
+    } else if (strcmp(arg1, "stk500") == 0) {
+        fmt_line("ok", "STK500v2 mode, type 'mode text' to leave");
+        stk500_session();
+        fmt_machine = 0;
+        print_console_mode();
+    } else {
+        print_rejected("Invalid argument", arg1, "; expected 'text', 'machine', 'binary' or 'stk500'");
+    }
+}
+
+/**
+ * Longest write times measured in this programming session and the timeouts 
+ * derived from them.
+ */
+void cmd_timing() {
+    static const char* const kinds[WRITE_KINDS] = { "erase", "flash page", "eeprom page", "fuse, lock" };
+    static const char* const keys[WRITE_KINDS] = { "erase_ms", "flash_page_ms", "eeprom_page_ms", "fuse_lock_ms" };
+    if (strtok(NULL, " ")) {
+        fmt_line("error", "Command does not accept arguments");
+        return;
+    }
+    if (session_mode != SESSION_PROGRAMMING) {
+        fmt_line("error", "Not in programming mode");
+        return;
+    }
+    for (uint8_t kind = 0; kind < WRITE_KINDS; kind++) {
+        uint32_t measured = target_write_time_us(kind);
+        uint32_t timeout = target_timeout_us(kind);
+        if (fmt_machine) {
+            fmt_key("timing", keys[kind]);
+            fmt_ms(measured, 0);
+            fmt_field("timeout_ms");
+            fmt_ms(timeout, 0);
+            fmt_end();
+            continue;
+        }
+        fmt_tag("timing");
+        fmt_pad(kinds[kind], 11);
+        fmt_char(' ');
+        fmt_ms(measured, 2);
+        fmt_str(" ms, timeout ");
+        fmt_ms(timeout, 3);
+        fmt_str(" ms");
+        fmt_end();
+    }
+}
+
+#if STATS_ENABLED
+void cmd_stats() {
+    char* arg1 = strtok(NULL, " ");
+    if ((arg1 != NULL) && ((strcmp(arg1, "reset") != 0) || strtok(NULL, " "))) {
+        fmt_line("error", "Expected no arguments or 'reset'");
+        return;
+    }
+    uint32_t window = stats_window();
+    uint32_t us = window / (F_CPU / 1000000UL);
+    fmt_tag("stats");
+    fmt_str("Window ");
+    fmt_ms(us, 0);
+    fmt_str(" ms");
+    fmt_end();
+    for (uint8_t i = 0; i < STATS_COUNTERS; i++) {
+        us = stats[i].cycles / (F_CPU / 1000000UL);
+        fmt_tag("stats");
+        fmt_pad(stats_names[i], 11);
+        fmt_char(' ');
+        fmt_dec(stats[i].count, 8);
+        fmt_str(" x ");
+        fmt_ms(us, 6);
+        fmt_str(" ms ");
+        fmt_dec(stats[i].cycles / (window / 100 + 1), 3);
+        fmt_char('%');
+        fmt_end();
+    }
+    if (arg1 != NULL) {
+        stats_reset();
+        fmt_line("ok", "Counters reset");
+    }
+}
+#endif
+
 void cmd_unknown(char* command) {
-    printf("error     \tUnrecognized command '%s'\n", command);
+    print_rejected("Unrecognized command", command, "");
 }
 
 int main(void) {
     init();
-        
-    /*
-    printf("Erasing chip... ");
-    erase_chip();
-    printf("done.\n");
-    
-    _delay_ms(1000);
-    
-    printf("Programming fuse bits... ");
-    program_fuse_high_bits(0x99);
-    program_fuse_low_bits(0xE1);
-    printf("done.\n");
-
-     */
+    store_init();
+    gang_disable(); // Routes target 0 when a gang expander is fitted
     volatile int r = 0;
     while (1) {
-        r = usart1_gets(line, 255);
+        while (!usart1_available()) {
+            standalone_poll();
+        }
+        r = console_gets(line, 255);
         if (r <= 0)
             continue;
         char* command = strtok(line, " ");
@@ -214,6 +990,30 @@ int main(void) {
             cmd_run();
         } else if (strcmp(command, "fuse") == 0) {
             cmd_fuse();
+        } else if (strcmp(command, "read") == 0) {
+            cmd_read();
+        } else if (strcmp(command, "erase") == 0) {
+            cmd_erase();
+        } else if (strcmp(command, "write") == 0) {
+            cmd_write();
+        } else if (strcmp(command, "verify") == 0) {
+            cmd_verify();
+        } else if (strcmp(command, "store") == 0) {
+            cmd_store();
+        } else if (strcmp(command, "job") == 0) {
+            cmd_job();
+        } else if (strcmp(command, "gang") == 0) {
+            cmd_gang();
+        } else if (strcmp(command, "baud") == 0) {
+            cmd_baud();
+        } else if (strcmp(command, "timing") == 0) {
+            cmd_timing();
+        } else if (strcmp(command, "mode") == 0) {
+            cmd_mode();
+#if STATS_ENABLED
+        } else if (strcmp(command, "stats") == 0) {
+            cmd_stats();
+#endif
         } else {
             cmd_unknown(command);
         }
@@ -0,0 +1,28 @@
+/* 
+ * File:   pins.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Programming bus pin map, needs PINn_bm from <avr/io.h> or the host 
+ * simulator.
+ */
+
+#ifndef PINS_H
+#define	PINS_H
+
+#define PF_BS2_bm PIN0_bm
+#define PF_TRESET_bm PIN1_bm
+#define PF_12V_EN_bm PIN2_bm
+#define PF_5V_EN_bm PIN3_bm
+#define PF_RDY_BSY_bm PIN4_bm
+#define PF_PROGRAM_bm PIN5_bm
+
+#define PD_PAGEL_bm PIN1_bm
+#define PD_XA1_bm PIN2_bm
+#define PD_XA0_bm PIN3_bm
+#define PD_BS1_bm PIN4_bm
+#define PD_WR_bm PIN5_bm
+#define PD_OE_bm PIN6_bm
+#define PD_XTAL1_bm PIN7_bm
+
+#endif	/* PINS_H */
+
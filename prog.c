@@ -17,33 +17,180 @@ void read_signature(uint32_t* signature) {
     sig[0] = read_byte();
 }
 
+/**
+ * Factory calibration byte of the internal RC oscillator, read with the
+ * signature command and BS1 high.
+ */
+uint8_t read_calibration_byte(void) {
+    load_command(0b00001000);
+    load_address_low_byte(0x00);
+    return read_word() >> 8;
+}
+
+/**
+ * Binary search over the database, which is sorted by signature.
+ */
 const avr_record* lookup_signature(const uint32_t signature) {
-    const int database_length = sizeof(database) / sizeof(avr_record);
-    for (int i = 0; i < database_length; i++) {
-        if (database[i].signature == signature) {
-            return &database[i];
+    uint16_t low = 0;
+    uint16_t high = sizeof(database) / sizeof(avr_record);
+    while (low < high) {
+        uint16_t middle = (low + high) / 2;
+        if (database[middle].signature < signature) {
+            low = middle + 1;
+        } else if (database[middle].signature > signature) {
+            high = middle;
+        } else {
+            return &database[middle];
         }
     }
     return NULL;
 }
 
+/*
+ * Write completion. RDY/BSY rising edge is caught by the PORTF pin interrupt,
+ * so waiting for the target sleeps instead of polling, and a write can run 
+ * in the background while the next one is prepared.
+ * Every write also starts the write timer: its compare match ends the wait 
+ * when the target does not respond, and the time RDY/BSY went high at is 
+ * kept per kind of write to tighten the following timeouts.
+ */
+static volatile uint8_t target_writing = 0;
+static volatile uint8_t target_expired = 0;
+/* Write timer is running, its ticks are not yet recorded */
+static uint8_t target_timing = 0;
+/* Write timed out, kept until returned by target_wait() */
+static uint8_t target_failed = 0;
+static volatile uint16_t target_ticks = 0;
+static uint8_t target_kind = WRITE_ERASE;
+/* Longest measured write per kind in timer ticks, 0 until measured */
+static uint16_t write_ticks[WRITE_KINDS];
+/* Write Flash command is loaded, page programming in progress */
+static uint8_t flash_write_open = 0;
+
+#define US_TO_TICKS(us) ((uint32_t) (us) * (HAL_TIMER_HZ / 1000) / 1000)
+#define TICKS_TO_US(ticks) ((uint32_t) (ticks) * 1000 / (HAL_TIMER_HZ / 1000))
+
+HAL_READY_ISR() {
+    if (HAL_READY_FLAG()) {
+        target_ticks = HAL_TIMER_TICKS();
+        target_writing = 0;
+    }
+    HAL_READY_FLAG_CLEAR();
+}
+
+HAL_TIMER_ISR() {
+    target_expired = 1;
+    HAL_TIMER_FLAG_CLEAR();
+}
+
+/**
+ * Timer ticks after which a write of the given kind is given up.
+ */
+static uint16_t write_timeout(const uint8_t kind) {
+    uint32_t limit = US_TO_TICKS(T_TIMEOUT_FACTOR * 
+        ((kind == WRITE_ERASE) ? T_WLRH_CE_US : T_WLRH_US));
+    uint32_t adaptive = 2UL * write_ticks[kind] + US_TO_TICKS(T_TIMEOUT_MARGIN_US);
+    return ((write_ticks[kind] != 0) && (adaptive < limit)) ? adaptive : limit;
+}
+
+/**
+ * Gives WR a negative pulse, which starts the operation selected by the
+ * loaded command. RDY/BSY goes low until it is completed.
+ */
+static void target_write(const uint8_t kind) {
+    STATS_START();
+    target_kind = kind;
+    target_expired = 0;
+    target_writing = 1;
+    target_timing = 1;
+    HAL_READY_FLAG_CLEAR();
+    HAL_TIMER_START(write_timeout(kind));
+    WR_NEGATIVE_PULSE();
+    STATS_STOP(STATS_BUS_WRITE);
+}
+
+/**
+ * Returns nonzero while an operation started by WR is in progress.
+ */
+uint8_t target_busy(void) {
+    return target_writing;
+}
+
+/**
+ * Sleeps until the operation started by WR is completed, or until it times 
+ * out, which is kept for target_wait(). The duration of the write is
+ * recorded here even when it completed before the call.
+ */
+static void target_idle(void) {
+    if (target_writing) {
+        STATS_WAIT_START();
+        HAL_INTERRUPTS_DISABLE();
+        while (target_writing && !target_expired) {
+            HAL_IDLE();
+        }
+        HAL_INTERRUPTS_ENABLE();
+        STATS_WAIT_STOP(STATS_TARGET_BUSY);
+    }
+    // A pipelined write may have completed before this wait
+    if (!target_timing) {
+        return;
+    }
+    target_timing = 0;
+    HAL_TIMER_STOP();
+    if (target_writing) {
+        target_writing = 0;
+        target_failed = 1;
+    } else if (target_ticks > write_ticks[target_kind]) {
+        write_ticks[target_kind] = target_ticks;
+    }
+}
+
+/**
+ * Waits for the operation started by WR; returns PROG_OK, or 
+ * PROG_ERROR_TIMEOUT once for a write which timed out, also when an 
+ * earlier wait of load_command() found it.
+ */
+int8_t target_wait(void) {
+    target_idle();
+    if (target_failed) {
+        target_failed = 0;
+        return PROG_ERROR_TIMEOUT;
+    }
+    return PROG_OK;
+}
+
+/**
+ * Longest measured duration of a write kind (WRITE_*) in this programming 
+ * session, 0 until one completes.
+ */
+uint32_t target_write_time_us(const uint8_t kind) {
+    return TICKS_TO_US(write_ticks[kind]);
+}
+
+/**
+ * Current timeout of a write kind (WRITE_*).
+ */
+uint32_t target_timeout_us(const uint8_t kind) {
+    return TICKS_TO_US(write_timeout(kind));
+}
+
 void read_fuse_and_lock_bits(uint8_t* fuse_and_lock_bits, uint8_t read_extended) {
     load_command(0b00000100);
-    PORTF.OUTCLR = PF_BS2_bm;
-    PORTD.OUTCLR = PD_BS1_bm;
+    HAL_BS2_CLEAR();
+    HAL_CONTROL_CLEAR(PD_BS1_bm);
     fuse_and_lock_bits[0] = read_data(); // Fuse Low
-    PORTF.OUTSET = PF_BS2_bm;
-    PORTD.OUTSET = PD_BS1_bm;
+    HAL_BS2_SET();
+    HAL_CONTROL_SET(PD_BS1_bm);
     fuse_and_lock_bits[1] = read_data(); // Fuse High
     if (read_extended) {
-        PORTF.OUTSET = PF_BS2_bm;
-        PORTD.OUTCLR = PD_BS1_bm;
+        HAL_BS2_SET();
+        HAL_CONTROL_CLEAR(PD_BS1_bm);
         fuse_and_lock_bits[2] = read_data(); // Fuse Ext
     } else {
         fuse_and_lock_bits[2] = 0xFF; // even if you try to read it unsupported, it is 0xFF
     }
-    PORTF.OUTCLR = PF_BS2_bm;
-    PORTD.OUTSET = PD_BS1_bm;
+    HAL_BS2_CLEAR();
+    HAL_CONTROL_SET(PD_BS1_bm);
     fuse_and_lock_bits[3] = read_data(); // Lock 
 }
 
@@ -54,219 +201,572 @@ void read_flash(const uint16_t address, uint16_t* data) {
     *data = read_word();
 }
 
-void program_fuse_low_bits(const uint8_t bits) {
+/* 
+ * Sequential readback. Command is loaded once by read_*_start(), then every
+ * read_*_next() call loads only the address low byte, unless the high byte 
+ * differs from the one already latched in the target.
+ */
+static int16_t latched_address_high = -1;
+
+static void load_address(const uint16_t address) {
+    if (latched_address_high != (address >> 8)) {
+        latched_address_high = address >> 8;
+        load_address_high_byte(latched_address_high);
+    }
+    load_address_low_byte(address & 0xFF);
+}
+
+void read_flash_start(void) {
+    // A: Load Command “0000 0010”
+    load_command(0b00000010);
+    latched_address_high = -1;
+}
+
+/**
+ * Reads Flash word at word address after read_flash_start().
+ */
+uint16_t read_flash_next(const uint16_t address) {
+    load_address(address);
+    return read_word();
+}
+
+void read_eeprom_start(void) {
+    // A: Load Command “0000 0011”
+    load_command(0b00000011);
+    latched_address_high = -1;
+}
+
+/**
+ * Reads EEPROM byte at byte address after read_eeprom_start().
+ */
+uint8_t read_eeprom_next(const uint16_t address) {
+    load_address(address);
+    return read_byte();
+}
+
+/**
+ * CRC-32 of Flash contents, start and length in bytes.
+ */
+uint32_t read_flash_crc32(const uint32_t start, const uint32_t length) {
+    uint32_t crc = CRC32_INIT;
+    uint32_t address = start;
+    uint32_t end = start + length;
+    read_flash_start();
+    if ((address < end) && (address & 1)) {
+        crc = crc32_update(crc, read_flash_next(address >> 1) >> 8);
+        address++;
+    }
+    for (; address + 1 < end; address += 2) {
+        uint16_t word = read_flash_next(address >> 1);
+        crc = crc32_update(crc, word & 0xFF);
+        crc = crc32_update(crc, word >> 8);
+    }
+    if (address < end) {
+        crc = crc32_update(crc, read_flash_next(address >> 1) & 0xFF);
+    }
+    return CRC32_FINAL(crc);
+}
+
+/**
+ * CRC-32 of EEPROM contents, start and length in bytes.
+ */
+uint32_t read_eeprom_crc32(const uint16_t start, const uint16_t length) {
+    uint32_t crc = CRC32_INIT;
+    read_eeprom_start();
+    for (uint16_t i = 0; i < length; i++) {
+        crc = crc32_update(crc, read_eeprom_next(start + i));
+    }
+    return CRC32_FINAL(crc);
+}
+
+int8_t program_fuse_low_bits(const uint8_t bits) {
     // A: Load Command “0100 0000”
     load_command(0b01000000);
     // C: Load Data Low Byte. Bit n = “0” programs and bit n = “1” erases the Fuse bit.
     load_data_low_byte(bits);
     // Set BS1 to “0” and BS2 to “0”.
-    PORTD.OUTCLR = PD_BS1_bm;
-    PORTF.OUTCLR = PF_BS2_bm;
+    HAL_CONTROL_CLEAR(PD_BS1_bm);
+    HAL_BS2_CLEAR();
     // Give WR a negative pulse and wait for RDY/BSY to go high.
-    WR_NEGATIVE_PULSE();
-    while (PORTF.IN & PF_RDY_BSY_bm);
-    while (!(PORTF.IN & PF_RDY_BSY_bm));
+    target_write(WRITE_FUSE);
+    return target_wait();
 }
 
-void program_fuse_high_bits(const uint8_t bits) {
+int8_t program_fuse_high_bits(const uint8_t bits) {
     // A: Load Command “0100 0000”
     load_command(0b01000000);
     // C: Load Data Low Byte. Bit n = “0” programs and bit n = “1” erases the Fuse bit.
     load_data_low_byte(bits);
     // Set BS1 to “1” and BS2 to “0”. This selects high data byte.
-    PORTD.OUTSET = PD_BS1_bm;
-    PORTF.OUTCLR = PF_BS2_bm;
+    HAL_CONTROL_SET(PD_BS1_bm);
+    HAL_BS2_CLEAR();
     // Give WR a negative pulse and wait for RDY/BSY to go high.
-    WR_NEGATIVE_PULSE();
-    while (PORTF.IN & PF_RDY_BSY_bm);
-    while (!(PORTF.IN & PF_RDY_BSY_bm));    
+    target_write(WRITE_FUSE);
+    int8_t result = target_wait();
     // Set BS1 to “0”. This selects low data byte.
-    PORTD.OUTCLR = PD_BS1_bm;
+    HAL_CONTROL_CLEAR(PD_BS1_bm);
+    return result;
 }
 
-void program_fuse_extended_bits(const uint8_t bits) {
+int8_t program_fuse_extended_bits(const uint8_t bits) {
     // A: Load Command “0100 0000”
     load_command(0b01000000);
     // C: Load Data Low Byte. Bit n = “0” programs and bit n = “1” erases the Fuse bit.
     load_data_low_byte(bits);
     // Set BS2, BS1 to “10”. This selects extended data byte.
-    PORTF.OUTSET = PF_BS2_bm;
-    PORTD.OUTCLR = PD_BS1_bm;
+    HAL_BS2_SET();
+    HAL_CONTROL_CLEAR(PD_BS1_bm);
     // Give WR a negative pulse and wait for RDY/BSY to go high.
-    WR_NEGATIVE_PULSE();
-    while (PORTF.IN & PF_RDY_BSY_bm);
-    while (!(PORTF.IN & PF_RDY_BSY_bm));    
+    target_write(WRITE_FUSE);
+    int8_t result = target_wait();
     // Set BS2, BS1 to “00”. This selects low data byte.
-    PORTF.OUTCLR = PF_BS2_bm;
+    HAL_BS2_CLEAR();
+    return result;
+}
+
+int8_t program_lock_bits(const uint8_t bits) {
+    // A: Load Command “0010 0000”
+    load_command(0b00100000);
+    // C: Load Data Low Byte. Bit n = “0” programs the Lock bit.
+    load_data_low_byte(bits);
+    // Give WR a negative pulse and wait for RDY/BSY to go high.
+    target_write(WRITE_FUSE);
+    return target_wait();
+}
+
+/*
+ * Fuse and lock transaction. Every write keeps the target busy for several
+ * milliseconds, so bytes which already hold the wanted value are left alone.
+ * Lock bits go last, as they may lock the fuses, and can only be cleared by
+ * chip erase.
+ */
+
+/**
+ * Writes the selected (FUSE_*_bm) bytes of bits, indexed as by 
+ * read_fuse_and_lock_bits(), which differ from the target, then reads all 
+ * of them back into bits. With force every selected byte is written, for
+ * gang targets which are not read. Returns the written bytes (FUSE_*_bm), 
+ * PROG_ERROR_NOT_ERASED when lock bits would need chip erase, 
+ * PROG_ERROR_TIMEOUT or PROG_ERROR_VERIFY.
+ */
+int8_t program_fuse_and_lock_bits(uint8_t* bits, const uint8_t select, const uint8_t read_extended,
+        const uint8_t force) {
+    uint8_t current[FUSE_BYTES];
+    uint8_t wanted[FUSE_BYTES];
+    uint8_t written = 0;
+    int8_t result = PROG_OK;
+    memcpy(wanted, bits, FUSE_BYTES);
+    read_fuse_and_lock_bits(current, read_extended);
+    for (uint8_t i = 0; i < FUSE_BYTES; i++) {
+        if ((select & (1 << i)) && (force || (current[i] != wanted[i]))) {
+            written |= (1 << i);
+        }
+    }
+    if ((written & FUSE_LOCK_bm) && (wanted[FUSE_LOCK] & ~current[FUSE_LOCK])) {
+        return PROG_ERROR_NOT_ERASED;
+    }
+    if (written & FUSE_LOW_bm) {
+        result = program_fuse_low_bits(wanted[FUSE_LOW]);
+    }
+    if ((result == PROG_OK) && (written & FUSE_HIGH_bm)) {
+        result = program_fuse_high_bits(wanted[FUSE_HIGH]);
+    }
+    if ((result == PROG_OK) && (written & FUSE_EXTENDED_bm)) {
+        result = program_fuse_extended_bits(wanted[FUSE_EXTENDED]);
+    }
+    if ((result == PROG_OK) && (written & FUSE_LOCK_bm)) {
+        result = program_lock_bits(wanted[FUSE_LOCK]);
+    }
+    if (result < 0) {
+        return result;
+    }
+    read_fuse_and_lock_bits(bits, read_extended);
+    for (uint8_t i = 0; i < FUSE_BYTES; i++) {
+        if ((select & (1 << i)) && (bits[i] != wanted[i])) {
+            return PROG_ERROR_VERIFY;
+        }
+    }
+    return written;
+}
+
+/*
+ * Page skipping. After chip erase every page reads 0xFFFF, so blank pages
+ * need not be written. In update mode (no chip erase) the page is read back
+ * first and skipped when it already holds the data; since a page write can
+ * only clear bits, pages which would need a bit set are refused.
+ */
+static uint8_t flash_erased = 0;
+static uint8_t flash_update = 0;
+
+void set_flash_update_mode(const uint8_t enabled) {
+    flash_update = enabled;
 }
 
-void erase_chip() {
+uint8_t flash_page_blank(const uint16_t* data, const uint8_t page_words) {
+    for (uint8_t i = 0; i < page_words; i++) {
+        if (data[i] != 0xFFFF) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int8_t flash_page_compare(const uint16_t address, const uint16_t* data, const uint8_t page_words) {
+    int8_t result = PROG_SKIPPED;
+    read_flash_start();
+    for (uint8_t i = 0; i < page_words; i++) {
+        uint16_t current = read_flash_next(address + i);
+        if (data[i] & ~current) {
+            return PROG_ERROR_NOT_ERASED;
+        } else if (data[i] != current) {
+            result = PROG_OK;
+        }
+    }
+    return result;
+}
+
+/**
+ * Starts programming a single Flash page and returns while the target is 
+ * still busy writing it, so the next page can be prepared meanwhile.
+ * - address is the word address of the first word in the page
+ * - page_words is the page size of the target device, in words
+ * Waits for the previous write first. Whole page is latched into the target 
+ * page buffer (one PAGEL pulse per word), then written with a single WR pulse.
+ * Has to be followed by program_flash_finish() after the last page.
+ * Returns PROG_OK, PROG_SKIPPED, PROG_ERROR_NOT_ERASED or PROG_ERROR_TIMEOUT 
+ * (previous page write did not complete).
+ */
+int8_t program_flash_page_start(const uint16_t address, const uint16_t* data, const uint8_t page_words) {
+    if (flash_erased && flash_page_blank(data, page_words)) {
+        return PROG_SKIPPED;
+    }
+    if (target_wait() < 0) {
+        return PROG_ERROR_TIMEOUT;
+    }
+    if (flash_update && !flash_erased) {
+        int8_t result = flash_page_compare(address, data, page_words);
+        if (result != PROG_OK) {
+            return result;
+        }
+    }
+    if (!flash_write_open) {
+        // A: Load Command “0001 0000”
+        load_command(0b00010000);
+    }
+    for (uint8_t i = 0; i < page_words; i++) {
+        // B: Load Address Low byte
+        // C: Load Data Low Byte
+        // D: Load Data High Byte
+        // E: Latch Data
+        page_load_word((address + i) & 0xFF, data[i]);
+    }
+    // G: Load Address High byte
+    load_address_high_byte(address >> 8);
+    // H: Program Page. Set BS2, BS1 to “00”.
+    HAL_CONTROL_CLEAR(PD_BS1_bm);
+    HAL_BS2_CLEAR();
+    // Give WR a negative pulse, RDY/BSY goes low.
+    target_write(WRITE_FLASH);
+    return PROG_OK;
+}
+
+/**
+ * Waits for the last page write and ends page programming. 
+ * Does nothing when no page programming is in progress.
+ * Returns PROG_OK or PROG_ERROR_TIMEOUT.
+ */
+int8_t program_flash_finish(void) {
+    if (!flash_write_open) {
+        return PROG_OK;
+    }
+    int8_t result = target_wait();
+    // J: End Page Programming. Load Command “0000 0000” (No Operation).
+    load_command(0b00000000);
+    return result;
+}
+
+/**
+ * Programs a single Flash page and waits for the write to complete.
+ */
+int8_t program_flash_page(const uint16_t address, const uint16_t* data, const uint8_t page_words) {
+    int8_t result = program_flash_page_start(address, data, page_words);
+    if (target_wait() < 0) {
+        return PROG_ERROR_TIMEOUT;
+    }
+    return result;
+}
+
+/**
+ * Programs consecutive Flash words page by page.
+ * - address is the word address, it has to be aligned to page_words
+ * - words does not have to be a multiple of page_words, remainder of the
+ *   last page is left erased (0xFFFF)
+ * Stops at the first page which cannot be programmed, returns 
+ * PROG_ERROR_NOT_ERASED or PROG_ERROR_TIMEOUT in such case and PROG_OK 
+ * otherwise.
+ */
+int8_t program_flash(uint16_t address, const uint16_t* data, uint16_t words, const uint8_t page_words) {
+    int8_t result = PROG_OK;
+    while ((words >= page_words) && (result >= 0)) {
+        result = program_flash_page_start(address, data, page_words);
+        address += page_words;
+        data += page_words;
+        words -= page_words;
+    }
+    if ((words > 0) && (result >= 0)) {
+        uint16_t page[page_words];
+        for (uint8_t i = 0; i < page_words; i++) {
+            page[i] = (i < words) ? data[i] : 0xFFFF;
+        }
+        result = program_flash_page_start(address, page, page_words);
+    }
+    if (program_flash_finish() < 0) {
+        return PROG_ERROR_TIMEOUT;
+    }
+    return (result < 0) ? result : PROG_OK;
+}
+
+/**
+ * Programs a single EEPROM page and returns while the target is still busy
+ * writing it.
+ * - address is the byte address of the first byte in the page
+ * - page_size is the EEPROM page size of the target device, in bytes; 
+ *   1 for devices which program EEPROM byte by byte
+ * The page is read back first and left alone if it already holds the data, 
+ * since EEPROM writes take several milliseconds each.
+ * Returns PROG_OK, PROG_SKIPPED or PROG_ERROR_TIMEOUT (previous write did
+ * not complete).
+ */
+int8_t program_eeprom_page(const uint16_t address, const uint8_t* data, const uint8_t page_size) {
+    uint8_t i;
+    if (target_wait() < 0) {
+        return PROG_ERROR_TIMEOUT;
+    }
+    read_eeprom_start();
+    for (i = 0; (i < page_size) && (read_eeprom_next(address + i) == data[i]); i++);
+    if (i == page_size) {
+        return PROG_SKIPPED;
+    }
+    // A: Load Command “0001 0001”
+    load_command(0b00010001);
+    // G: Load Address High Byte
+    load_address_high_byte(address >> 8);
+    for (i = 0; i < page_size; i++) {
+        // B: Load Address Low Byte
+        load_address_low_byte((address + i) & 0xFF);
+        // C: Load Data Byte
+        load_data_low_byte(data[i]);
+        // E: Latch data (give PAGEL a positive pulse)
+        latch_data();
+    }
+    // L: Program EEPROM page. Set BS1 to “0”.
+    HAL_CONTROL_CLEAR(PD_BS1_bm);
+    HAL_BS2_CLEAR();
+    // Give WR a negative pulse. RDY/BSY goes low.
+    target_write(WRITE_EEPROM);
+    return PROG_OK;
+}
+
+/**
+ * Programs length bytes of EEPROM starting at byte address, page by page. 
+ * Bytes of partially covered pages outside the range keep their contents.
+ * Returns the number of pages actually written, or PROG_ERROR_TIMEOUT.
+ */
+int16_t program_eeprom(const uint16_t address, const uint8_t* data, const uint16_t length, 
+        const uint8_t page_size) {
+    uint8_t page[page_size];
+    int16_t written = 0;
+    const uint16_t end = address + length;
+    for (uint16_t start = address - (address % page_size); start < end; start += page_size) {
+        read_eeprom_start();
+        for (uint8_t i = 0; i < page_size; i++) {
+            uint16_t byte = start + i;
+            page[i] = ((byte >= address) && (byte < end)) ? 
+                data[byte - address] : read_eeprom_next(byte);
+        }
+        int8_t result = program_eeprom_page(start, page, page_size);
+        if (result < 0) {
+            return result;
+        }
+        written += (result == PROG_OK);
+    }
+    if (target_wait() < 0) {
+        return PROG_ERROR_TIMEOUT;
+    }
+    return written;
+}
+
+int8_t erase_chip() {
     // Set XA1, XA0 to “10”. This enables command loading.
     // Set BS1 to “0”.
     // Set DATA to “1000 0000”. This is the command for Chip Erase.
     // Give XTAL1 a positive pulse. This loads the command.
     load_command(0b10000000);
     // Give WR a negative pulse. This starts the Chip Erase. RDY/BSY goes low.
-    WR_NEGATIVE_PULSE();
-    while (PORTF.IN & PF_RDY_BSY_bm);
+    target_write(WRITE_ERASE);
     // Wait until RDY/BSY goes high before loading a new command.
-    while (!(PORTF.IN & PF_RDY_BSY_bm));
+    if (target_wait() < 0) {
+        return PROG_ERROR_TIMEOUT;
+    }
+    flash_erased = 1;
+    return PROG_OK;
 }
 
 /* Enter/exit programming mode */
 
 void enter_programming() {
     // Apply 5V and wait at least 100 μs
-    PORTF.OUTSET = PF_5V_EN_bm | PF_TRESET_bm;
-    _delay_us(200);
+    HAL_SUPPLY_SET(PF_5V_EN_bm | PF_TRESET_bm);
+    HAL_DELAY_US(200);
     
     // Set RESET to 0 and toggle XTAL1 at least 6 times 
-    portd_control(); // Enable driving control signals
-    portf_control();
+    HAL_BUS_CONTROL(); // Enable driving control signals
+    target_writing = 0;
+    target_timing = 0;
+    target_failed = 0;
+    memset(write_ticks, 0, sizeof(write_ticks));
+    flash_write_open = 0;
+    flash_erased = 0;
+    flash_update = 0;
     
-    _delay_us(1);
+    HAL_DELAY_US(1);
     for (int i = 0; i < 6; i++) {
         XTAL1_POSITIVE_PULSE();
     }
     
     // Set the Prog_enable pins to \"0000\" and wait at least 100 ns
-    PORTD.OUTCLR = PD_PAGEL_bm | PD_XA1_bm | PD_XA0_bm | PD_BS1_bm;
-    PORTD.OUTSET = PD_WR_bm;
-    _delay_us(1);
+    HAL_CONTROL_LOAD(PD_PAGEL_bm | PD_XA1_bm | PD_XA0_bm | PD_BS1_bm | PD_WR_bm, PD_WR_bm);
+    WAIT_NS(100);
     
     // Apply 12V to RESET 
-    PORTF.OUTCLR = PF_TRESET_bm;
-    PORTF.OUTSET = PF_12V_EN_bm;
-    _delay_us(50);
-    PORTD.OUTCLR = PD_WR_bm;
+    HAL_SUPPLY_CLEAR(PF_TRESET_bm);
+    HAL_SUPPLY_SET(PF_12V_EN_bm);
+    HAL_DELAY_US(50);
+    HAL_CONTROL_CLEAR(PD_WR_bm);
 }
 
 void power_up() {
-    PORTF.OUTSET = PF_5V_EN_bm | PF_TRESET_bm;
-    PORTF.DIRCLR = PF_RDY_BSY_bm; // // RDY/~{BSY} hi-z
-    _delay_ms(1);
-    PORTF.OUTCLR = PF_TRESET_bm;
+    HAL_SUPPLY_SET(PF_5V_EN_bm | PF_TRESET_bm);
+    HAL_READY_RELEASE(); // RDY/~{BSY} hi-z
+    HAL_DELAY_MS(1);
+    HAL_SUPPLY_CLEAR(PF_TRESET_bm);
 }
 
 void power_down() {
-    PORTF.DIRSET = PF_RDY_BSY_bm; // // RDY/~{BSY} pulldown
-    PORTF.OUTCLR = PF_5V_EN_bm | PF_RDY_BSY_bm;
+    HAL_READY_PULLDOWN(); // RDY/~{BSY} pulldown
+    HAL_SUPPLY_CLEAR(PF_5V_EN_bm);
 }
 
 void exit_programming() {
-    PORTF.OUTCLR = PF_12V_EN_bm;
-    PORTF.OUTSET = PF_TRESET_bm;
-    _delay_ms(1);
+    HAL_SUPPLY_CLEAR(PF_12V_EN_bm);
+    HAL_SUPPLY_SET(PF_TRESET_bm);
+    HAL_DELAY_MS(1);
     // Reset all signals to Hi-Z, disable driving control signals
     // It seems that ATmega chips can backfeed power from GPIO lines
     // through their protection diodes, and this is violating Absolute Maximum
     // Ratings for the chip
-    porta_init(); // Data lines
-    portd_init(); // XA0, XA1, BS1, OE, WR, XTAL1, RDY/BSY
-    portf_init(); // BS2
+    HAL_BUS_RELEASE(); // Data lines, XA0, XA1, BS1, OE, WR, XTAL1, BS2, RDY/BSY
     /* Power down and reset release is implied by portf reinit */
 }
 
 /* Low-level programming commands */
 
 void load_command(const uint8_t command) {
+    // Wait until RDY/BSY goes high before loading a new command.
+    // A timeout found here is returned by the next target_wait().
+    target_idle();
+    flash_write_open = (command == 0b00010000);
     // Set XA1, XA0 to “10”. This enables command loading.
-    PORTD.OUTSET = PD_XA1_bm;
-    PORTD.OUTCLR = PD_XA0_bm;
     // Set BS1 to “0”.
-    PORTD.OUTCLR = PD_BS1_bm;
     // Set DATA to <command>.
-    PORTA.DIRSET = 0xFF;
-    PORTA.OUT = command;
     // Give XTAL1 a positive pulse. This loads the command.
-    XTAL1_POSITIVE_PULSE();
-    PORTA.OUT = 0x00;
+    bus_load(PD_LOAD_COMMAND, command);
 }
 
 void load_address_low_byte(const uint8_t address) {
     // Set XA1, XA0 to “00”. This enables address loading.
-    PORTD.OUTCLR = PD_XA1_bm | PD_XA0_bm;
     // Set BS1 to “0”. This selects low address.
-    PORTD.OUTCLR = PD_BS1_bm;
     // Set DATA = Address low byte ($00 - $FF).
-    PORTA.DIRSET = 0xFF;
-    PORTA.OUT = address;
     // Give XTAL1 a positive pulse. This loads the address low byte.
-    XTAL1_POSITIVE_PULSE();
-    PORTA.OUT = 0x00;
+    bus_load(PD_LOAD_ADDRESS_LOW, address);
 }
 
 void load_address_high_byte(const uint8_t address) {
     // Set XA1, XA0 to “00”. This enables address loading.
-    PORTD.OUTCLR = PD_XA1_bm | PD_XA0_bm;
     // Set BS1 to “1”. This selects high address.
-    PORTD.OUTSET = PD_BS1_bm;
     // Set DATA = Address high byte ($00 - $FF).
-    PORTA.DIRSET = 0xFF;
-    PORTA.OUT = address;
-    // Give XTAL1 a positive pulse. This loads the address low byte.
-    XTAL1_POSITIVE_PULSE();
-    PORTA.OUT = 0x00;
+    // Give XTAL1 a positive pulse. This loads the address high byte.
+    bus_load(PD_LOAD_ADDRESS_HIGH, address);
 }
 
 void load_data_low_byte(const uint8_t data) {
     // Set XA1, XA0 to “01”. This enables data loading.
-    PORTD.OUTCLR = PD_XA1_bm;
-    PORTD.OUTSET = PD_XA0_bm;
     // Set BS1 to “0”.
-    PORTD.OUTCLR = PD_BS1_bm;
     // Set DATA = Data low byte ($00 - $FF).
-    PORTA.DIRSET = 0xFF;
-    PORTA.OUT = data;
     // Give XTAL1 a positive pulse. This loads the data byte.
-    XTAL1_POSITIVE_PULSE();
-    PORTA.OUT = 0x00;
+    bus_load(PD_LOAD_DATA_LOW, data);
 }
 
 void load_data_high_byte(const uint8_t data) {
-    // Set BS1 to “1”. This selects high data byte.
-    PORTD.OUTSET = PD_BS1_bm;
     // Set XA1, XA0 to “01”. This enables data loading.
-    PORTD.OUTCLR = PD_XA1_bm;
-    PORTD.OUTSET = PD_XA0_bm;
+    // Set BS1 to “1”. This selects high data byte.
     // Set DATA = Data high byte ($00 - $FF).
-    PORTA.DIRSET = 0xFF;
-    PORTA.OUT = data;
     // Give XTAL1 a positive pulse. This loads the data byte.
-    XTAL1_POSITIVE_PULSE();
-    PORTA.OUT = 0x00;    
+    bus_load(PD_LOAD_DATA_HIGH, data);
+}
+
+void latch_data(void) {
+    STATS_START();
+    // Set BS1 to “1”. This selects high data byte.
+    HAL_CONTROL_SET(PD_BS1_bm);
+    // Give PAGEL a positive pulse. This latches the data bytes.
+    PAGEL_POSITIVE_PULSE();
+    HAL_CONTROL_CLEAR(PD_BS1_bm);
+    STATS_STOP(STATS_BUS_LATCH);
 }
 
 uint8_t read_data(void) {
-    PORTA.DIRCLR = 0xFF;
+    STATS_START();
+    HAL_DATA_INPUT();
     // Set OE to “0”. The <data> byte can now be read at DATA.
-    PORTD.OUTSET = PD_OE_bm; // INVEN is enabled on this output
-    _delay_us(1);
-    uint8_t data = PORTA.IN;
-    PORTD.OUTCLR = PD_OE_bm;
+    HAL_CONTROL_SET(PD_OE_bm); // INVEN is enabled on this output
+    WAIT_READ_NS(T_MAX(T_OLDV_NS, T_BVDV_NS));
+    uint8_t data = HAL_DATA_READ();
+    HAL_CONTROL_CLEAR(PD_OE_bm);
+    // Target releases DATA before it can be driven again
+    WAIT_NS(T_OHDZ_NS);
+    STATS_STOP(STATS_BUS_READ);
     return data;
 }
 
 uint8_t read_byte(void) {
-    PORTA.DIRCLR = 0xFF;
+    STATS_START();
+    HAL_DATA_INPUT();
     // Set OE to “0”, and BS1 to “0”. The <data> byte can now be read at DATA.
-    PORTD.OUTCLR = PD_BS1_bm;
-    PORTD.OUTSET = PD_OE_bm; // INVEN is enabled on this output
-    _delay_us(1);
-    uint8_t data = PORTA.IN;
-    PORTD.OUTCLR = PD_OE_bm;
+    HAL_CONTROL_LOAD(PD_BS1_bm | PD_OE_bm, PD_OE_bm); // INVEN is enabled on OE
+    WAIT_READ_NS(T_MAX(T_OLDV_NS, T_BVDV_NS));
+    uint8_t data = HAL_DATA_READ();
+    HAL_CONTROL_CLEAR(PD_OE_bm);
+    // Target releases DATA before it can be driven again
+    WAIT_NS(T_OHDZ_NS);
+    STATS_STOP(STATS_BUS_READ);
     return data;
 }
 
 uint16_t read_word(void) {
-    PORTA.DIRCLR = 0xFF;
+    STATS_START();
+    HAL_DATA_INPUT();
     // Set OE to “0”, and BS1 to “0”. The <data> byte can now be read at DATA.
-    PORTD.OUTCLR = PD_BS1_bm;
-    PORTD.OUTSET = PD_OE_bm; // INVEN is enabled on this output
-    _delay_us(1);
-    uint8_t low = PORTA.IN;
-    PORTD.OUTSET = PD_BS1_bm;
-    uint8_t high = PORTA.IN;
-    PORTD.OUTCLR = PD_OE_bm | PD_BS1_bm;
+    HAL_CONTROL_LOAD(PD_BS1_bm | PD_OE_bm, PD_OE_bm); // INVEN is enabled on OE
+    WAIT_READ_NS(T_MAX(T_OLDV_NS, T_BVDV_NS));
+    uint8_t low = HAL_DATA_READ();
+    // Set BS1 to “1”. The high <data> byte can now be read at DATA.
+    HAL_CONTROL_SET(PD_BS1_bm);
+    WAIT_READ_NS(T_BVDV_NS);
+    uint8_t high = HAL_DATA_READ();
+    HAL_CONTROL_CLEAR(PD_OE_bm | PD_BS1_bm);
+    // Target releases DATA before it can be driven again
+    WAIT_NS(T_OHDZ_NS);
+    STATS_STOP(STATS_BUS_READ);
     return low | (high << 8);
-}
\ No newline at end of file
+}
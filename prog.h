@@ -6,46 +6,138 @@
 #ifndef PROG_H
 #define	PROG_H
 
-#include "config.h"
+#include "hal.h"
 #include "avr_database.h"
+#include "timing.h"
+#include "crc.h"
+#include "stats.h"
+
+/* 
+ * Bus signals are driven through VPORTs (see hal.h): single-bit changes 
+ * compile to single-cycle SBI/CBI, multi-bit control states are written with 
+ * a single OUT instruction.
+ */
 
 #define XTAL1_POSITIVE_PULSE() { \
-    PORTD.OUTSET = PD_XTAL1_bm; \
-    asm("nop"); \
-    PORTD.OUTCLR = PD_XTAL1_bm; \
-    asm("nop"); \
+    WAIT_NS(T_DVXH_NS); \
+    HAL_CONTROL_SET(PD_XTAL1_bm); \
+    WAIT_NS(T_XHXL_NS); \
+    HAL_CONTROL_CLEAR(PD_XTAL1_bm); \
+    WAIT_NS(T_MAX(T_XLDX_NS, T_XLXH_NS - T_DVXH_NS)); \
+}
+
+#define PAGEL_POSITIVE_PULSE() { \
+    WAIT_NS(T_BVPH_NS); \
+    HAL_CONTROL_SET(PD_PAGEL_bm); \
+    WAIT_NS(T_PHPL_NS); \
+    HAL_CONTROL_CLEAR(PD_PAGEL_bm); \
+    WAIT_NS(T_MAX(T_PLBX_NS, T_PLXH_NS)); \
 }
 
 #define WR_NEGATIVE_PULSE() { \
-    PORTD.OUTSET = PD_WR_bm; \
-    asm("nop"); \
-    PORTD.OUTCLR = PD_WR_bm; \
-    asm("nop"); \
+    WAIT_NS(T_BVWL_NS); \
+    HAL_CONTROL_SET(PD_WR_bm); \
+    WAIT_NS(T_WLWH_NS); \
+    HAL_CONTROL_CLEAR(PD_WR_bm); \
+    WAIT_NS(T_WLBX_NS); \
+}
+
+#define TARGET_READY() HAL_READY()
+
+/* XA1, XA0 and BS1 states for bus_load() */
+#define PD_LOAD_gm (PD_XA1_bm | PD_XA0_bm | PD_BS1_bm)
+#define PD_LOAD_ADDRESS_LOW 0
+#define PD_LOAD_ADDRESS_HIGH PD_BS1_bm
+#define PD_LOAD_DATA_LOW PD_XA0_bm
+#define PD_LOAD_DATA_HIGH (PD_XA0_bm | PD_BS1_bm)
+#define PD_LOAD_COMMAND PD_XA1_bm
+
+/**
+ * Sets XA1, XA0 and BS1 at once, drives DATA and gives XTAL1 a positive pulse.
+ */
+static inline void bus_load(const uint8_t state, const uint8_t data) {
+    STATS_START();
+    HAL_CONTROL_LOAD(PD_LOAD_gm, state);
+    HAL_DATA_OUTPUT(data);
+    XTAL1_POSITIVE_PULSE();
+    STATS_STOP(STATS_BUS_LOAD);
 }
 
 /**
- * https://stackoverflow.com/a/3208376
+ * Page fill hot loop step: loads address low byte and both data bytes, 
+ * then latches them into the page buffer. BS1 is already “1” after 
+ * loading the data high byte, as required for the PAGEL pulse.
  */
-#define BYTE_TO_BINARY_PATTERN "%c%c%c%c%c%c%c%c"
-#define BYTE_TO_BINARY(byte)  \
-  ((byte) & 0x80 ? '1' : '0'), \
-  ((byte) & 0x40 ? '1' : '0'), \
-  ((byte) & 0x20 ? '1' : '0'), \
-  ((byte) & 0x10 ? '1' : '0'), \
-  ((byte) & 0x08 ? '1' : '0'), \
-  ((byte) & 0x04 ? '1' : '0'), \
-  ((byte) & 0x02 ? '1' : '0'), \
-  ((byte) & 0x01 ? '1' : '0') 
+static inline void page_load_word(const uint8_t address_low, const uint16_t data) {
+    bus_load(PD_LOAD_ADDRESS_LOW, address_low);
+    bus_load(PD_LOAD_DATA_LOW, data & 0xFF);
+    bus_load(PD_LOAD_DATA_HIGH, data >> 8);
+    STATS_START();
+    PAGEL_POSITIVE_PULSE();
+    STATS_STOP(STATS_BUS_LATCH);
+}
 
+/* Page programming results */
+#define PROG_OK 0
+#define PROG_SKIPPED 1                  /* Page already holds the data */
+#define PROG_ERROR_NOT_ERASED -1        /* Page or lock bits need chip erase to be set */
+#define PROG_ERROR_TIMEOUT -4           /* RDY/BSY did not go high, below IMAGE_ERROR_* */
+#define PROG_ERROR_VERIFY -5            /* Fuse or lock bits read back differ */
+
+/* Kinds of writes, timed separately by target_wait() */
+#define WRITE_ERASE 0
+#define WRITE_FLASH 1
+#define WRITE_EEPROM 2
+#define WRITE_FUSE 3                    /* Fuse and lock bits */
+#define WRITE_KINDS 4
+
+/* Fuse and lock bytes, in read_fuse_and_lock_bits() order */
+#define FUSE_LOW 0
+#define FUSE_HIGH 1
+#define FUSE_EXTENDED 2
+#define FUSE_LOCK 3
+#define FUSE_BYTES 4
+#define FUSE_LOW_bm (1 << FUSE_LOW)
+#define FUSE_HIGH_bm (1 << FUSE_HIGH)
+#define FUSE_EXTENDED_bm (1 << FUSE_EXTENDED)
+#define FUSE_LOCK_bm (1 << FUSE_LOCK)
+
+/* Largest Flash page among supported devices */
+#define FLASH_PAGE_WORDS_MAX 128
 
 const avr_record* lookup_signature(const uint32_t signature);
 
 void read_signature(uint32_t* signature);
+uint8_t read_calibration_byte(void);
 void read_fuse_and_lock_bits(uint8_t* fuse_and_lock_bits, uint8_t read_extended);
-void erase_chip();
-void program_fuse_low_bits(const uint8_t bits);
-void program_fuse_high_bits(const uint8_t bits);
-void program_fuse_extended_bits(const uint8_t bits);
+int8_t erase_chip();
+int8_t program_fuse_low_bits(const uint8_t bits);
+int8_t program_fuse_high_bits(const uint8_t bits);
+int8_t program_fuse_extended_bits(const uint8_t bits);
+int8_t program_lock_bits(const uint8_t bits);
+int8_t program_fuse_and_lock_bits(uint8_t* bits, const uint8_t select, const uint8_t read_extended,
+        const uint8_t force);
+void read_flash(const uint16_t address, uint16_t* data);
+void read_flash_start(void);
+uint16_t read_flash_next(const uint16_t address);
+void read_eeprom_start(void);
+uint8_t read_eeprom_next(const uint16_t address);
+uint32_t read_flash_crc32(const uint32_t start, const uint32_t length);
+uint32_t read_eeprom_crc32(const uint16_t start, const uint16_t length);
+void set_flash_update_mode(const uint8_t enabled);
+uint8_t flash_page_blank(const uint16_t* data, const uint8_t page_words);
+int8_t program_flash_page(const uint16_t address, const uint16_t* data, const uint8_t page_words);
+int8_t program_flash_page_start(const uint16_t address, const uint16_t* data, const uint8_t page_words);
+int8_t program_flash_finish(void);
+int8_t program_flash(uint16_t address, const uint16_t* data, uint16_t words, const uint8_t page_words);
+int8_t program_eeprom_page(const uint16_t address, const uint8_t* data, const uint8_t page_size);
+int16_t program_eeprom(const uint16_t address, const uint8_t* data, const uint16_t length, 
+        const uint8_t page_size);
+
+uint8_t target_busy(void);
+int8_t target_wait(void);
+uint32_t target_write_time_us(const uint8_t kind);
+uint32_t target_timeout_us(const uint8_t kind);
 
 void enter_programming();
 void exit_programming();
@@ -57,6 +149,7 @@ void load_address_high_byte(const uint8_t address);
 void load_address_low_byte(const uint8_t address);
 void load_data_low_byte(const uint8_t data);
 void load_data_high_byte(const uint8_t data);
+void latch_data(void);
 uint8_t read_data(void);
 uint8_t read_byte(void);
 uint16_t read_word(void);
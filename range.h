@@ -0,0 +1,22 @@
+/* 
+ * File:   range.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Bounds check of address ranges given by the host, which may come with 
+ * any 32-bit start: start + length is never computed, so it cannot wrap
+ * back into the memory.
+ */
+
+#ifndef RANGE_H
+#define	RANGE_H
+
+#include <stdint.h>
+
+/**
+ * Nonzero when length bytes (or words) at start fit in size.
+ */
+static inline uint8_t range_fits(const uint32_t start, const uint32_t length, const uint32_t size) {
+    return (start <= size) && (length <= size - start);
+}
+
+#endif	/* RANGE_H */
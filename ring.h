@@ -0,0 +1,57 @@
+/* 
+ * File:   ring.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Single producer, single consumer byte ring buffer, safe to share between
+ * an ISR and the main loop without disabling interrupts: the producer only
+ * writes head, the consumer only writes tail, both are 8-bit.
+ * Storage size has to be a power of two, up to 256 bytes; one slot is 
+ * always kept free to tell full from empty.
+ * Kept free of any AVR headers, so it can be built for the host as well.
+ */
+
+#ifndef RING_H
+#define	RING_H
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    const uint8_t mask;
+    volatile uint8_t* const buffer;
+} ring_t;
+
+#define RING_INITIALIZER(storage) { 0, 0, sizeof(storage) - 1, storage }
+
+static inline uint8_t ring_count(const ring_t* ring) {
+    return (ring->head - ring->tail) & ring->mask;
+}
+
+static inline uint8_t ring_empty(const ring_t* ring) {
+    return ring->head == ring->tail;
+}
+
+static inline uint8_t ring_put(ring_t* ring, const uint8_t data) {
+    uint8_t head = ring->head;
+    uint8_t next = (head + 1) & ring->mask;
+    if (next == ring->tail) {
+        return 0;
+    }
+    ring->buffer[head] = data;
+    ring->head = next;
+    return 1;
+}
+
+static inline uint8_t ring_get(ring_t* ring, uint8_t* data) {
+    uint8_t tail = ring->tail;
+    if (tail == ring->head) {
+        return 0;
+    }
+    *data = ring->buffer[tail];
+    ring->tail = (tail + 1) & ring->mask;
+    return 1;
+}
+
+#endif	/* RING_H */
+
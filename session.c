@@ -0,0 +1,67 @@
+/*
+ * File:   session.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include "session.h"
+#include "prog.h"
+#include "gang.h"
+
+uint8_t session_mode = SESSION_OFF;
+const avr_record* session_record = NULL;
+
+/**
+ * Enters programming mode and looks the device up in the database.
+ * When the device is not recognized, target is brought back to the previous
+ * mode (running or power down).
+ * In gang mode the signature is read from the first target, other targets 
+ * take part only if theirs matches.
+ */
+int8_t session_enter(uint32_t* signature) {
+    if (session_mode == SESSION_PROGRAMMING) {
+        return SESSION_ERROR_STATE;
+    }
+    if (gang_targets) {
+        gang_restore();
+    }
+    enter_programming();
+    read_signature(signature);
+    session_record = lookup_signature(*signature);
+    if ((session_record != NULL) && gang_targets) {
+        gang_match(*signature);
+    }
+    if (session_record == NULL) {
+        exit_programming();
+        if (session_mode == SESSION_RUNNING) {
+            power_up();
+        }
+        return SESSION_ERROR_DEVICE;
+    }
+    session_mode = SESSION_PROGRAMMING;
+    return SESSION_OK;
+}
+
+int8_t session_exit(void) {
+    session_record = NULL;
+    if (session_mode == SESSION_OFF) {
+        return SESSION_ERROR_STATE;
+    } else if (session_mode == SESSION_RUNNING) {
+        power_down();
+    } else if (session_mode == SESSION_PROGRAMMING) {
+        exit_programming();
+    }
+    session_mode = SESSION_OFF;
+    return SESSION_OK;
+}
+
+int8_t session_run(void) {
+    session_record = NULL;
+    if (session_mode == SESSION_RUNNING) {
+        return SESSION_ERROR_STATE;
+    } else if (session_mode == SESSION_PROGRAMMING) {
+        exit_programming();
+    }
+    power_up();
+    session_mode = SESSION_RUNNING;
+    return SESSION_OK;
+}
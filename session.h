@@ -0,0 +1,31 @@
+/* 
+ * File:   session.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Target power/programming state shared by the text console and the binary
+ * protocol.
+ */
+
+#ifndef SESSION_H
+#define	SESSION_H
+
+#include "config.h"
+#include "avr_database.h"
+
+#define SESSION_OFF 0
+#define SESSION_RUNNING 1
+#define SESSION_PROGRAMMING 2
+
+#define SESSION_OK 0
+#define SESSION_ERROR_STATE -1          /* Already in / not in requested mode */
+#define SESSION_ERROR_DEVICE -2         /* Device not recognized */
+
+extern uint8_t session_mode;
+extern const avr_record* session_record;
+
+int8_t session_enter(uint32_t* signature);
+int8_t session_exit(void);
+int8_t session_run(void);
+
+#endif	/* SESSION_H */
+
@@ -0,0 +1,209 @@
+/*
+ * File:   standalone.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include "standalone.h"
+#include "prog.h"
+#include "session.h"
+#include "store.h"
+#include "gang.h"
+#include "fmt.h"
+#include "range.h"
+
+static uint16_t page[FLASH_PAGE_WORDS_MAX];
+
+/**
+ * Called from the main loop while there is no input from the host, takes
+ * about 1 ms. Starts standalone_run() once the button is held for 
+ * STANDALONE_DEBOUNCE_MS, then waits for it to be released.
+ */
+void standalone_poll(void) {
+    static uint8_t pressed_ms = 0;
+    if (!HAL_PROGRAM_PRESSED()) {
+        pressed_ms = 0;
+    } else if (pressed_ms < STANDALONE_DEBOUNCE_MS) {
+        pressed_ms++;
+    } else if (pressed_ms == STANDALONE_DEBOUNCE_MS) {
+        pressed_ms++;
+        standalone_run();
+    }
+    HAL_DELAY_MS(1);
+}
+
+static int8_t standalone_program(const store_header* header) {
+    const uint16_t page_bytes = 2 * header->page_words;
+    for (uint32_t offset = 0; offset < header->image_length; offset += page_bytes) {
+        uint16_t chunk = page_bytes;
+        if (header->image_length - offset < chunk) {
+            chunk = header->image_length - offset;
+            memset(page, 0xFF, page_bytes);
+        }
+        /* Target is still writing the previous page meanwhile */
+        if ((store_read(STORE_IMAGE_OFFSET + offset, (uint8_t*) page, chunk) < 0) ||
+            (program_flash_page_start(offset >> 1, page, header->page_words) < 0)) {
+            program_flash_finish();
+            return -1;
+        }
+    }
+    return (program_flash_finish() < 0) ? -1 : 0;
+}
+
+/**
+ * Stored fuse and lock bits, lock last. After chip erase the lock byte is
+ * unprogrammed, so a stored 0xFF costs no write.
+ */
+static int8_t standalone_fuse(const store_header* header) {
+    uint8_t bits[FUSE_BYTES] = { header->fuse_low, header->fuse_high, header->fuse_extended, header->lock };
+    uint8_t select = FUSE_LOW_bm | FUSE_HIGH_bm | FUSE_LOCK_bm;
+    if (session_record->flags & AVR_FLAG_FUSE_EXTENDED) {
+        select |= FUSE_EXTENDED_bm;
+    }
+    return (program_fuse_and_lock_bits(bits, select, select & FUSE_EXTENDED_bm, gang_targets != 0) < 0) ? 
+        -1 : 0;
+}
+
+/**
+ * Runs enter, erase, program, verify, fuse and exit steps, reporting progress 
+ * on the console. Any failure skips to exit.
+ * Returns 0 on success, -1 otherwise.
+ */
+int8_t standalone_run(void) {
+    store_header header;
+    uint8_t state = STANDALONE_ENTER;
+    int8_t result = 0;
+    uint32_t signature;
+    if (session_mode != SESSION_OFF) {
+        fmt_line("error", "Standalone mode requires target to be powered down");
+        return -1;
+    }
+    if (store_read_header(&header) < 0) {
+        fmt_line("error", "No valid image in store");
+        return -1;
+    }
+    if ((header.page_words == 0) || (header.page_words > FLASH_PAGE_WORDS_MAX)) {
+        fmt_line("error", "Invalid page size in store");
+        return -1;
+    }
+    while (state != STANDALONE_IDLE) {
+        switch (state) {
+            case STANDALONE_ENTER:
+                fmt_line("standalone", "Entering programming mode");
+                if ((session_enter(&signature) != SESSION_OK) || (signature != header.signature)) {
+                    fmt_tag("error");
+                    fmt_str("Signature ");
+                    fmt_hex(signature, 6);
+                    fmt_str(", expected ");
+                    fmt_hex(header.signature, 6);
+                    fmt_end();
+                    result = -1;
+                    state = (session_mode == SESSION_PROGRAMMING) ? STANDALONE_EXIT : STANDALONE_IDLE;
+                } else if ((header.page_words != session_record->flash_page_words) ||
+                    (header.image_length > AVR_FLASH_SIZE(session_record))) {
+                    fmt_line("error", "Image does not match device Flash geometry");
+                    result = -1;
+                    state = STANDALONE_EXIT;
+                } else {
+                    if (gang_targets) {
+                        fmt_tag("standalone");
+                        fmt_str("Targets ");
+                        fmt_hex(gang_targets, 2);
+                        fmt_end();
+                    }
+                    state = STANDALONE_ERASE;
+                }
+                break;
+            case STANDALONE_ERASE:
+                fmt_line("standalone", "Erasing");
+                if (erase_chip() < 0) {
+                    fmt_line("error", "Target does not respond (RDY/BSY timeout)");
+                    result = -1;
+                    state = STANDALONE_EXIT;
+                } else {
+                    state = STANDALONE_PROGRAM;
+                }
+                break;
+            case STANDALONE_PROGRAM:
+                fmt_tag("standalone");
+                fmt_str("Programming ");
+                fmt_dec(header.image_length, 0);
+                fmt_str(" bytes");
+                fmt_end();
+                if (standalone_program(&header) < 0) {
+                    fmt_line("error", "Programming failed");
+                    result = -1;
+                    state = STANDALONE_EXIT;
+                } else {
+                    state = STANDALONE_VERIFY;
+                }
+                break;
+            case STANDALONE_VERIFY:
+                fmt_line("standalone", "Verifying");
+                if (gang_targets) {
+                    uint8_t failed = gang_targets & 
+                        ~gang_verify_flash(0, header.image_length, header.image_crc);
+                    if (failed) {
+                        fmt_tag("error");
+                        fmt_str("Verification failed on targets ");
+                        fmt_hex(failed, 2);
+                        fmt_end();
+                        result = -1;
+                        gang_targets &= ~failed;
+                        gang_write_select(gang_targets);
+                    }
+                    state = gang_targets ? STANDALONE_FUSE : STANDALONE_EXIT;
+                } else if (read_flash_crc32(0, header.image_length) != header.image_crc) {
+                    fmt_line("error", "Verification failed");
+                    result = -1;
+                    state = STANDALONE_EXIT;
+                } else {
+                    state = STANDALONE_FUSE;
+                }
+                break;
+            case STANDALONE_FUSE:
+                if (header.flags & STORE_FLAG_FUSES) {
+                    fmt_line("standalone", "Programming fuse and lock bits");
+                    if (standalone_fuse(&header) < 0) {
+                        fmt_line("error", "Fuse programming failed");
+                        result = -1;
+                    }
+                }
+                state = STANDALONE_EXIT;
+                break;
+            case STANDALONE_EXIT:
+                session_exit();
+                state = STANDALONE_IDLE;
+                break;
+        }
+    }
+    if (result == 0) {
+        fmt_line("ok", "Standalone programming done");
+    }
+    return result;
+}
+
+static int8_t standalone_read(const uint32_t offset, uint8_t* data, const uint16_t length) {
+    if (!range_fits(offset, length, STORE_IMAGE_MAX)) {
+        return -1;
+    }
+    return store_read(STORE_IMAGE_OFFSET + offset, data, length);
+}
+
+/**
+ * Runs the job script held in the store, with the target powered down. 
+ * Returns 0 when the job was run (its result is in status), 
+ * STANDALONE_ERROR_JOB or STANDALONE_ERROR_STATE.
+ */
+int8_t standalone_job(job_status* status) {
+    uint8_t job[JOB_SIZE_MAX];
+    if ((session_mode != SESSION_OFF) || gang_targets) {
+        return STANDALONE_ERROR_STATE;
+    }
+    int16_t length = store_read_job(job);
+    if (length <= 0) {
+        return STANDALONE_ERROR_JOB;
+    }
+    job_execute(job, length, standalone_read, status);
+    session_mode = (status->target == JOB_TARGET_RUNNING) ? SESSION_RUNNING : SESSION_OFF;
+    return 0;
+}
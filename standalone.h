@@ -0,0 +1,36 @@
+/* 
+ * File:   standalone.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Standalone production mode: each press of the ~{PROGRAM} button programs
+ * the target from the image store, without a host. The job script held in 
+ * the store runs the same way on a single command.
+ */
+
+#ifndef STANDALONE_H
+#define	STANDALONE_H
+
+#include "config.h"
+#include "job.h"
+
+/* Button has to be held this long to start */
+#define STANDALONE_DEBOUNCE_MS 20
+
+#define STANDALONE_IDLE 0
+#define STANDALONE_ENTER 1
+#define STANDALONE_ERASE 2
+#define STANDALONE_PROGRAM 3
+#define STANDALONE_VERIFY 4
+#define STANDALONE_FUSE 5
+#define STANDALONE_EXIT 6
+
+/* standalone_job() results besides 0 */
+#define STANDALONE_ERROR_JOB -1         /* No valid job in store */
+#define STANDALONE_ERROR_STATE -2       /* Target not powered down, or gang mode */
+
+void standalone_poll(void);
+int8_t standalone_run(void);
+int8_t standalone_job(job_status* status);
+
+#endif	/* STANDALONE_H */
+
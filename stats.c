@@ -0,0 +1,68 @@
+/*
+ * File:   stats.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include "config.h"
+#include "stats.h"
+
+#if STATS_ENABLED
+
+stats_counter stats[STATS_COUNTERS];
+
+const char* const stats_names[STATS_COUNTERS] = {
+    "bus load", "bus latch", "bus write", "bus read", "target busy", "uart tx", "uart rx"
+};
+
+/* Upper half of the cycle count, TCB0 holds the lower one */
+static volatile uint16_t stats_overflows = 0;
+static uint32_t stats_since = 0;
+
+ISR(TCB0_INT_vect) {
+    stats_overflows++;
+    TCB0.INTFLAGS = TCB_CAPT_bm;
+}
+
+/** TCB0                    Cycle counter
+ * - Periodic Interrupt mode, TOP 0xFFFF, clocked by CLK_PER
+ * - Interrupt on wrap extends the count to 32 bits
+ */
+void stats_init(void) {
+    TCB0.CCMP = 0xFFFF;
+    TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+    TCB0.INTCTRL = TCB_CAPT_bm;
+    TCB0.CTRLA = TCB_CLKSEL_DIV1_gc | TCB_ENABLE_bm;
+    stats_reset();
+}
+
+/**
+ * Clears all counters and starts a new measurement window.
+ */
+void stats_reset(void) {
+    memset(stats, 0, sizeof(stats));
+    stats_since = stats_now();
+}
+
+/**
+ * CPU cycles since stats_init(), wrapping.
+ */
+uint32_t stats_now(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t low = TCB0.CNT;
+    uint16_t high = stats_overflows;
+    if ((TCB0.INTFLAGS & TCB_CAPT_bm) && (low < 0x8000)) {
+        high++; // Wrapped, interrupt is still pending
+    }
+    SREG = sreg;
+    return ((uint32_t) high << 16) | low;
+}
+
+/**
+ * CPU cycles since stats_reset().
+ */
+uint32_t stats_window(void) {
+    return stats_now() - stats_since;
+}
+
+#endif
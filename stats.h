@@ -0,0 +1,64 @@
+/*
+ * File:   stats.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * Optional bus and link instrumentation. TCB0 counts CPU cycles, every
+ * instrumented operation adds one to its counter and the cycles it took,
+ * so a programming run shows whether it is bound by the link, the bus or
+ * the target being busy. With STATS_ENABLED 0 (see config.h) all of it
+ * compiles to nothing.
+ *
+ * Cycle totals wrap after 2^32 cycles (179 s at 24 MHz), reset the counters
+ * before the measured run.
+ */
+
+#ifndef STATS_H
+#define	STATS_H
+
+#if STATS_ENABLED
+
+#define STATS_BUS_LOAD 0                /* XTAL1 loads of command, address, data */
+#define STATS_BUS_LATCH 1               /* PAGEL page buffer latches */
+#define STATS_BUS_WRITE 2               /* WR pulses */
+#define STATS_BUS_READ 3                /* OE reads */
+#define STATS_TARGET_BUSY 4             /* Waiting for RDY/BSY */
+#define STATS_UART_TX 5                 /* Waiting for room in the TX ring buffer */
+#define STATS_UART_RX 6                 /* Waiting for data from the host */
+#define STATS_COUNTERS 7
+
+typedef struct {
+    uint32_t count;
+    uint32_t cycles;
+} stats_counter;
+
+extern stats_counter stats[STATS_COUNTERS];
+extern const char* const stats_names[STATS_COUNTERS];
+
+void stats_init(void);
+void stats_reset(void);
+uint32_t stats_now(void);
+uint32_t stats_window(void);
+
+static inline void stats_add(const uint8_t counter, const uint32_t cycles) {
+    stats[counter].count++;
+    stats[counter].cycles += cycles;
+}
+
+/* Operations shorter than one TCB0 period (2.7 ms at 24 MHz) */
+#define STATS_START() const uint16_t stats_start = TCB0.CNT
+#define STATS_STOP(counter) stats_add((counter), (uint16_t) (TCB0.CNT - stats_start))
+
+/* Waits of any length */
+#define STATS_WAIT_START() const uint32_t stats_wait_start = stats_now()
+#define STATS_WAIT_STOP(counter) stats_add((counter), stats_now() - stats_wait_start)
+
+#else
+
+#define STATS_START()
+#define STATS_STOP(counter)
+#define STATS_WAIT_START()
+#define STATS_WAIT_STOP(counter)
+
+#endif
+
+#endif	/* STATS_H */
@@ -0,0 +1,348 @@
+/*
+ * File:   stk500.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * STK500v2 high-voltage parallel programming, see stk500.h. Commands are
+ * mapped onto session.c and prog.c; timing parameters sent by the host
+ * (delays, pulse widths, control stack) are accepted and ignored, as the
+ * bus follows the datasheet timing of timing.h anyway.
+ */
+
+#include "stk500.h"
+#include "prog.h"
+#include "session.h"
+#include "gang.h"
+#include "range.h"
+
+/* Text typed outside a message which returns to the console */
+#define STK500_LEAVE "mode text"
+
+static uint8_t body[STK500_BODY_MAX];
+static uint8_t sequence;
+static uint16_t size;
+static uint32_t address;
+static uint16_t page[FLASH_PAGE_WORDS_MAX];
+
+static uint8_t params[STK500_PARAMS];
+
+static uint16_t get16(const uint8_t* data) {
+    return ((uint16_t) data[0] << 8) | data[1];
+}
+
+static void answer(const uint16_t length) {
+    uint8_t header[5] = { STK500_MESSAGE_START, sequence, length >> 8, length & 0xFF, STK500_TOKEN };
+    uint8_t checksum = 0;
+    for (uint8_t i = 0; i < sizeof(header); i++) {
+        usart1_write(header[i]);
+        checksum ^= header[i];
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        usart1_write(body[i]);
+        checksum ^= body[i];
+    }
+    usart1_write(checksum);
+}
+
+/**
+ * Answer without data to the command in body[0].
+ */
+static uint16_t status(const uint8_t code) {
+    body[1] = code;
+    return 2;
+}
+
+/**
+ * Status of a failed programming function.
+ */
+static uint16_t failure(const int8_t result) {
+    return status((result == PROG_ERROR_TIMEOUT) ? STK500_STATUS_RDY_BSY_TOUT : STK500_STATUS_CMD_FAILED);
+}
+
+/**
+ * Answer with one byte of data.
+ */
+static uint16_t value(const uint8_t data) {
+    body[1] = STK500_STATUS_CMD_OK;
+    body[2] = data;
+    return 3;
+}
+
+static uint8_t read_extended(void) {
+    return (session_record->flags & AVR_FLAG_SUPPORTED) ? (session_record->flags & AVR_FLAG_FUSE_EXTENDED) : 1;
+}
+
+static uint16_t cmd_sign_on(void) {
+    body[1] = STK500_STATUS_CMD_OK;
+    body[2] = 8;
+    memcpy(body + 3, "STK500_2", 8);
+    return 11;
+}
+
+static uint16_t cmd_parameter(void) {
+    const uint8_t index = body[1] - STK500_PARAM_FIRST;
+    if ((size < ((body[0] == STK500_CMD_SET_PARAMETER) ? 3 : 2)) || (index >= STK500_PARAMS)) {
+        return status(STK500_STATUS_CMD_FAILED);
+    }
+    if (body[0] == STK500_CMD_SET_PARAMETER) {
+        params[index] = body[2];
+        return status(STK500_STATUS_CMD_OK);
+    }
+    return value(params[index]);
+}
+
+static uint16_t cmd_enter(void) {
+    uint32_t signature;
+    if (session_enter(&signature) == SESSION_ERROR_DEVICE) {
+        return status(STK500_STATUS_CMD_FAILED);
+    }
+    return status(STK500_STATUS_CMD_OK);  /* Also when already entered */
+}
+
+/**
+ * Whole pages from a page boundary, the last one padded with 0xFF. Each
+ * page is answered without waiting for its write, so the next one is
+ * transferred meanwhile; any other command finishes page programming.
+ * Only page mode with the write page bit is supported: word mode, or a
+ * page loaded without being written, fails.
+ */
+static uint16_t cmd_program_flash(void) {
+    const uint16_t length = get16(body + 1);
+    const uint8_t* data = body + 5;
+    const uint8_t page_words = session_record->flash_page_words;
+    if ((length > STK500_BLOCK_MAX) || (size < 5 + length) || 
+        ((body[3] & (STK500_MODE_PAGE_bm | STK500_MODE_WRITE_bm)) != (STK500_MODE_PAGE_bm | STK500_MODE_WRITE_bm)) ||
+        (address % page_words) || !range_fits(address, (length + 1) / 2, AVR_FLASH_WORDS(session_record))) {
+        return status(STK500_STATUS_CMD_FAILED);
+    }
+    for (uint16_t offset = 0; offset < length; offset += 2 * page_words) {
+        for (uint8_t i = 0; i < page_words; i++) {
+            uint16_t byte = offset + 2 * i;
+            page[i] = ((byte < length) ? data[byte] : 0xFF) |
+                ((uint16_t) ((byte + 1 < length) ? data[byte + 1] : 0xFF) << 8);
+        }
+        int8_t result = program_flash_page_start(address, page, page_words);
+        if (result < 0) {
+            return failure(result);
+        }
+        address += page_words;
+    }
+    return status(STK500_STATUS_CMD_OK);
+}
+
+/**
+ * Unchanged EEPROM pages are not rewritten.
+ */
+static uint16_t cmd_program_eeprom(void) {
+    const uint16_t length = get16(body + 1);
+    if (gang_targets) {
+        return status(STK500_STATUS_CMD_FAILED);    /* EEPROM contents differ between targets */
+    }
+    if ((length > STK500_BLOCK_MAX) || (size < 5 + length) ||
+        !range_fits(address, length, session_record->eeprom_size)) {
+        return status(STK500_STATUS_CMD_FAILED);
+    }
+    int16_t written = program_eeprom(address, body + 5, length, session_record->eeprom_page_size);
+    if (written < 0) {
+        return failure(written);
+    }
+    address += length;
+    return status(STK500_STATUS_CMD_OK);
+}
+
+/**
+ * Answer is the data between two STK500_STATUS_CMD_OK.
+ */
+static uint16_t cmd_read(const uint8_t flash) {
+    const uint16_t length = get16(body + 1);
+    uint16_t word = 0;
+    if ((length > STK500_BLOCK_MAX) || (flash ?
+        !range_fits(address, (length + 1) / 2, AVR_FLASH_WORDS(session_record)) :
+        !range_fits(address, length, session_record->eeprom_size))) {
+        return status(STK500_STATUS_CMD_FAILED);
+    }
+    if (flash) {
+        read_flash_start();
+        for (uint16_t i = 0; i < length; i++) {
+            if (!(i & 1)) {
+                word = read_flash_next(address + i / 2);
+            }
+            body[2 + i] = (i & 1) ? (word >> 8) : (word & 0xFF);
+        }
+        address += (length + 1) / 2;
+    } else {
+        read_eeprom_start();
+        for (uint16_t i = 0; i < length; i++) {
+            body[2 + i] = read_eeprom_next(address + i);
+        }
+        address += length;
+    }
+    body[1] = STK500_STATUS_CMD_OK;
+    body[2 + length] = STK500_STATUS_CMD_OK;
+    return 3 + length;
+}
+
+/**
+ * Fuse (address 0 low, 1 high, 2 extended) or lock byte, written only when
+ * it differs; lock bits which need chip erase to be set fail.
+ */
+static uint16_t cmd_program_fuse(const uint8_t index) {
+    uint8_t bits[FUSE_BYTES];
+    if ((index >= FUSE_BYTES) || ((index == FUSE_EXTENDED) && !read_extended())) {
+        return status(STK500_STATUS_CMD_FAILED);
+    }
+    bits[index] = body[2];
+    int8_t result = program_fuse_and_lock_bits(bits, 1 << index, read_extended(), gang_targets != 0);
+    return (result < 0) ? failure(result) : status(STK500_STATUS_CMD_OK);
+}
+
+static uint16_t cmd_read_fuse(const uint8_t index) {
+    uint8_t bits[FUSE_BYTES];
+    if (index >= FUSE_BYTES) {
+        return status(STK500_STATUS_CMD_FAILED);
+    }
+    read_fuse_and_lock_bits(bits, read_extended());
+    return value(bits[index]);
+}
+
+/**
+ * Handles a complete message in body, returns the answer length.
+ */
+static uint16_t dispatch(void) {
+    const uint8_t command = body[0];
+    if ((command != STK500_CMD_PROGRAM_FLASH_PP) && (session_mode == SESSION_PROGRAMMING) &&
+        (program_flash_finish() < 0) && (command != STK500_CMD_LEAVE_PROGMODE_PP)) {
+        return status(STK500_STATUS_RDY_BSY_TOUT);  /* Last page of the previous command */
+    }
+    switch (command) {
+        case STK500_CMD_SIGN_ON:
+            return cmd_sign_on();
+        case STK500_CMD_SET_PARAMETER:
+        case STK500_CMD_GET_PARAMETER:
+            return cmd_parameter();
+        case STK500_CMD_LOAD_ADDRESS:
+            if (size < 5) {
+                return status(STK500_STATUS_CMD_FAILED);
+            }
+            /* Bit 31 requests extended addressing, implied by the address */
+            address = (((uint32_t) get16(body + 1) << 16) | get16(body + 3)) & 0x7FFFFFFFUL;
+            return status(STK500_STATUS_CMD_OK);
+        case STK500_CMD_SET_CONTROL_STACK:
+            return status(STK500_STATUS_CMD_OK);
+        case STK500_CMD_ENTER_PROGMODE_PP:
+            return cmd_enter();
+        case STK500_CMD_LEAVE_PROGMODE_PP:
+            session_exit();
+            return status(STK500_STATUS_CMD_OK);
+    }
+    if ((command < STK500_CMD_CHIP_ERASE_PP) || (command > STK500_CMD_READ_OSCCAL_PP)) {
+        return status(STK500_STATUS_CMD_UNKNOWN);
+    }
+    if (session_mode != SESSION_PROGRAMMING) {
+        return status(STK500_STATUS_CMD_FAILED);
+    }
+    switch (command) {
+        case STK500_CMD_CHIP_ERASE_PP:
+            return (erase_chip() < 0) ? status(STK500_STATUS_RDY_BSY_TOUT) : status(STK500_STATUS_CMD_OK);
+        case STK500_CMD_PROGRAM_FLASH_PP:
+            return cmd_program_flash();
+        case STK500_CMD_READ_FLASH_PP:
+            return cmd_read(1);
+        case STK500_CMD_PROGRAM_EEPROM_PP:
+            return cmd_program_eeprom();
+        case STK500_CMD_READ_EEPROM_PP:
+            return cmd_read(0);
+        case STK500_CMD_PROGRAM_FUSE_PP:
+            return cmd_program_fuse(body[1]);
+        case STK500_CMD_READ_FUSE_PP:
+            return cmd_read_fuse(body[1]);
+        case STK500_CMD_PROGRAM_LOCK_PP:
+            return cmd_program_fuse(FUSE_LOCK);
+        case STK500_CMD_READ_LOCK_PP:
+            return cmd_read_fuse(FUSE_LOCK);
+        case STK500_CMD_READ_SIGNATURE_PP:
+        {
+            uint32_t signature;
+            read_signature(&signature);
+            return value((body[1] < 3) ? (signature >> (16 - 8 * body[1])) : 0xFF);
+        }
+        case STK500_CMD_READ_OSCCAL_PP:
+            return value(read_calibration_byte());
+    }
+    return status(STK500_STATUS_CMD_UNKNOWN);
+}
+
+/**
+ * Runs the STK500v2 protocol until STK500_LEAVE followed by CR is typed
+ * between messages. A message which stalls for STK500_BYTE_TIMEOUT_MS is
+ * dropped, as on the STK500.
+ */
+void stk500_session(void) {
+    static const uint8_t defaults[][2] = {
+        { STK500_PARAM_HW_VER, 2 }, { STK500_PARAM_SW_MAJOR, 2 }, { STK500_PARAM_SW_MINOR, 10 },
+        { STK500_PARAM_VTARGET, 50 }, { STK500_PARAM_VADJUST, 50 },
+        { STK500_PARAM_TOPCARD_DETECT, 0xFF }, { STK500_PARAM_RESET_POLARITY, 1 }
+    };
+    uint8_t state = 0, checksum = 0;
+    uint16_t received = 0, last = HAL_CLOCK();
+    uint8_t text = 0;
+    memset(params, 0, sizeof(params));
+    for (uint8_t i = 0; i < sizeof(defaults) / sizeof(defaults[0]); i++) {
+        params[defaults[i][0] - STK500_PARAM_FIRST] = defaults[i][1];
+    }
+    while (1) {
+        uint8_t data = usart1_getc(NULL);
+        uint16_t now = HAL_CLOCK();
+        if ((uint16_t) (now - last) > (uint32_t) STK500_BYTE_TIMEOUT_MS * HAL_CLOCK_HZ / 1000) {
+            state = 0;
+        }
+        last = now;
+        checksum ^= data;
+        switch (state) {
+            case 0:                     /* Start, or text between messages */
+                if (data == STK500_MESSAGE_START) {
+                    checksum = data;
+                    state++;
+                    text = 0;
+                } else if (data == '\r') {
+                    if (text == sizeof(STK500_LEAVE) - 1) {
+                        return;
+                    }
+                    text = 0;
+                } else {
+                    text = ((text < sizeof(STK500_LEAVE) - 1) && (data == STK500_LEAVE[text])) ? text + 1 : 0;
+                }
+                break;
+            case 1:
+                sequence = data;
+                state++;
+                break;
+            case 2:
+                size = (uint16_t) data << 8;
+                state++;
+                break;
+            case 3:
+                size |= data;
+                state = ((size == 0) || (size > STK500_BODY_MAX)) ? 0 : state + 1;
+                break;
+            case 4:
+                received = 0;
+                state = (data == STK500_TOKEN) ? state + 1 : 0;
+                break;
+            case 5:
+                body[received++] = data;
+                if (received == size) {
+                    state++;
+                }
+                break;
+            case 6:
+                state = 0;
+                if (checksum != 0) {
+                    body[0] = STK500_ANSWER_CKSUM_ERROR;
+                    answer(status(STK500_STATUS_CKSUM_ERROR));
+                } else {
+                    answer(dispatch());
+                }
+                break;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * File:   stk500.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ *
+ * STK500v2 protocol (Atmel AVR068), high-voltage parallel programming
+ * commands only, so the programmer works with avrdude -c stk500pp.
+ *
+ * Message layout (size is big endian):
+ *   STK500_MESSAGE_START | sequence | size (2) | STK500_TOKEN | body (size) | checksum
+ * The checksum is XOR of all preceding bytes. The body starts with the
+ * command, an answer repeats it followed by a STK500_STATUS_* code.
+ * Addresses set by STK500_CMD_LOAD_ADDRESS are in words for Flash and in
+ * bytes for EEPROM, and advance with every read or write.
+ */
+
+#ifndef STK500_H
+#define	STK500_H
+
+#include "config.h"
+
+#define STK500_MESSAGE_START 0x1B
+#define STK500_TOKEN 0x0E
+
+/* Largest read or write block, avrdude sends at most 256 bytes */
+#define STK500_BLOCK_MAX 256
+/* Command, size (2), mode, poll timeout, data */
+#define STK500_BODY_MAX (5 + STK500_BLOCK_MAX)
+
+/* Between bytes of a message, a new one is expected after that */
+#define STK500_BYTE_TIMEOUT_MS 200
+
+#define STK500_CMD_SIGN_ON 0x01
+#define STK500_CMD_SET_PARAMETER 0x02
+#define STK500_CMD_GET_PARAMETER 0x03
+#define STK500_CMD_LOAD_ADDRESS 0x06
+#define STK500_CMD_ENTER_PROGMODE_PP 0x20
+#define STK500_CMD_LEAVE_PROGMODE_PP 0x21
+#define STK500_CMD_CHIP_ERASE_PP 0x22
+#define STK500_CMD_PROGRAM_FLASH_PP 0x23
+#define STK500_CMD_READ_FLASH_PP 0x24
+#define STK500_CMD_PROGRAM_EEPROM_PP 0x25
+#define STK500_CMD_READ_EEPROM_PP 0x26
+#define STK500_CMD_PROGRAM_FUSE_PP 0x27
+#define STK500_CMD_READ_FUSE_PP 0x28
+#define STK500_CMD_PROGRAM_LOCK_PP 0x29
+#define STK500_CMD_READ_LOCK_PP 0x2A
+#define STK500_CMD_READ_SIGNATURE_PP 0x2B
+#define STK500_CMD_READ_OSCCAL_PP 0x2C
+#define STK500_CMD_SET_CONTROL_STACK 0x2D
+
+#define STK500_ANSWER_CKSUM_ERROR 0xB0
+
+#define STK500_STATUS_CMD_OK 0x00
+#define STK500_STATUS_CMD_TOUT 0x80
+#define STK500_STATUS_RDY_BSY_TOUT 0x81
+#define STK500_STATUS_CMD_FAILED 0xC0
+#define STK500_STATUS_CKSUM_ERROR 0xC1
+#define STK500_STATUS_CMD_UNKNOWN 0xC9
+
+/* Parameters 0x80 - 0x9F, kept but without effect */
+#define STK500_PARAM_FIRST 0x80
+#define STK500_PARAMS 0x20
+#define STK500_PARAM_HW_VER 0x90
+#define STK500_PARAM_SW_MAJOR 0x91
+#define STK500_PARAM_SW_MINOR 0x92
+#define STK500_PARAM_VTARGET 0x94
+#define STK500_PARAM_VADJUST 0x95
+#define STK500_PARAM_TOPCARD_DETECT 0x9A
+#define STK500_PARAM_RESET_POLARITY 0x9E
+
+/* Mode byte of STK500_CMD_PROGRAM_*_PP */
+#define STK500_MODE_PAGE_bm 0x01
+#define STK500_MODE_WRITE_bm 0x80
+
+void stk500_session(void);
+
+#endif	/* STK500_H */
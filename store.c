@@ -0,0 +1,191 @@
+/*
+ * File:   store.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include "store.h"
+#include "twi.h"
+#include "crc.h"
+#include "range.h"
+
+void store_init(void) {
+    twi_init();
+}
+
+static uint8_t store_device(const uint32_t offset) {
+    return STORE_I2C_ADDRESS | ((offset & 0x10000UL) ? STORE_I2C_BLOCK_bm : 0);
+}
+
+/**
+ * Starts a write transaction and sends the 16-bit memory address.
+ */
+static int8_t store_address(const uint32_t offset) {
+    if (twi_start(store_device(offset), TWI_WRITE) < 0) {
+        return -1;
+    }
+    if ((twi_write(offset >> 8) < 0) || (twi_write(offset & 0xFF) < 0)) {
+        twi_stop();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Returns 0 on success, -1 on I2C error or out of range.
+ */
+int8_t store_read(uint32_t offset, uint8_t* data, uint16_t length) {
+    if (!range_fits(offset, length, STORE_SIZE)) {
+        return -1;
+    }
+    while (length > 0) {
+        /* Sequential read does not cross the 64 KB block boundary */
+        uint32_t block_left = 0x10000UL - (offset & 0xFFFF);
+        uint16_t chunk = (length < block_left) ? length : block_left;
+        if ((store_address(offset) < 0) || 
+            (twi_start(store_device(offset), TWI_READ) < 0)) {
+            return -1;
+        }
+        for (uint16_t i = 0; i < chunk; i++) {
+            data[i] = twi_read(i == chunk - 1);
+        }
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * Writes page by page, polling for the end of each write cycle.
+ * Returns 0 on success, -1 on I2C error, write timeout or out of range.
+ */
+int8_t store_write(uint32_t offset, const uint8_t* data, uint16_t length) {
+    if (!range_fits(offset, length, STORE_SIZE)) {
+        return -1;
+    }
+    while (length > 0) {
+        uint16_t page_left = STORE_PAGE_SIZE - (offset % STORE_PAGE_SIZE);
+        uint16_t chunk = (length < page_left) ? length : page_left;
+        if (store_address(offset) < 0) {
+            return -1;
+        }
+        for (uint16_t i = 0; i < chunk; i++) {
+            if (twi_write(data[i]) < 0) {
+                twi_stop();
+                return -1;
+            }
+        }
+        twi_stop();
+        /* Acknowledge polling, device NACKs its address while writing */
+        uint8_t ready = 0;
+        for (uint16_t i = 0; (i < STORE_WRITE_TIMEOUT_MS * 10) && !ready; i++) {
+            if (twi_start(store_device(offset), TWI_WRITE) == 0) {
+                twi_stop();
+                ready = 1;
+            } else {
+                _delay_us(100);
+            }
+        }
+        if (!ready) {
+            return -1;
+        }
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * CRC-32 of the first length bytes of the stored image.
+ */
+int8_t store_image_crc32(const uint32_t length, uint32_t* crc) {
+    uint8_t buffer[32];
+    uint32_t value = CRC32_INIT;
+    for (uint32_t offset = 0; offset < length; offset += sizeof(buffer)) {
+        uint16_t chunk = ((length - offset) < sizeof(buffer)) ? (length - offset) : sizeof(buffer);
+        if (store_read(STORE_IMAGE_OFFSET + offset, buffer, chunk) < 0) {
+            return -1;
+        }
+        for (uint16_t i = 0; i < chunk; i++) {
+            value = crc32_update(value, buffer[i]);
+        }
+    }
+    *crc = CRC32_FINAL(value);
+    return 0;
+}
+
+static uint16_t store_header_crc(const store_header* header) {
+    const uint8_t* data = (const uint8_t*) header;
+    uint16_t crc = CRC16_INIT;
+    for (uint8_t i = 0; i < offsetof(store_header, header_crc); i++) {
+        crc = crc16_update(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+ * Returns 0 when a valid header was read, -1 on I2C error or empty store.
+ */
+int8_t store_read_header(store_header* header) {
+    if (store_read(0, (uint8_t*) header, sizeof(store_header)) < 0) {
+        return -1;
+    }
+    if ((header->magic != STORE_MAGIC) || 
+        (header->header_crc != store_header_crc(header)) ||
+        (header->image_length > STORE_IMAGE_MAX)) {
+        return -1;
+    }
+    return 0;
+}
+
+int8_t store_write_header(store_header* header) {
+    header->magic = STORE_MAGIC;
+    header->header_crc = store_header_crc(header);
+    return store_write(0, (const uint8_t*) header, sizeof(store_header));
+}
+
+static uint16_t store_job_crc(const uint8_t* job, const uint16_t length) {
+    uint16_t crc = CRC16_INIT;
+    for (uint16_t i = 0; i < length; i++) {
+        crc = crc16_update(crc, job[i]);
+    }
+    return crc;
+}
+
+/**
+ * Reads the job script into job (STORE_JOB_SIZE - 4 bytes), returns its 
+ * length, or -1 on I2C error or when no valid job is stored.
+ */
+int16_t store_read_job(uint8_t* job) {
+    uint8_t head[4];
+    if (store_read(STORE_JOB_OFFSET, head, sizeof(head)) < 0) {
+        return -1;
+    }
+    uint16_t length = head[0] | ((uint16_t) head[1] << 8);
+    if ((length > STORE_JOB_SIZE - sizeof(head)) ||
+        (store_read(STORE_JOB_OFFSET + sizeof(head), job, length) < 0) ||
+        (store_job_crc(job, length) != (head[2] | ((uint16_t) head[3] << 8)))) {
+        return -1;
+    }
+    return length;
+}
+
+/**
+ * Replaces the job script, length 0 clears it.
+ */
+int8_t store_write_job(const uint8_t* job, const uint16_t length) {
+    uint8_t head[4];
+    uint16_t crc = store_job_crc(job, length);
+    if (length > STORE_JOB_SIZE - sizeof(head)) {
+        return -1;
+    }
+    head[0] = length;
+    head[1] = length >> 8;
+    head[2] = crc;
+    head[3] = crc >> 8;
+    if (store_write(STORE_JOB_OFFSET + sizeof(head), job, length) < 0) {
+        return -1;
+    }
+    return store_write(STORE_JOB_OFFSET, head, sizeof(head));
+}
@@ -0,0 +1,55 @@
+/* 
+ * File:   store.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Standalone image store in an external 24xx1025 I2C EEPROM (128 KB), 
+ * holding one Flash image, the target settings and a job script.
+ */
+
+#ifndef STORE_H
+#define	STORE_H
+
+#include "config.h"
+
+/* 24xx1025, A1 = A0 = 0; block select bit selects upper 64 KB */
+#define STORE_I2C_ADDRESS 0x50
+#define STORE_I2C_BLOCK_bm 0x04
+#define STORE_PAGE_SIZE 128
+#define STORE_SIZE 131072UL
+/* Write cycle time is 5 ms maximum */
+#define STORE_WRITE_TIMEOUT_MS 10
+
+#define STORE_MAGIC 0x31534345UL        /* "ECS1" */
+#define STORE_IMAGE_OFFSET STORE_PAGE_SIZE
+/* Job script (job.h) in the last two pages: length (2), CRC-16 (2), steps */
+#define STORE_JOB_SIZE (2 * STORE_PAGE_SIZE)
+#define STORE_JOB_OFFSET (STORE_SIZE - STORE_JOB_SIZE)
+#define STORE_IMAGE_MAX (STORE_JOB_OFFSET - STORE_IMAGE_OFFSET)
+
+#define STORE_FLAG_FUSES (1 << 0)       /* Program fuse and lock bits after the image */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t signature;                 /* Expected target signature */
+    uint32_t image_length;              /* Flash image length in bytes */
+    uint32_t image_crc;                 /* CRC-32 of the Flash image */
+    uint8_t page_words;                 /* Target Flash page size */
+    uint8_t flags;
+    uint8_t fuse_low;
+    uint8_t fuse_high;
+    uint8_t fuse_extended;
+    uint8_t lock;
+    uint16_t header_crc;                /* CRC-16 of all fields above */
+} store_header;
+
+void store_init(void);
+int8_t store_read(uint32_t offset, uint8_t* data, uint16_t length);
+int8_t store_write(uint32_t offset, const uint8_t* data, uint16_t length);
+int8_t store_image_crc32(const uint32_t length, uint32_t* crc);
+int8_t store_read_header(store_header* header);
+int8_t store_write_header(store_header* header);
+int16_t store_read_job(uint8_t* job);
+int8_t store_write_job(const uint8_t* job, const uint16_t length);
+
+#endif	/* STORE_H */
+
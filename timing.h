@@ -0,0 +1,61 @@
+/* 
+ * File:   timing.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ * 
+ * Parallel programming bus timing, converted to CPU cycles at compile time.
+ * Values are minima from "Parallel Programming Characteristics" of the 
+ * supported ATmega datasheets (identical across the family), in ns.
+ */
+
+#ifndef TIMING_H
+#define	TIMING_H
+
+#define T_DVXH_NS 67    /* Data and Control Valid before XTAL1 High */
+#define T_XLXH_NS 200   /* XTAL1 Low to XTAL1 High */
+#define T_XHXL_NS 150   /* XTAL1 Pulse Width High */
+#define T_XLDX_NS 67    /* Data and Control Hold after XTAL1 Low */
+#define T_BVPH_NS 67    /* BS1 Valid before PAGEL High */
+#define T_PHPL_NS 150   /* PAGEL Pulse Width High */
+#define T_PLBX_NS 67    /* BS1 Hold after PAGEL Low */
+#define T_PLXH_NS 150   /* PAGEL Low to XTAL1 High */
+#define T_BVWL_NS 67    /* BS1 Valid to WR Low */
+#define T_WLWH_NS 150   /* WR Pulse Width Low */
+#define T_WLBX_NS 67    /* BS2/1 Hold after WR Low */
+#define T_BVDV_NS 250   /* BS1 Valid to DATA valid (maximum) */
+#define T_OLDV_NS 250   /* OE Low to DATA Valid (maximum) */
+#define T_OHDZ_NS 250   /* OE High to DATA Tri-stated (maximum) */
+
+/* WR Low to RDY/BSY High, maximum, in us */
+#define T_WLRH_US 4500          /* Flash or EEPROM page, fuse and lock bits */
+#define T_WLRH_CE_US 9000       /* Chip Erase */
+
+/* 
+ * A write still busy after this many times its maximum duration is given up,
+ * the target is considered dead. Once a write of the same kind has been 
+ * measured, the timeout tightens to twice the longest measured duration 
+ * plus margin, so a target which stops responding is detected sooner.
+ */
+#define T_TIMEOUT_FACTOR 4
+#define T_TIMEOUT_MARGIN_US 1000
+
+/* Input synchronizer delay of PORTx.IN, in cycles */
+#define T_SYNC_CYCLES 2
+
+/* At least one cycle passes between two consecutive port writes */
+#define T_WRITE_CYCLES 1
+
+#define T_MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+/* Rounded up, so the result is never shorter than requested */
+#define NS_TO_CYCLES(ns) ((((uint32_t) (ns) * (F_CPU / 1000000UL)) + 999) / 1000)
+
+/* Cycles to burn on top of the port write itself */
+#define WAIT_CYCLES(ns) T_MAX((int32_t) NS_TO_CYCLES(ns) - T_WRITE_CYCLES, 0)
+
+#define WAIT_NS(ns) HAL_DELAY_CYCLES(WAIT_CYCLES(ns))
+
+/* Reads wait for the data to settle and to pass the input synchronizer */
+#define WAIT_READ_NS(ns) HAL_DELAY_CYCLES(NS_TO_CYCLES(ns) + T_SYNC_CYCLES)
+
+#endif	/* TIMING_H */
+
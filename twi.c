@@ -0,0 +1,69 @@
+/*
+ * File:   twi.c
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#include "twi.h"
+
+/** TWI0                    I2C host on PORTC (SDA PC2, SCL PC3)
+ * - Standard/Fast mode, TWI0_FREQUENCY
+ * - Smart mode disabled, no interrupts, blocking transfers
+ */
+void twi_init(void) {
+    PORTMUX.TWIROUTEA = PORTMUX_TWI0_ALT2_gc;
+    /* f_SCL = F_CPU / (10 + 2 * BAUD), rise time neglected */
+    TWI0.MBAUD = (F_CPU / (2 * TWI0_FREQUENCY)) - 5;
+    TWI0.MCTRLA = TWI_ENABLE_bm;
+    TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;
+}
+
+/**
+ * Sends (repeated) START and 7-bit address with direction bit.
+ * Returns 0 when acknowledged, -1 on NACK or bus error (STOP is issued).
+ */
+int8_t twi_start(const uint8_t address, const uint8_t direction) {
+    TWI0.MADDR = (address << 1) | direction;
+    while (!(TWI0.MSTATUS & (TWI_WIF_bm | TWI_RIF_bm)));
+    if (TWI0.MSTATUS & (TWI_ARBLOST_bm | TWI_BUSERR_bm)) {
+        TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;
+        return -1;
+    }
+    /* Address NACK sets WIF in both directions */
+    if ((TWI0.MSTATUS & TWI_WIF_bm) && (TWI0.MSTATUS & TWI_RXACK_bm)) {
+        twi_stop();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Returns 0 when acknowledged, -1 otherwise.
+ */
+int8_t twi_write(const uint8_t data) {
+    TWI0.MDATA = data;
+    while (!(TWI0.MSTATUS & TWI_WIF_bm));
+    if (TWI0.MSTATUS & (TWI_ARBLOST_bm | TWI_BUSERR_bm | TWI_RXACK_bm)) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Reads a byte (the first one is received right after START with 
+ * TWI_READ), acknowledges it unless it is the last one, in which case
+ * NACK and STOP are sent.
+ */
+uint8_t twi_read(const uint8_t last) {
+    while (!(TWI0.MSTATUS & TWI_RIF_bm));
+    uint8_t data = TWI0.MDATA;
+    if (last) {
+        TWI0.MCTRLB = TWI_ACKACT_NACK_gc | TWI_MCMD_STOP_gc;
+    } else {
+        TWI0.MCTRLB = TWI_ACKACT_ACK_gc | TWI_MCMD_RECVTRANS_gc;
+    }
+    return data;
+}
+
+void twi_stop(void) {
+    TWI0.MCTRLB = TWI_MCMD_STOP_gc;
+}
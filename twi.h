@@ -0,0 +1,24 @@
+/* 
+ * File:   twi.h
+ * Author: Bartosz Derleta <bartosz@derleta.com>
+ */
+
+#ifndef TWI_H
+#define	TWI_H
+
+#include "config.h"
+
+/* I2C bus clock */
+#define TWI0_FREQUENCY 400000UL
+
+#define TWI_READ 1
+#define TWI_WRITE 0
+
+void twi_init(void);
+int8_t twi_start(const uint8_t address, const uint8_t direction);
+int8_t twi_write(const uint8_t data);
+uint8_t twi_read(const uint8_t last);
+void twi_stop(void);
+
+#endif	/* TWI_H */
+